@@ -1,11 +1,15 @@
+#pragma once
+
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <span>
+#include <type_traits>
 #include <utility>
 
-const size_t DEFAULT_SIZE_BLOCK = 10;
-const size_t DEFAULT_COUNT_BLOCKS = 5;
-
 class DequeIsEmptyException : std::exception {
 public:
     explicit DequeIsEmptyException(const std::string& text) : error_message_(text) {
@@ -19,9 +23,25 @@ private:
     std::string_view error_message_;
 };
 
-template <typename T, typename Alloc = std::allocator<T>>
+// Elements live in blocks of kBlockSize elements, about BlockBytes each, reached through a map of
+// block pointers. When a push runs off either end of the map, the used blocks are recentred if they
+// fill at most half of it and the map doubles otherwise, so PushBack and PushFront are amortized
+// O(1). Blocks are allocated when the first element goes into them, so map slots that were never
+// used stay null. Blocks emptied by pops are kept in a small spare cache and reused at either end:
+// a deque used as a queue of bounded length stops allocating once it has warmed up. ShrinkToFit()
+// gives the spare blocks back and cuts the map down to the used blocks.
+template <typename T, typename Alloc = std::allocator<T>, size_t BlockBytes = 4096>
 class Deque {
+public:
+    static constexpr size_t kBlockSize = BlockBytes / sizeof(T) > 1 ? BlockBytes / sizeof(T) : 1;
+
 private:
+    static constexpr size_t kInitialMapSize = 2;
+    static constexpr size_t kMaxSpareBlocks = 4;
+    // Shorter bulk copies of trivially copyable elements are plain loops: a library memcpy call
+    // costs more than it saves on a few elements
+    static constexpr size_t kMemcpyMinBytes = 256;
+
     template <typename U>
     struct Pair {
         size_t external = 0;
@@ -45,30 +65,31 @@ private:
         // NOLINTNEXTLINE
         using pointer_type = value_type*;
 
-        struct Index {
-            size_t start;
-            size_t finish;
-            explicit Index(const size_t& curr) : start(curr / DEFAULT_SIZE_BLOCK), finish(curr % DEFAULT_SIZE_BLOCK){};
-        };
-
         bool operator==(const DequeIterator& other) const {
-            return curr_ == other.curr_;
+            return block_ == other.block_ && offset_ == other.offset_;
         }
 
         bool operator!=(const DequeIterator& other) const {
-            return curr_ != other.curr_;
+            return !(*this == other);
         }
 
         bool operator<(const DequeIterator& other) const {
-            return other.curr_ - curr_ > 0;
+            return block_ < other.block_ || (block_ == other.block_ && offset_ < other.offset_);
         }
 
         bool operator>(const DequeIterator& other) const {
-            return other.curr_ < curr_;
+            return other < *this;
         }
         DequeIterator& operator+=(difference_type count) {
-            curr_ += count;
-            return curr_;
+            constexpr auto kStep = static_cast<difference_type>(kBlockSize);
+            difference_type offset = static_cast<difference_type>(offset_) + count;
+            if (offset < 0 || offset >= kStep) {
+                difference_type blocks = offset >= 0 ? offset / kStep : -((-offset - 1) / kStep) - 1;
+                block_ += blocks;
+                offset -= blocks * kStep;
+            }
+            offset_ = static_cast<size_t>(offset);
+            return *this;
         }
         DequeIterator operator+(difference_type count) {
             DequeIterator temp = *this;
@@ -84,8 +105,16 @@ private:
             return temp -= count;
         }
 
+        difference_type operator-(const DequeIterator& other) const {
+            return (block_ - other.block_) * static_cast<difference_type>(kBlockSize) +
+                   static_cast<difference_type>(offset_) - static_cast<difference_type>(other.offset_);
+        }
+
         DequeIterator& operator++() {
-            ++curr_;
+            if (++offset_ == kBlockSize) {
+                ++block_;
+                offset_ = 0;
+            }
             return *this;
         }
 
@@ -96,7 +125,11 @@ private:
         }
 
         DequeIterator& operator--() {
-            --curr_;
+            if (offset_ == 0) {
+                --block_;
+                offset_ = kBlockSize;
+            }
+            --offset_;
             return *this;
         }
 
@@ -107,78 +140,284 @@ private:
         }
 
         reference_type operator*() {
-            Index ind(curr_);
-            // std::cout << ind.start << "^^" << ind.finish << '\n';
-            // std::cout << "|" << curr_ / DEFAULT_SIZE_BLOCK << '|' << curr_ % DEFAULT_SIZE_BLOCK << '\n';
-            return arr_[ind.start][ind.finish];
+            return (*block_)[offset_];
         }
 
         pointer_type operator->() {
-            Index ind(curr_);
-            return arr_[ind.start][ind.finish];
+            return *block_ + offset_;
         }
 
     private:
-        explicit DequeIterator(T** arr, size_t curr) : arr_(arr), curr_(curr){};
+        // Points into the block map, so stepping needs no division. Invalidated by anything that
+        // moves the map: growth, recentring and ShrinkToFit
+        explicit DequeIterator(T** block, size_t offset) : block_(block), offset_(offset){};
 
     private:
-        T** arr_;
-        size_t curr_;
+        T** block_;
+        size_t offset_;  // < kBlockSize
     };
 
 private:
     T** external_arr_ = nullptr;
-    size_t size_ = 0;  // количество элементов в блоке
-    Pair<T> start_ = {0, 0};
-    Pair<T> end_ = {0, 0};
+    size_t size_ = 0;  // количество элементов
+    Pair<T> start_ = {0, 0};  // первый элемент
+    Pair<T> end_ = {0, 0};  // следующий за последним, end_.internal < kBlockSize
     size_t external_size_ = 0;  // размер внешнего массива
+    T* spare_[kMaxSpareBlocks] = {};  // опустевшие блоки для повторного использования
+    size_t spare_count_ = 0;
 
     using AllocTraits = std::allocator_traits<Alloc>;
     using PointerAlloc = typename AllocTraits::template rebind_alloc<T*>;
     using PointerAllocTraits = std::allocator_traits<PointerAlloc>;
 
     Alloc alloc_;
-    PointerAlloc external_alloc_;
+    PointerAlloc external_alloc_{alloc_};  // rebound from alloc_ in every constructor
 
-    void ResizeExternal(const size_t count) {
-        size_t offset = (count - external_size_) / 2;
-        size_t new_size = external_size_ + count;
-        T** new_external_arr = PointerAllocTraits::allocate(external_alloc_, new_size);
+    static size_t Offset(const Pair<T>& pos) {
+        return pos.external * kBlockSize + pos.internal;
+    }
+
+    // Slots [FirstBlock(), LastBlock()) hold the elements
+    size_t FirstBlock() const {
+        return start_.external;
+    }
+
+    size_t LastBlock() const {
+        return end_.external + (end_.internal != 0 ? 1 : 0);
+    }
+
+    static Pair<T> Position(size_t offset) {
+        return {offset / kBlockSize, offset % kBlockSize};
+    }
+
+    // Makes room for front_room blocks before the used ones and back_room after them: the used
+    // blocks are moved to the middle of the map, which doubles unless they fill at most half of
+    // it. Slots around them are left empty
+    void ResizeExternal(size_t front_room = 1, size_t back_room = 1) {
+        size_t first = FirstBlock();
+        size_t last = LastBlock();
+        size_t used = last - first;
+        size_t needed = used + front_room + back_room;
+        bool recentre = needed <= external_size_ && 2 * used < external_size_;
+        size_t new_size = recentre ? external_size_ : std::max(external_size_ * 2, needed);
+        T** new_external_arr =
+            recentre ? external_arr_ : PointerAllocTraits::allocate(external_alloc_, new_size);
 
         for (size_t i = 0; i < external_size_; ++i) {
-            new_external_arr[i + offset] = external_arr_[i];
+            if ((i < first || i >= last) && external_arr_[i] != nullptr) {
+                ReleaseBlock(i);
+            }
         }
+        size_t offset = front_room + (new_size - needed) / 2;
+        if (offset < first) {
+            std::copy(external_arr_ + first, external_arr_ + last, new_external_arr + offset);
+        } else {
+            std::copy_backward(external_arr_ + first, external_arr_ + last, new_external_arr + offset + used);
+        }
+        std::fill(new_external_arr, new_external_arr + offset, nullptr);
+        std::fill(new_external_arr + offset + used, new_external_arr + new_size, nullptr);
 
-        for (size_t i = 0; i < offset; ++i) {
-            new_external_arr[i] = AllocTraits::allocate(alloc_, DEFAULT_SIZE_BLOCK);
+        if (!recentre) {
+            PointerAllocTraits::deallocate(external_alloc_, external_arr_, external_size_);
+            external_arr_ = new_external_arr;
+            external_size_ = new_size;
         }
+        start_.external = start_.external - first + offset;
+        end_.external = end_.external - first + offset;
+    }
+
+    // A map of count empty slots
+    void AllocateExternal(const size_t count) {
+        external_arr_ = PointerAllocTraits::allocate(external_alloc_, count);
+        std::fill(external_arr_, external_arr_ + count, nullptr);
+        external_size_ = count;
+    }
 
-        for (size_t i = external_size_ + offset; i < new_size; ++i) {
-            new_external_arr[i] = AllocTraits::allocate(alloc_, DEFAULT_SIZE_BLOCK);
+    // A deque without a map starts in the middle of a new one
+    void PrepareEmpty() {
+        if (external_arr_ == nullptr) {
+            AllocateExternal(kInitialMapSize);
+            start_ = {external_size_ / 2, 0};
+            end_ = start_;
         }
+    }
 
-        PointerAllocTraits::deallocate(external_alloc_, external_arr_, external_size_);
-        external_arr_ = new_external_arr;
-        external_size_ = new_size;
+    // Copies count elements from first into raw memory at dst and advances first. Trivially
+    // copyable elements from contiguous memory take a single memcpy
+    template <typename ForwardIt>
+    void ConstructSegment(T* dst, ForwardIt& first, size_t count) {
+        if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<ForwardIt> &&
+                      std::is_same_v<std::iter_value_t<ForwardIt>, T>) {
+            const T* src = std::to_address(first);
+            if (count * sizeof(T) >= kMemcpyMinBytes) {
+                std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    dst[i] = src[i];
+                }
+            }
+            first += count;
+        } else {
+            size_t i = 0;
+            try {
+                for (; i < count; ++i, ++first) {
+                    AllocTraits::construct(alloc_, dst + i, *first);
+                }
+            } catch (...) {
+                DestroySegment(dst, i);
+                throw;
+            }
+        }
+    }
 
-        start_.external += offset;
-        end_.external += offset;
+    // Moves count elements from src to out, returns the advanced out
+    template <typename OutputIt>
+    static OutputIt MoveSegment(T* src, size_t count, OutputIt out) {
+        if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<OutputIt>) {
+            if constexpr (std::is_same_v<std::iter_value_t<OutputIt>, T>) {
+                if (count * sizeof(T) < kMemcpyMinBytes) {
+                    T* dst = std::to_address(out);
+                    for (size_t i = 0; i < count; ++i) {
+                        dst[i] = src[i];
+                    }
+                    return out + count;
+                }
+            }
+        }
+        return std::move(src, src + count, out);
     }
 
-    void AllocateExternal(const size_t count) {
-        external_arr_ = PointerAllocTraits::allocate(external_alloc_, count);
-        for (size_t i = 0; i < count; ++i) {
-            external_arr_[i] = AllocTraits::allocate(alloc_, DEFAULT_SIZE_BLOCK);
+    void DestroySegment(T* ptr, size_t count) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < count; ++i) {
+                AllocTraits::destroy(alloc_, ptr + i);
+            }
+        }
+    }
+
+    // Calls fn(block pointer, count) for each block piece of the offsets [from, to)
+    template <typename Fn>
+    void ForEachPiece(size_t from, size_t to, Fn&& fn) {
+        while (from < to) {
+            Pair<T> pos = Position(from);
+            size_t count = std::min(to - from, kBlockSize - pos.internal);
+            fn(external_arr_[pos.external] + pos.internal, count);
+            from += count;
+        }
+    }
+
+    // Constructs count elements from first at the offsets [pos, pos + count) without touching
+    // start_, end_ or size_; blocks are taken as needed. Nothing stays constructed on failure
+    template <typename ForwardIt>
+    void ConstructRange(size_t pos, ForwardIt first, size_t count) {
+        size_t done = 0;
+        try {
+            while (done < count) {
+                Pair<T> at = Position(pos + done);
+                size_t piece = std::min(count - done, kBlockSize - at.internal);
+                EnsureBlock(at.external);
+                ConstructSegment(external_arr_[at.external] + at.internal, first, piece);
+                done += piece;
+            }
+        } catch (...) {
+            ForEachPiece(pos, pos + done, [this](T* ptr, size_t piece) { DestroySegment(ptr, piece); });
+            throw;
+        }
+    }
+
+    void EnsureBlock(size_t slot) {
+        if (external_arr_[slot] == nullptr) {
+            if (spare_count_ > 0) {
+                external_arr_[slot] = spare_[--spare_count_];
+            } else {
+                AllocateBlock(external_arr_[slot]);
+            }
+        }
+    }
+
+    void ReleaseBlock(size_t slot) noexcept {
+        T* block = std::exchange(external_arr_[slot], nullptr);
+        if (spare_count_ < kMaxSpareBlocks) {
+            spare_[spare_count_++] = block;
+        } else {
+            DeallocateBlock(block);
+        }
+    }
+
+    void ReleaseSpare() noexcept {
+        for (; spare_count_ > 0; --spare_count_) {
+            DeallocateBlock(spare_[spare_count_ - 1]);
+        }
+    }
+
+    void AdvanceEnd() {
+        if (++end_.internal == kBlockSize) {
+            ++end_.external;
+            end_.internal = 0;
+        }
+    }
+
+    template <typename Self, typename Fn>
+    static void WalkSegments(Self& self, Fn& fn) {
+        using Segment = std::span<std::conditional_t<std::is_const_v<Self>, const T, T>>;
+        if (self.size_ == 0) {
+            return;
+        }
+        size_t first = self.FirstBlock();
+        size_t last = self.LastBlock();
+        for (size_t i = first; i < last; ++i) {
+            size_t begin = i == first ? self.start_.internal : 0;
+            size_t end = i + 1 == last && self.end_.internal != 0 ? self.end_.internal : kBlockSize;
+            Segment segment(self.external_arr_[i] + begin, end - begin);
+            if constexpr (std::is_same_v<std::invoke_result_t<Fn&, Segment>, bool>) {
+                if (!fn(segment)) {
+                    return;
+                }
+            } else {
+                fn(segment);
+            }
         }
-        external_size_ = count;
     }
 
     void AllocateBlock(T*& block) {
-        block = AllocTraits::allocate(alloc_, DEFAULT_SIZE_BLOCK);
+        block = AllocTraits::allocate(alloc_, kBlockSize);
     }
 
     void DeallocateBlock(T* block) {
-        AllocTraits::deallocate(alloc_, block, DEFAULT_SIZE_BLOCK);
+        AllocTraits::deallocate(alloc_, block, kBlockSize);
+    }
+
+    // Gives this empty deque the elements of other in blocks of its own allocator, with a map just
+    // large enough for them and one free slot at each end
+    template <typename Source>
+    void AssignBlocks(Source&& other) {
+        if (other.size_ == 0) {
+            return;
+        }
+        AllocateExternal(other.LastBlock() - other.FirstBlock() + 2);
+        start_ = {1, other.start_.internal};
+        end_ = start_;
+        for (size_t i = Offset(other.start_); i < Offset(other.end_); ++i) {
+            T& elem = other.external_arr_[i / kBlockSize][i % kBlockSize];
+            EnsureBlock(end_.external);
+            if constexpr (std::is_rvalue_reference_v<Source&&>) {
+                AllocTraits::construct(alloc_, &external_arr_[end_.external][end_.internal], std::move(elem));
+            } else {
+                AllocTraits::construct(alloc_, &external_arr_[end_.external][end_.internal], elem);
+            }
+            AdvanceEnd();
+            ++size_;
+        }
+    }
+
+    void StealBlocks(Deque& other) noexcept {
+        external_arr_ = std::exchange(other.external_arr_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        external_size_ = std::exchange(other.external_size_, 0);
+        start_ = std::exchange(other.start_, {0, 0});
+        end_ = std::exchange(other.end_, {0, 0});
+        spare_count_ = std::exchange(other.spare_count_, 0);
+        std::copy(other.spare_, other.spare_ + spare_count_, spare_);
     }
 
     void DeallocateExternal() {
@@ -193,76 +432,59 @@ private:
 public:
     Deque(){};
 
+    // For stateful allocators, e.g. ArenaAllocator<T>(arena); the block map is rebound from it
+    explicit Deque(const Alloc& alloc) : alloc_(alloc), external_alloc_(alloc_) {
+    }
+
+    // count value-initialized elements
     explicit Deque(size_t count) {
-        size_t count_blocks = (count / DEFAULT_SIZE_BLOCK) + 1;
-        AllocateExternal(count_blocks);
-        start_ = {count_blocks / 2, 0};
-        end_ = start_;
+        AllocateExternal(count / kBlockSize + 1);
+        for (size_t i = 0; i < count; ++i) {
+            this->PushBack(T());
+        }
     }
 
     explicit Deque(size_t count, const T& value) {
-        size_t count_blocks = count / DEFAULT_SIZE_BLOCK + 1;
-        start_ = {count_blocks / 2, 0};
-        end_ = start_;
         for (size_t i = 0; i < count; ++i) {
             this->PushBack(value);
         }
     }
     Deque(const Deque& other)
-        : size_(other.size_), start_(other.start_), end_(other.end_), external_size_(other.external_size_) {
-        alloc_ = AllocTraits::select_on_container_copy_construction(other.alloc_);
-        AllocateExternal(external_size_);
-        for (size_t i = 0; i < external_size_; ++i) {
-            if (other.external_arr_[i]) {
-                for (size_t j = 0; j < DEFAULT_SIZE_BLOCK; ++j) {
-                    AllocTraits::construct(alloc_, &external_arr_[i][j], other.external_arr_[i][j]);
-                }
-            }
-        }
+        : alloc_(AllocTraits::select_on_container_copy_construction(other.alloc_)), external_alloc_(alloc_) {
+        this->AssignBlocks(other);
     }
 
-    Deque(Deque&& other)
-        : external_arr_(other.external_arr_),
-          size_(other.size_),
-          start_(other.start_),
-          end_(other.end_),
-          external_size_(other.external_size_) {
-        alloc_ = AllocTraits::select_on_container_copy_construction(other.alloc_);
-        other.external_arr_ = nullptr;
-        other.size_ = 0;
-        other.external_size_ = 0;
-        other.start_ = {0, 0};
-        other.end_ = {0, 0};
+    // The blocks move together with the allocator that owns them
+    Deque(Deque&& other) : alloc_(std::move(other.alloc_)), external_alloc_(alloc_) {
+        this->StealBlocks(other);
     }
 
     Deque& operator=(const Deque& other) {
         if (this != &other) {
             this->Clear();
-            Deque copy = other;
-            alloc_ = AllocTraits::propagate_on_container_copy_assignment::value ? other.alloc_ : alloc_;
-            std::swap(external_arr_, copy.external_arr_);
-            std::swap(size_, copy.size_);
-            std::swap(external_size_, copy.external_size_);
-            std::swap(start_, copy.start_);
-            std::swap(end_, copy.end_);
+            if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+                alloc_ = other.alloc_;
+                external_alloc_ = PointerAlloc(alloc_);
+            }
+            this->AssignBlocks(other);
         }
         return *this;
     }
 
+    // Blocks are stolen when the allocator moves too or both allocators share memory, otherwise
+    // the elements are moved into blocks of this deque's allocator
     Deque& operator=(Deque&& other) {
         if (this != &other) {
-            alloc_ = AllocTraits::propagate_on_container_move_assignment::value ? other.alloc_ : alloc_;
-            std::swap(external_arr_, other.external_arr_);
-            std::swap(size_, other.size_);
-            std::swap(external_size_, other.external_size_);
-            std::swap(start_, other.start_);
-            std::swap(end_, other.end_);
-
-            other.external_arr_ = nullptr;
-            other.size_ = 0;
-            other.external_size_ = 0;
-            other.start_ = {0, 0};
-            other.end_ = {0, 0};
+            this->Clear();
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                alloc_ = other.alloc_;
+                external_alloc_ = PointerAlloc(alloc_);
+            } else if (!(alloc_ == other.alloc_)) {
+                this->AssignBlocks(std::move(other));
+                other.Clear();
+                return *this;
+            }
+            this->StealBlocks(other);
         }
         return *this;
     }
@@ -274,11 +496,23 @@ public:
     }
 
     DequeIterator Begin() {
-        return DequeIterator(external_arr_, start_.external * DEFAULT_SIZE_BLOCK + start_.internal);
+        return DequeIterator(external_arr_ + start_.external, start_.internal);
     }
 
     DequeIterator End() {
-        return DequeIterator(external_arr_, end_.external * DEFAULT_SIZE_BLOCK + end_.internal);
+        return DequeIterator(external_arr_ + end_.external, end_.internal);
+    }
+
+    // Calls fn(std::span<T>) once per block, front to back, with the elements stored in it.
+    // When fn returns bool, false stops the walk. fn must not push or pop
+    template <typename Fn>
+    void ForEachSegment(Fn&& fn) {
+        WalkSegments(*this, fn);
+    }
+
+    template <typename Fn>
+    void ForEachSegment(Fn&& fn) const {
+        WalkSegments(*this, fn);
     }
 
     T& Front() {
@@ -286,14 +520,15 @@ public:
     }
 
     T& Back() {
-        return external_arr_[end_.external][end_.internal];
+        size_t last = Offset(end_) - 1;
+        return external_arr_[last / kBlockSize][last % kBlockSize];
     }
 
     T& operator[](size_t ind) {
-        size_t total_offset = start_.external * DEFAULT_SIZE_BLOCK + start_.internal + ind;
-        size_t ext = total_offset / DEFAULT_SIZE_BLOCK;
-        size_t itl = total_offset % DEFAULT_SIZE_BLOCK;
-        if (ext >= external_size_ || itl >= DEFAULT_SIZE_BLOCK) {
+        size_t total_offset = Offset(start_) + ind;
+        size_t ext = total_offset / kBlockSize;
+        size_t itl = total_offset % kBlockSize;
+        if (ext >= external_size_) {
             throw;
         }
         return external_arr_[ext][itl];
@@ -308,35 +543,32 @@ public:
     }
 
     void PushBack(const T& value) {
-        if (size_ == 0) {
-            AllocateExternal(DEFAULT_COUNT_BLOCKS);
-            start_ = {DEFAULT_COUNT_BLOCKS / 2, 0};
-            end_ = start_;
-        } else if (end_.internal == DEFAULT_SIZE_BLOCK - 1) {
-            if (end_.external == external_size_ - 1) {
-                ResizeExternal(DEFAULT_COUNT_BLOCKS);
-            }
-            ++end_.external;
-            end_.internal = 0;
-        } else {
-            ++end_.internal;
+        PrepareEmpty();
+        if (end_.external == external_size_) {
+            ResizeExternal();
+        }
+        if (end_.internal == 0) {
+            EnsureBlock(end_.external);
         }
         AllocTraits::construct(alloc_, &external_arr_[end_.external][end_.internal], value);
+        AdvanceEnd();
         ++size_;
     }
 
     void PushFront(const T& value) {
-        if (start_.internal == 0) {
-            if (start_.external == 0) {
-                ResizeExternal(DEFAULT_COUNT_BLOCKS);
-                start_.external += DEFAULT_COUNT_BLOCKS / 2;
-                end_.external += DEFAULT_COUNT_BLOCKS / 2;
-            }
-            start_.internal = DEFAULT_SIZE_BLOCK;
-            --start_.external;
-        }
-        --start_.internal;
-        AllocTraits::construct(alloc_, &external_arr_[start_.external][start_.internal], value);
+        PrepareEmpty();
+        if (start_.internal == 0 && start_.external == 0) {
+            ResizeExternal();
+        }
+        Pair<T> front = start_;
+        if (front.internal == 0) {
+            front.internal = kBlockSize;
+            --front.external;
+            EnsureBlock(front.external);
+        }
+        --front.internal;
+        AllocTraits::construct(alloc_, &external_arr_[front.external][front.internal], value);
+        start_ = front;
         ++size_;
     }
 
@@ -344,12 +576,14 @@ public:
         if (size_ == 0) {
             throw DequeIsEmptyException("");
         }
-        AllocTraits::destroy(alloc_, &external_arr_[end_.external][end_.internal]);
         if (end_.internal == 0) {
             --end_.external;
-            end_.internal = DEFAULT_SIZE_BLOCK - 1;
-        } else {
-            --end_.internal;
+            end_.internal = kBlockSize;
+        }
+        --end_.internal;
+        AllocTraits::destroy(alloc_, &external_arr_[end_.external][end_.internal]);
+        if (end_.internal == 0) {
+            ReleaseBlock(end_.external);
         }
         --size_;
     }
@@ -358,27 +592,127 @@ public:
             throw DequeIsEmptyException("");
         }
         AllocTraits::destroy(alloc_, &external_arr_[start_.external][start_.internal]);
-        if (start_.internal == DEFAULT_SIZE_BLOCK - 1) {
+        if (start_.internal == kBlockSize - 1) {
             start_.internal = 0;
-            ++start_.external;
+            ReleaseBlock(start_.external++);
         } else {
             ++start_.internal;
         }
         --size_;
     }
 
+    // Appends copies of [first, last), filling each block with one copy (memcpy for trivially
+    // copyable elements from contiguous memory). The deque is unchanged if a copy throws
+    template <typename ForwardIt>
+    void PushBackRange(ForwardIt first, ForwardIt last) {
+        auto count = static_cast<size_t>(std::distance(first, last));
+        if (count == 0) {
+            return;
+        }
+        PrepareEmpty();
+        size_t needed = (Offset(end_) + count + kBlockSize - 1) / kBlockSize;
+        if (needed > external_size_) {
+            ResizeExternal(1, needed - LastBlock());
+        }
+        ConstructRange(Offset(end_), first, count);
+        end_ = Position(Offset(end_) + count);
+        size_ += count;
+    }
+
+    // Prepends copies of [first, last), keeping their order: afterwards Front() is a copy of *first
+    template <typename ForwardIt>
+    void PushFrontRange(ForwardIt first, ForwardIt last) {
+        auto count = static_cast<size_t>(std::distance(first, last));
+        if (count == 0) {
+            return;
+        }
+        PrepareEmpty();
+        if (count > Offset(start_)) {
+            ResizeExternal((count - start_.internal + kBlockSize - 1) / kBlockSize, 1);
+        }
+        size_t pos = Offset(start_) - count;
+        ConstructRange(pos, first, count);
+        start_ = Position(pos);
+        size_ += count;
+    }
+
+    // Moves the first count elements to out, front to back, and pops them. Returns the output
+    // iterator past the last element written
+    template <typename OutputIt>
+    OutputIt PopFrontN(size_t count, OutputIt out) {
+        if (count > size_) {
+            throw DequeIsEmptyException("");
+        }
+        while (count > 0) {
+            T* block = external_arr_[start_.external] + start_.internal;
+            size_t piece = std::min(count, kBlockSize - start_.internal);
+            out = MoveSegment(block, piece, out);
+            DestroySegment(block, piece);
+            count -= piece;
+            size_ -= piece;
+            start_.internal += piece;
+            if (start_.internal == kBlockSize) {
+                start_.internal = 0;
+                ReleaseBlock(start_.external++);
+            }
+        }
+        return out;
+    }
+
+    // Moves the last count elements to out, in deque order, and pops them. Returns the output
+    // iterator past the last element written
+    template <typename OutputIt>
+    OutputIt PopBackN(size_t count, OutputIt out) {
+        if (count > size_) {
+            throw DequeIsEmptyException("");
+        }
+        size_t from = Offset(end_) - count;
+        ForEachPiece(from, Offset(end_), [&out](T* ptr, size_t piece) { out = MoveSegment(ptr, piece, out); });
+        ForEachPiece(from, Offset(end_), [this](T* ptr, size_t piece) { DestroySegment(ptr, piece); });
+        size_t last = LastBlock();
+        end_ = Position(from);
+        for (size_t slot = LastBlock(); slot < last; ++slot) {
+            ReleaseBlock(slot);
+        }
+        size_ -= count;
+        return out;
+    }
+
+    // Frees the spare blocks and every block without elements, then shrinks the map to the used
+    // blocks. Iterators are invalidated
+    void ShrinkToFit() {
+        if (size_ == 0) {
+            this->Clear();
+            return;
+        }
+        size_t first = FirstBlock();
+        size_t last = LastBlock();
+        for (size_t i = 0; i < external_size_; ++i) {
+            if ((i < first || i >= last) && external_arr_[i] != nullptr) {
+                DeallocateBlock(std::exchange(external_arr_[i], nullptr));
+            }
+        }
+        ReleaseSpare();
+        if (last - first == external_size_) {
+            return;
+        }
+        T** new_external_arr = PointerAllocTraits::allocate(external_alloc_, last - first);
+        std::copy(external_arr_ + first, external_arr_ + last, new_external_arr);
+        PointerAllocTraits::deallocate(external_alloc_, external_arr_, external_size_);
+        external_arr_ = new_external_arr;
+        external_size_ = last - first;
+        start_.external -= first;
+        end_.external -= first;
+    }
+
     void Clear() {
         if (external_arr_ != nullptr) {
-            for (size_t i = 0; i < external_size_; ++i) {
-                if (external_arr_[i] != nullptr) {
-                    for (size_t j = 0; j < DEFAULT_SIZE_BLOCK; ++j) {
-                        AllocTraits::destroy(alloc_, &external_arr_[i][j]);
-                    }
-                    AllocTraits::deallocate(alloc_, external_arr_[i], DEFAULT_SIZE_BLOCK);
-                }
+            for (size_t i = Offset(start_); i < Offset(end_); ++i) {
+                AllocTraits::destroy(alloc_, &external_arr_[i / kBlockSize][i % kBlockSize]);
             }
-            PointerAllocTraits::deallocate(external_alloc_, external_arr_, external_size_);
+            DeallocateExternal();
         }
+        ReleaseSpare();
         external_arr_ = nullptr;
         size_ = 0;
         external_size_ = 0;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <utility>
+
+#include "deque.hpp"
+
+// Copy, Fill, Find and Accumulate over a Deque, one tight loop per block through ForEachSegment:
+// no per-element division or block switch, and the std algorithms inside see plain pointers, so
+// trivially copyable elements are copied with memmove and the rest of the loops vectorize.
+namespace segmented {
+
+// Returns the output iterator past the last element written
+template <typename T, typename Alloc, size_t BlockBytes, typename OutputIt>
+OutputIt Copy(const Deque<T, Alloc, BlockBytes>& deque, OutputIt out) {
+    deque.ForEachSegment([&out](std::span<const T> segment) { out = std::copy(segment.begin(), segment.end(), out); });
+    return out;
+}
+
+template <typename T, typename Alloc, size_t BlockBytes>
+void Fill(Deque<T, Alloc, BlockBytes>& deque, const T& value) {
+    deque.ForEachSegment([&value](std::span<T> segment) { std::fill(segment.begin(), segment.end(), value); });
+}
+
+// Index of the first element equal to value, Size() when there is none
+template <typename T, typename Alloc, size_t BlockBytes>
+size_t Find(const Deque<T, Alloc, BlockBytes>& deque, const T& value) {
+    size_t index = 0;
+    deque.ForEachSegment([&index, &value](std::span<const T> segment) {
+        auto it = std::find(segment.begin(), segment.end(), value);
+        index += it - segment.begin();
+        return it == segment.end();
+    });
+    return index;
+}
+
+template <typename T, typename Alloc, size_t BlockBytes, typename Acc, typename BinaryOp = std::plus<>>
+Acc Accumulate(const Deque<T, Alloc, BlockBytes>& deque, Acc init, BinaryOp op = BinaryOp()) {
+    deque.ForEachSegment([&init, &op](std::span<const T> segment) {
+        init = std::accumulate(segment.begin(), segment.end(), std::move(init), op);
+    });
+    return init;
+}
+
+}  // namespace segmented
@@ -0,0 +1,457 @@
+#include "../deque.hpp"
+#include "../deque_algorithms.hpp"
+#include "../../../vector/allocator/tracking_allocator.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Both deques allocate through TrackingAllocator, which counts into AllocationTag::Untagged()
+template <size_t BlockBytes>
+using DequeBytes = Deque<int64_t, TrackingAllocator<int64_t>, BlockBytes>;
+
+using StdDeque = std::deque<int64_t, TrackingAllocator<int64_t>>;
+
+// Deque and std::deque spell their operations differently
+template <size_t BlockBytes>
+void PushBack(DequeBytes<BlockBytes>& deque, int64_t value) {
+  deque.PushBack(value);
+}
+
+template <size_t BlockBytes>
+void PushFront(DequeBytes<BlockBytes>& deque, int64_t value) {
+  deque.PushFront(value);
+}
+
+template <size_t BlockBytes>
+void PopFront(DequeBytes<BlockBytes>& deque) {
+  deque.PopFront();
+}
+
+template <size_t BlockBytes>
+void PopBack(DequeBytes<BlockBytes>& deque) {
+  deque.PopBack();
+}
+
+template <size_t BlockBytes>
+int64_t& Front(DequeBytes<BlockBytes>& deque) {
+  return deque.Front();
+}
+
+template <size_t BlockBytes>
+size_t Size(const DequeBytes<BlockBytes>& deque) {
+  return deque.Size();
+}
+
+template <size_t BlockBytes>
+void ShrinkToFit(DequeBytes<BlockBytes>& deque) {
+  deque.ShrinkToFit();
+}
+
+template <size_t BlockBytes>
+auto Begin(DequeBytes<BlockBytes>& deque) {
+  return deque.Begin();
+}
+
+template <size_t BlockBytes>
+auto End(DequeBytes<BlockBytes>& deque) {
+  return deque.End();
+}
+
+void PushBack(StdDeque& deque, int64_t value) {
+  deque.push_back(value);
+}
+
+void PushFront(StdDeque& deque, int64_t value) {
+  deque.push_front(value);
+}
+
+void PopFront(StdDeque& deque) {
+  deque.pop_front();
+}
+
+void PopBack(StdDeque& deque) {
+  deque.pop_back();
+}
+
+int64_t& Front(StdDeque& deque) {
+  return deque.front();
+}
+
+size_t Size(const StdDeque& deque) {
+  return deque.size();
+}
+
+void ShrinkToFit(StdDeque& deque) {
+  deque.shrink_to_fit();
+}
+
+auto Begin(StdDeque& deque) {
+  return deque.begin();
+}
+
+auto End(StdDeque& deque) {
+  return deque.end();
+}
+
+std::vector<size_t> RandomIndices(size_t size, size_t count) {
+  std::mt19937_64 mt(42);
+  std::uniform_int_distribution<size_t> dist(0, size - 1);
+  std::vector<size_t> indices(count);
+  for (auto& index : indices) {
+    index = dist(mt);
+  }
+  return indices;
+}
+
+// Call after the loop with the number of container operations done in it
+void ReportAllocations(benchmark::State& state, const AllocationStats& before, int64_t operations) {
+  AllocationStats after = AllocationTag::Untagged().Snapshot();
+  state.counters["allocs/Mop"] = static_cast<double>(after.allocations - before.allocations) * 1e6 /
+                                 static_cast<double>(std::max<int64_t>(operations, 1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A fresh container per iteration: block and map allocation are part of the cost
+template <typename Container>
+void BM_PushBack(benchmark::State& state) {
+  auto count = static_cast<int64_t>(state.range(0));
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  for (auto _ : state) {
+    Container deque;
+    for (int64_t i = 0; i < count; ++i) {
+      PushBack(deque, i);
+    }
+    benchmark::DoNotOptimize(Front(deque));
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  ReportAllocations(state, before, state.iterations() * count);
+}
+
+template <typename Container>
+void BM_PushFront(benchmark::State& state) {
+  auto count = static_cast<int64_t>(state.range(0));
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  for (auto _ : state) {
+    Container deque;
+    for (int64_t i = 0; i < count; ++i) {
+      PushFront(deque, i);
+    }
+    benchmark::DoNotOptimize(Front(deque));
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  ReportAllocations(state, before, state.iterations() * count);
+}
+
+// Steady-state queue of range(0) elements, one PushBack and one PopFront per item
+template <typename Container>
+void BM_Fifo(benchmark::State& state) {
+  auto length = static_cast<int64_t>(state.range(0));
+  Container deque;
+  for (int64_t i = 0; i < length; ++i) {
+    PushBack(deque, i);
+  }
+  int64_t next = length;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  for (auto _ : state) {
+    for (int i = 0; i < 1024; ++i) {
+      benchmark::DoNotOptimize(Front(deque));
+      PopFront(deque);
+      PushBack(deque, next++);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 1024);
+  ReportAllocations(state, before, state.iterations() * 2048);
+}
+
+// A queue that fills up to range(0) elements and drains completely, over and over
+template <typename Container>
+void BM_FifoBursts(benchmark::State& state) {
+  auto burst = static_cast<int64_t>(state.range(0));
+  Container deque;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  for (auto _ : state) {
+    for (int64_t i = 0; i < burst; ++i) {
+      PushBack(deque, i);
+    }
+    for (int64_t i = 0; i < burst; ++i) {
+      benchmark::DoNotOptimize(Front(deque));
+      PopFront(deque);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * burst);
+  ReportAllocations(state, before, state.iterations() * burst * 2);
+}
+
+// Memory held by kSmallDeques deques of range(0) elements each, as bytes/deque. With range(1) set,
+// each deque first grows to 256 elements and is popped down to range(0), then shrunk if range(1) is 2
+constexpr size_t kSmallDeques = 4096;
+
+template <typename Container>
+void BM_SmallDequeFootprint(benchmark::State& state) {
+  auto elements = static_cast<int64_t>(state.range(0));
+  int64_t mode = state.range(1);
+  int64_t peak = mode == 0 ? elements : 256;
+  double bytes = 0;
+  for (auto _ : state) {
+    uint64_t before = AllocationTag::Untagged().Snapshot().live_bytes;
+    std::vector<Container> deques(kSmallDeques);
+    for (auto& deque : deques) {
+      for (int64_t i = 0; i < peak; ++i) {
+        PushBack(deque, i);
+      }
+      for (int64_t i = elements; i < peak; ++i) {
+        PopFront(deque);
+      }
+      if (mode == 2) {
+        ShrinkToFit(deque);
+      }
+    }
+    bytes = static_cast<double>(AllocationTag::Untagged().Snapshot().live_bytes - before);
+  }
+  state.counters["bytes/deque"] = bytes / kSmallDeques;
+}
+
+template <typename Container>
+void BM_RandomIndex(benchmark::State& state) {
+  auto size = static_cast<size_t>(state.range(0));
+  Container deque;
+  for (size_t i = 0; i < size; ++i) {
+    PushBack(deque, static_cast<int64_t>(i));
+  }
+  auto indices = RandomIndices(size, 4096);
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (size_t index : indices) {
+      sum += deque[index];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * indices.size());
+}
+
+// Three ways to scan: operator[] per element (a division and a block lookup each, which is what
+// the iterator used to do), the block-and-offset iterator, and the segmented algorithms. For
+// std::deque the segmented path is the std algorithm, which libstdc++ runs block by block for copy and fill
+enum class Path { kIndex, kIterator, kSegmented };
+
+template <typename Container>
+Container MakeSequence(int64_t size) {
+  Container deque;
+  for (int64_t i = 0; i < size; ++i) {
+    PushBack(deque, i);
+  }
+  return deque;
+}
+
+template <typename Container, Path kPath>
+void BM_Accumulate(benchmark::State& state) {
+  auto deque = MakeSequence<Container>(state.range(0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    if constexpr (kPath == Path::kIndex) {
+      for (size_t i = 0, size = Size(deque); i < size; ++i) {
+        sum += deque[i];
+      }
+    } else if constexpr (kPath == Path::kIterator) {
+      for (auto it = Begin(deque), end = End(deque); it != end; ++it) {
+        sum += *it;
+      }
+    } else if constexpr (std::is_same_v<Container, StdDeque>) {
+      sum = std::accumulate(deque.begin(), deque.end(), int64_t{0});
+    } else {
+      sum = segmented::Accumulate(deque, int64_t{0});
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Looks for the last element, so every path scans the whole deque
+template <typename Container, Path kPath>
+void BM_Find(benchmark::State& state) {
+  auto deque = MakeSequence<Container>(state.range(0));
+  int64_t needle = state.range(0) - 1;
+  for (auto _ : state) {
+    size_t index = 0;
+    if constexpr (kPath == Path::kIndex) {
+      for (size_t size = Size(deque); index < size && deque[index] != needle; ++index) {
+      }
+    } else if constexpr (kPath == Path::kIterator) {
+      for (auto it = Begin(deque), end = End(deque); it != end && *it != needle; ++it) {
+        ++index;
+      }
+    } else if constexpr (std::is_same_v<Container, StdDeque>) {
+      index = std::find(deque.begin(), deque.end(), needle) - deque.begin();
+    } else {
+      index = segmented::Find(deque, needle);
+    }
+    benchmark::DoNotOptimize(index);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Container, Path kPath>
+void BM_Fill(benchmark::State& state) {
+  auto deque = MakeSequence<Container>(state.range(0));
+  int64_t value = 0;
+  for (auto _ : state) {
+    ++value;
+    if constexpr (kPath == Path::kIndex) {
+      for (size_t i = 0, size = Size(deque); i < size; ++i) {
+        deque[i] = value;
+      }
+    } else if constexpr (kPath == Path::kIterator) {
+      for (auto it = Begin(deque), end = End(deque); it != end; ++it) {
+        *it = value;
+      }
+    } else if constexpr (std::is_same_v<Container, StdDeque>) {
+      std::fill(deque.begin(), deque.end(), value);
+    } else {
+      segmented::Fill(deque, value);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Container, Path kPath>
+void BM_CopyOut(benchmark::State& state) {
+  auto deque = MakeSequence<Container>(state.range(0));
+  std::vector<int64_t> out(state.range(0));
+  for (auto _ : state) {
+    if constexpr (kPath == Path::kIndex) {
+      for (size_t i = 0, size = Size(deque); i < size; ++i) {
+        out[i] = deque[i];
+      }
+    } else if constexpr (kPath == Path::kIterator) {
+      auto dst = out.begin();
+      for (auto it = Begin(deque), end = End(deque); it != end; ++it) {
+        *dst++ = *it;
+      }
+    } else if constexpr (std::is_same_v<Container, StdDeque>) {
+      std::copy(deque.begin(), deque.end(), out.begin());
+    } else {
+      segmented::Copy(deque, out.begin());
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Batches of range(0) elements through a queue, 4096 elements per iteration: one call per element
+// against one range call per batch. std::deque takes a range with insert and gives it back with
+// copy and erase
+constexpr int64_t kBatchedElements = 4096;
+
+enum class Batch { kElementwise, kRange };
+
+template <typename Container, Batch kBatch>
+void BM_BatchQueue(benchmark::State& state) {
+  auto batch = static_cast<size_t>(state.range(0));
+  std::vector<int64_t> in(batch, 1);
+  std::vector<int64_t> out(batch);
+  Container deque;
+  for (auto _ : state) {
+    for (int64_t done = 0; done < kBatchedElements; done += batch) {
+      if constexpr (kBatch == Batch::kElementwise) {
+        for (int64_t value : in) {
+          PushBack(deque, value);
+        }
+        for (auto& value : out) {
+          value = Front(deque);
+          PopFront(deque);
+        }
+      } else if constexpr (std::is_same_v<Container, StdDeque>) {
+        deque.insert(deque.end(), in.begin(), in.end());
+        std::copy(deque.begin(), deque.begin() + batch, out.begin());
+        deque.erase(deque.begin(), deque.begin() + batch);
+      } else {
+        deque.PushBackRange(in.begin(), in.end());
+        deque.PopFrontN(batch, out.begin());
+      }
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchedElements);
+}
+
+// The same through the other end: PushFrontRange and PopBackN
+template <typename Container, Batch kBatch>
+void BM_BatchReverseQueue(benchmark::State& state) {
+  auto batch = static_cast<size_t>(state.range(0));
+  std::vector<int64_t> in(batch, 1);
+  std::vector<int64_t> out(batch);
+  Container deque;
+  for (auto _ : state) {
+    for (int64_t done = 0; done < kBatchedElements; done += batch) {
+      if constexpr (kBatch == Batch::kElementwise) {
+        for (auto it = in.rbegin(); it != in.rend(); ++it) {
+          PushFront(deque, *it);
+        }
+        for (auto it = out.rbegin(); it != out.rend(); ++it) {
+          *it = deque[Size(deque) - 1];
+          PopBack(deque);
+        }
+      } else if constexpr (std::is_same_v<Container, StdDeque>) {
+        deque.insert(deque.begin(), in.begin(), in.end());
+        std::copy(deque.end() - batch, deque.end(), out.begin());
+        deque.erase(deque.end() - batch, deque.end());
+      } else {
+        deque.PushFrontRange(in.begin(), in.end());
+        deque.PopBackN(batch, out.begin());
+      }
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchedElements);
+}
+
+#define BATCH_BENCHMARKS(BM)                                                                           \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<4096>, Batch::kElementwise)->RangeMultiplier(4)->Range(1, 4096); \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<4096>, Batch::kRange)->RangeMultiplier(4)->Range(1, 4096);       \
+  BENCHMARK_TEMPLATE(BM, StdDeque, Batch::kElementwise)->RangeMultiplier(4)->Range(1, 4096);         \
+  BENCHMARK_TEMPLATE(BM, StdDeque, Batch::kRange)->RangeMultiplier(4)->Range(1, 4096)
+
+#define DEQUE_BENCHMARKS(BM, ...)                                           \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<64>)->__VA_ARGS__;                      \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<512>)->__VA_ARGS__;                     \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<4096>)->__VA_ARGS__;                    \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<65536>)->__VA_ARGS__;                   \
+  BENCHMARK_TEMPLATE(BM, StdDeque)->__VA_ARGS__
+
+DEQUE_BENCHMARKS(BM_PushBack, RangeMultiplier(16)->Range(1<<8, 1<<20));
+DEQUE_BENCHMARKS(BM_PushFront, RangeMultiplier(16)->Range(1<<8, 1<<20));
+DEQUE_BENCHMARKS(BM_Fifo, RangeMultiplier(64)->Range(1<<4, 1<<16));
+DEQUE_BENCHMARKS(BM_FifoBursts, RangeMultiplier(16)->Range(1<<4, 1<<16));
+DEQUE_BENCHMARKS(BM_SmallDequeFootprint, ArgsProduct({{1, 4, 16, 64}, {0}})->Unit(benchmark::kMicrosecond));
+DEQUE_BENCHMARKS(BM_SmallDequeFootprint, ArgsProduct({{1, 16}, {1, 2}})->Unit(benchmark::kMicrosecond));
+DEQUE_BENCHMARKS(BM_RandomIndex, RangeMultiplier(64)->Range(1<<10, 1<<22));
+
+#define SCAN_BENCHMARKS(BM)                                                                         \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<512>, Path::kIndex)->RangeMultiplier(64)->Range(1<<10, 1<<22);     \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<512>, Path::kIterator)->RangeMultiplier(64)->Range(1<<10, 1<<22);  \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<512>, Path::kSegmented)->RangeMultiplier(64)->Range(1<<10, 1<<22); \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<4096>, Path::kIndex)->RangeMultiplier(64)->Range(1<<10, 1<<22);    \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<4096>, Path::kIterator)->RangeMultiplier(64)->Range(1<<10, 1<<22); \
+  BENCHMARK_TEMPLATE(BM, DequeBytes<4096>, Path::kSegmented)->RangeMultiplier(64)->Range(1<<10, 1<<22);\
+  BENCHMARK_TEMPLATE(BM, StdDeque, Path::kIndex)->RangeMultiplier(64)->Range(1<<10, 1<<22);            \
+  BENCHMARK_TEMPLATE(BM, StdDeque, Path::kIterator)->RangeMultiplier(64)->Range(1<<10, 1<<22);         \
+  BENCHMARK_TEMPLATE(BM, StdDeque, Path::kSegmented)->RangeMultiplier(64)->Range(1<<10, 1<<22)
+
+SCAN_BENCHMARKS(BM_Accumulate);
+SCAN_BENCHMARKS(BM_Find);
+SCAN_BENCHMARKS(BM_Fill);
+SCAN_BENCHMARKS(BM_CopyOut);
+BATCH_BENCHMARKS(BM_BatchQueue);
+BATCH_BENCHMARKS(BM_BatchReverseQueue);
+
+BENCHMARK_MAIN();
@@ -1,5 +1,13 @@
 #include <gtest/gtest.h>
 #include "deque.hpp"  
+#include "deque_algorithms.hpp"
+#include "../../vector/allocator/tracking_allocator.hpp"
+
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 
 class DequeTest: public testing::Test {
@@ -166,14 +174,14 @@ TEST_F(DequeTest, PopBack) {
 
 TEST(RandomDequeTest, PushAtBlockBoundaries) {
     Deque<int> deque;
-    for (size_t i = 0; i < DEFAULT_SIZE_BLOCK; ++i) {
+    for (size_t i = 0; i < Deque<int>::kBlockSize; ++i) {
         deque.PushBack(i);
     }
-    ASSERT_EQ(deque.Size(), DEFAULT_SIZE_BLOCK);
-    deque.PushBack(DEFAULT_SIZE_BLOCK);
-    ASSERT_EQ(deque.Size(), DEFAULT_SIZE_BLOCK + 1);
-    ASSERT_EQ(deque[DEFAULT_SIZE_BLOCK], DEFAULT_SIZE_BLOCK);
-    for (size_t i = 0; i < DEFAULT_SIZE_BLOCK + 1; ++i) {
+    ASSERT_EQ(deque.Size(), Deque<int>::kBlockSize);
+    deque.PushBack(Deque<int>::kBlockSize);
+    ASSERT_EQ(deque.Size(), Deque<int>::kBlockSize + 1);
+    ASSERT_EQ(deque[Deque<int>::kBlockSize], Deque<int>::kBlockSize);
+    for (size_t i = 0; i < Deque<int>::kBlockSize + 1; ++i) {
         ASSERT_EQ(deque[i], i);
     }
 }
@@ -186,6 +194,347 @@ struct CustomType {
     }
 };
 
+TEST(RandomDequeTest, SmallBlocksBothEnds) {
+    Deque<int, std::allocator<int>, 16> deque;
+    ASSERT_EQ(deque.kBlockSize, 4);
+    for (int i = 0; i < 50; ++i) {
+        deque.PushBack(i);
+        deque.PushFront(-i - 1);
+    }
+    ASSERT_EQ(deque.Size(), 100);
+    ASSERT_EQ(deque.Front(), -50);
+    ASSERT_EQ(deque.Back(), 49);
+    ASSERT_EQ(deque.End() - deque.Begin(), 100);
+    int expected = -50;
+    for (auto it = deque.Begin(); it != deque.End(); ++it) {
+        ASSERT_EQ(*it, expected++);
+    }
+    for (int i = 0; i < 30; ++i) {
+        deque.PopFront();
+        deque.PopBack();
+    }
+    ASSERT_EQ(deque.Size(), 40);
+    ASSERT_EQ(deque[0], -20);
+    ASSERT_EQ(deque[39], 19);
+
+    Deque<int, std::allocator<int>, 16> copy = deque;
+    ASSERT_EQ(copy.Size(), 40);
+    ASSERT_EQ(copy.Front(), -20);
+    ASSERT_EQ(copy.Back(), 19);
+}
+
+TEST(RandomDequeTest, PushFrontAfterEmptied) {
+    Deque<int> deque;
+    deque.PushBack(1);
+    deque.PopBack();
+    deque.PushFront(2);
+    deque.PushFront(3);
+    ASSERT_EQ(deque.Size(), 2);
+    ASSERT_EQ(deque.Front(), 3);
+    ASSERT_EQ(deque.Back(), 2);
+}
+
+TEST(RandomDequeTest, FifoReusesBlocks) {
+    static AllocationTag tag("deque fifo");
+    Deque<int, TrackingAllocator<int>, 16> deque{TrackingAllocator<int>(tag)};
+    for (int i = 0; i < 10; ++i) {
+        deque.PushBack(i);
+    }
+    for (int i = 10; i < 100; ++i) {
+        deque.PushBack(i);
+        deque.PopFront();
+    }
+    size_t allocations = tag.Snapshot().allocations;
+    for (int i = 100; i < 10000; ++i) {
+        deque.PushBack(i);
+        ASSERT_EQ(deque.Front(), i - 10);
+        deque.PopFront();
+    }
+    ASSERT_EQ(tag.Snapshot().allocations, allocations);
+    ASSERT_EQ(deque.Size(), 10);
+    ASSERT_EQ(deque.Back(), 9999);
+}
+
+TEST(RandomDequeTest, CountConstructor) {
+    Deque<int> deque(1000);
+    ASSERT_EQ(deque.Size(), 1000);
+    ASSERT_EQ(deque[0], 0);
+    ASSERT_EQ(deque[999], 0);
+    deque.PushFront(1);
+    ASSERT_EQ(deque.Front(), 1);
+}
+
+TEST(RandomDequeTest, AllocatesBlocksOnDemand) {
+    static AllocationTag tag("deque lazy blocks");
+    using SmallDeque = Deque<int, TrackingAllocator<int>, 16>;
+    SmallDeque deque{TrackingAllocator<int>(tag)};
+    for (int i = 0; i < 400; ++i) {
+        deque.PushBack(i);
+    }
+    for (int i = 0; i < 398; ++i) {
+        deque.PopFront();
+    }
+    size_t live = tag.Snapshot().live_bytes;
+    SmallDeque copy = deque;
+    ASSERT_EQ(copy.Size(), 2);
+    ASSERT_EQ(copy.Front(), 398);
+    ASSERT_LT(tag.Snapshot().live_bytes - live, 1024);
+}
+
+TEST(RandomDequeTest, ShrinkToFit) {
+    static AllocationTag tag("deque shrink");
+    Deque<int, TrackingAllocator<int>, 16> deque{TrackingAllocator<int>(tag)};
+    for (int i = 0; i < 1000; ++i) {
+        deque.PushBack(i);
+        deque.PushFront(-i);
+    }
+    for (int i = 0; i < 990; ++i) {
+        deque.PopBack();
+        deque.PopFront();
+    }
+    deque.ShrinkToFit();
+    // 20 elements in at most 6 blocks of 16 bytes and a map of 6 pointers
+    ASSERT_LE(tag.Snapshot().live_bytes, 6 * 16 + 6 * sizeof(int*));
+    ASSERT_EQ(deque.Size(), 20);
+    ASSERT_EQ(deque.Front(), -9);
+    ASSERT_EQ(deque.Back(), 9);
+    deque.PushFront(-10);
+    deque.PushBack(10);
+    ASSERT_EQ(deque[0], -10);
+    ASSERT_EQ(deque[21], 10);
+
+    while (!deque.IsEmpty()) {
+        deque.PopBack();
+    }
+    deque.ShrinkToFit();
+    ASSERT_EQ(tag.Snapshot().live_bytes, 0);
+    deque.PushBack(1);
+    ASSERT_EQ(deque.Front(), 1);
+}
+
+TEST(RandomDequeTest, MatchesStdDeque) {
+    Deque<int, std::allocator<int>, 16> deque;
+    std::deque<int> expected;
+    std::mt19937 mt(7);
+    for (int i = 0; i < 20000; ++i) {
+        switch (mt() % 5) {
+            case 0:
+            case 1:
+                deque.PushBack(i);
+                expected.push_back(i);
+                break;
+            case 2:
+                deque.PushFront(i);
+                expected.push_front(i);
+                break;
+            case 3:
+                if (!expected.empty()) {
+                    deque.PopBack();
+                    expected.pop_back();
+                }
+                break;
+            default:
+                if (!expected.empty()) {
+                    deque.PopFront();
+                    expected.pop_front();
+                }
+        }
+        ASSERT_EQ(deque.Size(), expected.size());
+        if (!expected.empty()) {
+            ASSERT_EQ(deque.Front(), expected.front());
+            ASSERT_EQ(deque.Back(), expected.back());
+        }
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(deque[i], expected[i]);
+    }
+}
+
+TEST(RandomDequeTest, IteratorArithmeticAcrossBlocks) {
+    Deque<int, std::allocator<int>, 16> deque;
+    for (int i = 0; i < 10; ++i) {
+        deque.PushFront(-i - 1);
+        deque.PushBack(i);
+    }
+    auto begin = deque.Begin();
+    auto end = deque.End();
+    ASSERT_EQ(end - begin, 20);
+    ASSERT_EQ(*(begin + 13), 3);
+    ASSERT_EQ(*(end - 1), 9);
+    auto it = begin + 17;
+    it -= 9;
+    ASSERT_EQ(*it, -2);
+    ASSERT_EQ(it - begin, 8);
+    ASSERT_TRUE(begin < it && it < end);
+    --it;
+    ASSERT_EQ(*it--, -3);
+    ASSERT_EQ(*it, -4);
+    it += 12;
+    ASSERT_EQ(*it, 8);
+}
+
+TEST(RandomDequeTest, ForEachSegment) {
+    Deque<int, std::allocator<int>, 16> deque;
+    size_t calls = 0;
+    deque.ForEachSegment([&calls](std::span<int>) { ++calls; });
+    ASSERT_EQ(calls, 0);
+
+    for (int i = 0; i < 11; ++i) {
+        deque.PushBack(i);
+    }
+    deque.PopFront();
+    std::vector<size_t> sizes;
+    int expected = 1;
+    deque.ForEachSegment([&](std::span<int> segment) {
+        sizes.push_back(segment.size());
+        for (int value : segment) {
+            ASSERT_EQ(value, expected++);
+        }
+    });
+    ASSERT_EQ(sizes, (std::vector<size_t>{3, 4, 3}));
+
+    calls = 0;
+    deque.ForEachSegment([&calls](std::span<int>) { return ++calls < 2; });
+    ASSERT_EQ(calls, 2);
+}
+
+TEST(RandomDequeTest, SegmentedAlgorithms) {
+    Deque<int, std::allocator<int>, 64> deque;
+    for (int i = 0; i < 100; ++i) {
+        deque.PushBack(i);
+        deque.PushFront(-i - 1);
+    }
+    ASSERT_EQ(segmented::Accumulate(deque, int64_t{0}), -100);
+    ASSERT_EQ(segmented::Find(deque, -100), 0);
+    ASSERT_EQ(segmented::Find(deque, 42), 142);
+    ASSERT_EQ(segmented::Find(deque, 1000), 200);
+
+    std::vector<int> out(200);
+    ASSERT_EQ(segmented::Copy(deque, out.begin()), out.end());
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_EQ(out[i], i - 100);
+    }
+
+    segmented::Fill(deque, 7);
+    ASSERT_EQ(segmented::Accumulate(deque, 0), 1400);
+    ASSERT_EQ(deque[0], 7);
+    ASSERT_EQ(deque[199], 7);
+}
+
+TEST(RandomDequeTest, RangePushAndPop) {
+    Deque<int, std::allocator<int>, 16> deque;
+    std::vector<int> values(50);
+    for (int i = 0; i < 50; ++i) {
+        values[i] = i;
+    }
+    deque.PushBack(1000);
+    deque.PushBackRange(values.begin(), values.end());
+    deque.PushFrontRange(values.begin(), values.begin() + 7);
+    ASSERT_EQ(deque.Size(), 58);
+    ASSERT_EQ(deque.Front(), 0);
+    ASSERT_EQ(deque[6], 6);
+    ASSERT_EQ(deque[7], 1000);
+    ASSERT_EQ(deque[8], 0);
+    ASSERT_EQ(deque.Back(), 49);
+
+    std::vector<int> out(10);
+    ASSERT_EQ(deque.PopFrontN(9, out.begin()), out.begin() + 9);
+    ASSERT_EQ(out[0], 0);
+    ASSERT_EQ(out[7], 1000);
+    ASSERT_EQ(out[8], 0);
+    ASSERT_EQ(deque.PopBackN(10, out.begin()), out.end());
+    ASSERT_EQ(out[0], 40);
+    ASSERT_EQ(out[9], 49);
+    ASSERT_EQ(deque.Size(), 39);
+    ASSERT_EQ(deque.Front(), 1);
+    ASSERT_EQ(deque.Back(), 39);
+    ASSERT_THROW(deque.PopFrontN(40, out.begin()), DequeIsEmptyException);
+
+    std::vector<int> rest;
+    deque.PopBackN(39, std::back_inserter(rest));
+    ASSERT_TRUE(deque.IsEmpty());
+    ASSERT_EQ(rest.size(), 39);
+    ASSERT_EQ(rest[38], 39);
+    deque.PushFrontRange(values.begin(), values.end());
+    ASSERT_EQ(deque.Size(), 50);
+    ASSERT_EQ(deque[49], 49);
+}
+
+TEST(RandomDequeTest, RangePushNonTrivialAndThrowingCopy) {
+    std::vector<std::string> words = {"a", "bb", "ccc", "dddd", "eeeee", "ffffff"};
+    Deque<std::string, std::allocator<std::string>, 64> deque;
+    deque.PushBackRange(words.begin(), words.end());
+    deque.PushFrontRange(words.begin(), words.begin() + 2);
+    ASSERT_EQ(deque.Size(), 8);
+    ASSERT_EQ(deque[0], "a");
+    ASSERT_EQ(deque[2], "a");
+    ASSERT_EQ(deque.Back(), "ffffff");
+
+    struct Throwing {
+        int value;
+        Throwing(int v) : value(v) {}
+        Throwing(const Throwing& other) : value(other.value) {
+            if (value == 13) {
+                throw std::runtime_error("copy");
+            }
+        }
+    };
+    std::vector<Throwing> source(20, Throwing(1));
+    source[15].value = 13;
+    Deque<Throwing, std::allocator<Throwing>, 32> throwing;
+    throwing.PushBack(Throwing(7));
+    ASSERT_THROW(throwing.PushBackRange(source.begin(), source.end()), std::runtime_error);
+    ASSERT_THROW(throwing.PushFrontRange(source.begin(), source.end()), std::runtime_error);
+    ASSERT_EQ(throwing.Size(), 1);
+    ASSERT_EQ(throwing.Front().value, 7);
+    ASSERT_EQ(throwing.Back().value, 7);
+}
+
+TEST(RandomDequeTest, RangeOpsMatchStdDeque) {
+    Deque<int, std::allocator<int>, 16> deque;
+    std::deque<int> expected;
+    std::vector<int> batch;
+    std::vector<int> popped;
+    std::mt19937 mt(11);
+    for (int i = 0; i < 3000; ++i) {
+        size_t count = mt() % 40;
+        batch.resize(count);
+        for (size_t j = 0; j < count; ++j) {
+            batch[j] = i * 100 + static_cast<int>(j);
+        }
+        popped.clear();
+        switch (mt() % 4) {
+            case 0:
+                deque.PushBackRange(batch.begin(), batch.end());
+                expected.insert(expected.end(), batch.begin(), batch.end());
+                break;
+            case 1:
+                deque.PushFrontRange(batch.begin(), batch.end());
+                expected.insert(expected.begin(), batch.begin(), batch.end());
+                break;
+            case 2:
+                count = std::min(count, expected.size());
+                deque.PopFrontN(count, std::back_inserter(popped));
+                ASSERT_TRUE(std::equal(popped.begin(), popped.end(), expected.begin()));
+                expected.erase(expected.begin(), expected.begin() + count);
+                break;
+            default:
+                count = std::min(count, expected.size());
+                deque.PopBackN(count, std::back_inserter(popped));
+                ASSERT_TRUE(std::equal(popped.begin(), popped.end(), expected.end() - count));
+                expected.erase(expected.end() - count, expected.end());
+        }
+        ASSERT_EQ(deque.Size(), expected.size());
+        if (!expected.empty()) {
+            ASSERT_EQ(deque.Front(), expected.front());
+            ASSERT_EQ(deque.Back(), expected.back());
+        }
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(deque[i], expected[i]);
+    }
+}
+
 TEST(RandomDequeTest, CustomType) {
     Deque<CustomType> deque;
     for (int i = 0; i < 10; ++i) {
@@ -3,17 +3,21 @@
 #include <cstdlib>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <optional>
 #include <utility>
 
 #include "exceptions.hpp"
 
-template <typename T>
+// Nodes come from Alloc rebound to the node type
+template <typename T, typename Alloc = std::allocator<T>>
 class ForwardList {
 private:
     class Node {
         friend class ForwardListIterator;
         friend class ForwardList;
+
+    public:
         explicit Node(const T& value) : data_(value), next_(nullptr){};
         Node() : data_(std::nullopt), next_(nullptr){};
 
@@ -78,6 +82,9 @@ public:
     ForwardList() : head_(nullptr) {
     }
 
+    explicit ForwardList(const Alloc& alloc) : alloc_(alloc), head_(nullptr) {
+    }
+
     explicit ForwardList(size_t sz) : ForwardList() {
         for (size_t i = 0; i < sz; ++i) {
             this->PushFront(typename std::optional<T>::value_type());
@@ -94,14 +101,16 @@ public:
         this->PushFront(*values.begin());
     }
 
-    ForwardList(const ForwardList& other) {
+    ForwardList(const ForwardList& other)
+        : alloc_(NodeAllocTraits::select_on_container_copy_construction(other.alloc_)) {
         if (other.head_ != nullptr) {
-            this->size_ = other.size_;
-            head_ = new Node(other.head_->data_.value());
+            head_ = this->CreateNode(other.head_->data_.value());
+            this->size_ = 1;
             Node* other_node = other.head_->next_;
             Node* current_node = head_;
             while (other_node != nullptr) {
-                current_node->next_ = new Node(other_node->data_.value());
+                current_node->next_ = this->CreateNode(other_node->data_.value());
+                ++this->size_;
                 current_node = current_node->next_;
                 other_node = other_node->next_;
             }
@@ -144,6 +153,8 @@ public:
         size_t tmp_size = this->size_;
         this->size_ = a.size_;
         a.size_ = tmp_size;
+
+        std::swap(this->alloc_, a.alloc_);
     }
 
     void EraseAfter(ForwardListIterator pos) {
@@ -153,12 +164,12 @@ public:
         }
         Node* tmp = node_in_pos->next_;
         node_in_pos->next_ = tmp->next_;
-        delete tmp;
+        this->DestroyNode(tmp);
         --size_;
     }
 
     void InsertAfter(ForwardListIterator pos, const T& value) {
-        Node* node_to_insert = new Node(value);
+        Node* node_to_insert = this->CreateNode(value);
         Node* node_in_pos = pos.GetNode();
 
         Node* tmp = node_in_pos->next_;
@@ -185,7 +196,7 @@ public:
     }
 
     void PushFront(const T& value) {
-        Node* new_node = new Node(value);
+        Node* new_node = this->CreateNode(value);
         new_node->next_ = head_;
         head_ = new_node;
         ++size_;
@@ -201,7 +212,7 @@ public:
             } else {
                 head_ = head_->next_;
             }
-            delete tmp_node;
+            this->DestroyNode(tmp_node);
         }
         --size_;
     }
@@ -210,20 +221,40 @@ public:
         Node* current_node = head_;
         while (current_node != nullptr) {
             Node* tmp_node = current_node->next_;
-            delete current_node;
+            this->DestroyNode(current_node);
             current_node = tmp_node;
         }
     }
 
 private:
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeAllocTraits = std::allocator_traits<NodeAlloc>;
+
+    Node* CreateNode(const T& value) {
+        Node* node = NodeAllocTraits::allocate(alloc_, 1);
+        try {
+            NodeAllocTraits::construct(alloc_, node, value);
+        } catch (...) {
+            NodeAllocTraits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void DestroyNode(Node* node) noexcept {
+        NodeAllocTraits::destroy(alloc_, node);
+        NodeAllocTraits::deallocate(alloc_, node, 1);
+    }
+
+    NodeAlloc alloc_;
     Node* head_ = nullptr;
     size_t size_ = 0;
 };
 
 namespace std {
 // Global swap overloading
-template <typename T>
-void Swap(ForwardList<T>& a, ForwardList<T>& b) {
+template <typename T, typename Alloc>
+void Swap(ForwardList<T, Alloc>& a, ForwardList<T, Alloc>& b) {
     a.Swap(b);
 }
 }  // namespace std
@@ -6,8 +6,10 @@
 #include <fmt/core.h>
 
 #include "../forward_list.hpp"
+#include "../../../vector/allocator/tracking_allocator.hpp"
 
-void ConstructRandomList(ForwardList<int>& list, int sz) {
+template <typename Alloc>
+void ConstructRandomList(ForwardList<int, Alloc>& list, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -19,7 +21,8 @@ void ConstructRandomList(ForwardList<int>& list, int sz) {
   }
 }
 
-void ConstructRandomList(std::forward_list<int>& list, int sz) {
+template <typename Alloc>
+void ConstructRandomList(std::forward_list<int, Alloc>& list, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -32,24 +35,57 @@ void ConstructRandomList(std::forward_list<int>& list, int sz) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// Each benchmark is registered a second time with TrackingAllocator nodes; only those runs report
+// allocs/iter and bytes/iter, counted over the whole iteration including paused setup
+using TrackedForwardList = ForwardList<int, TrackingAllocator<int>>;
+using TrackedStdForwardList = std::forward_list<int, TrackingAllocator<int>>;
+
+template <typename Container>
+constexpr bool kTracked = false;
+
+template <typename T, typename Inner>
+constexpr bool kTracked<ForwardList<T, TrackingAllocator<T, Inner>>> = true;
+
+template <typename T, typename Inner>
+constexpr bool kTracked<std::forward_list<T, TrackingAllocator<T, Inner>>> = true;
+
+template <typename Container>
+void ReportAllocations(benchmark::State& state, const AllocationStats& before) {
+  if constexpr (kTracked<Container>) {
+    AllocationStats after = AllocationTag::Untagged().Snapshot();
+    state.counters["allocs/iter"] = benchmark::Counter(static_cast<double>(after.allocations - before.allocations),
+                                                       benchmark::Counter::kAvgIterations);
+    state.counters["bytes/iter"] = benchmark::Counter(
+        static_cast<double>(after.bytes_allocated - before.bytes_allocated), benchmark::Counter::kAvgIterations);
+  }
+}
+
+template <typename ListType>
 void BM_CustomListPushFront(benchmark::State& state) {
-  ForwardList<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     ConstructRandomList(list, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListPushFront(benchmark::State& state) {
-  std::forward_list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     ConstructRandomList(list, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_CustomListMiddleInsert(benchmark::State& state) {
-  ForwardList<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   ConstructRandomList(list, 100);
   auto it = list.Begin();
   std::advance(it, 50);
@@ -59,10 +95,13 @@ void BM_CustomListMiddleInsert(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListMiddleInsert(benchmark::State& state) {
-  std::forward_list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   ConstructRandomList(list, 100);
   auto it = list.begin();
   std::advance(it, 50);
@@ -72,10 +111,13 @@ void BM_StdListMiddleInsert(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_CustomListErase(benchmark::State& state) {
-  ForwardList<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     state.PauseTiming();
     ConstructRandomList(list, state.range(0));
@@ -85,10 +127,13 @@ void BM_CustomListErase(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListErase(benchmark::State& state) {
-  std::forward_list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     state.PauseTiming();
     ConstructRandomList(list, state.range(0));
@@ -98,10 +143,13 @@ void BM_StdListErase(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_CustomListClear(benchmark::State& state) {
-  ForwardList<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     state.PauseTiming();
     ConstructRandomList(list, state.range(0));
@@ -109,10 +157,13 @@ void BM_CustomListClear(benchmark::State& state) {
     list.Clear();
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListClear(benchmark::State& state) {
-  std::forward_list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     state.PauseTiming();
     ConstructRandomList(list, state.range(0));
@@ -120,10 +171,13 @@ void BM_StdListClear(benchmark::State& state) {
     list.clear();
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_CustomListFind(benchmark::State& state) {
-  ForwardList<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -138,10 +192,13 @@ void BM_CustomListFind(benchmark::State& state) {
     list.Find(random_key);
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListFind(benchmark::State& state) {
-  std::forward_list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -156,19 +213,30 @@ void BM_StdListFind(benchmark::State& state) {
     std::find(list.begin(), list.end(), random_key);
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
 
-BENCHMARK(BM_CustomListPushFront)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListPushFront)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomListMiddleInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListMiddleInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomListErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomListClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomListFind)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListFind)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListPushFront, ForwardList<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListPushFront, TrackedForwardList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListPushFront, std::forward_list<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListPushFront, TrackedStdForwardList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListMiddleInsert, ForwardList<int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListMiddleInsert, TrackedForwardList)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListMiddleInsert, std::forward_list<int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListMiddleInsert, TrackedStdForwardList)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListErase, ForwardList<int>)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListErase, TrackedForwardList)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListErase, std::forward_list<int>)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListErase, TrackedStdForwardList)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListClear, ForwardList<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListClear, TrackedForwardList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListClear, std::forward_list<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListClear, TrackedStdForwardList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListFind, ForwardList<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListFind, TrackedForwardList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListFind, std::forward_list<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListFind, TrackedStdForwardList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
 
 
 BENCHMARK_MAIN();
\ No newline at end of file
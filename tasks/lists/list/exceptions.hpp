@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdexcept>
+
+class ListIsEmptyException : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
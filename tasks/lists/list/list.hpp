@@ -7,17 +7,21 @@
 #include <functional>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <optional>
 #include <utility>
 
 #include "exceptions.hpp"
 
-template <typename T>
+// Nodes, including the End() sentinel, come from Alloc rebound to the node type
+template <typename T, typename Alloc = std::allocator<T>>
 class List {
 private:
     class Node {
         friend class ListIterator;
         friend class List;
+
+    public:
         Node() : data_(std::nullopt), next_(nullptr), previous_(nullptr){};
         explicit Node(const T& value) : data_(value), next_(nullptr), previous_(nullptr){};
 
@@ -100,30 +104,16 @@ public:
 
 public:
     List() : head_(nullptr), tail_(nullptr) {
-        tail_next_ = new Node;
-        tail_next_->previous_ = tail_;
-    };
+    }
+
+    // For stateful allocators, e.g. PoolAllocator<T>
+    explicit List(const Alloc& alloc) : alloc_(alloc) {
+    }
 
     explicit List(size_t sz) {
         for (size_t i = 0; i < sz; ++i) {
-            Node* new_node = new Node(typename std::optional<T>::value_type());
-            if (head_ == nullptr) {
-                head_ = new_node;
-                tail_ = new_node;
-                if (tail_next_ == nullptr) {
-                    tail_next_ = new Node;
-                }
-                tail_->next_ = tail_next_;
-                tail_next_->previous_ = tail_;
-            } else {
-                new_node->previous_ = tail_;
-                tail_->next_ = new_node;
-                tail_ = new_node;
-            }
-            ++size_;
+            this->PushBack(typename std::optional<T>::value_type());
         }
-        tail_->next_ = tail_next_;
-        tail_next_->previous_ = tail_;
     }
 
     List(const std::initializer_list<T>& values) {
@@ -132,7 +122,7 @@ public:
         }
     }
 
-    List(const List& other) {
+    List(const List& other) : alloc_(NodeAllocTraits::select_on_container_copy_construction(other.alloc_)) {
         for (auto it = other.Begin(); it != other.End(); ++it) {
             this->PushBack(*it);
         }
@@ -177,6 +167,7 @@ public:
     inline size_t Size() const noexcept {
         return size_;
     }
+    // Swaps the allocators too, so every node is freed by the allocator that made it
     void Swap(List& a) {
         Node* tmp_head = this->head_;
         size_t tmp_size = this->size_;
@@ -188,6 +179,9 @@ public:
         Node* tmp_tail = this->tail_;
         this->tail_ = a.tail_;
         a.tail_ = tmp_tail;
+
+        std::swap(this->tail_next_, a.tail_next_);
+        std::swap(this->alloc_, a.alloc_);
     }
 
     ListIterator Find(const T& value) const {
@@ -212,76 +206,57 @@ public:
         if (node_in_current_pos == nullptr) {
             throw ListIsEmptyException("List is empty");
         }
-        if (this->Size() == 1) {
-            this->Clear();
-        } else if (node_in_current_pos->next_ == nullptr) {  // tail
+        if (node_in_current_pos == tail_) {
             this->PopBack();
-        } else if (node_in_current_pos->previous_ == nullptr) {  // head
+        } else if (node_in_current_pos == head_) {
             this->PopFront();
         } else {
             node_in_current_pos->previous_->next_ = node_in_current_pos->next_;
             node_in_current_pos->next_->previous_ = node_in_current_pos->previous_;
             --size_;
-            delete node_in_current_pos;
+            this->DestroyNode(node_in_current_pos);
         }
     }
 
+    // Inserts before pos
     void Insert(ListIterator pos, const T& value) {
-        Node* new_node = new Node(value);
         Node* node_in_current_pos = pos.GetNode();
-
-        if (this->IsEmpty()) {
-            head_ = new_node;
-            tail_ = new_node;
-            tail_next_ = new Node;
-            tail_->next_ = tail_next_;
-            tail_next_->previous_ = tail_;
-        } else if (node_in_current_pos->previous_ == nullptr) {
-            new_node->next_ = node_in_current_pos;
-            node_in_current_pos->previous_ = new_node;
-            head_ = new_node;
-        } else if (node_in_current_pos->next_ == nullptr) {
-            new_node->previous_ = node_in_current_pos;
-            node_in_current_pos->next_ = new_node;
-            tail_ = new_node;
-            delete tail_next_;
-            tail_next_ = new Node;
-            tail_->next_ = tail_next_;
-            tail_next_->previous_ = tail_;
-        } else {
-            new_node->previous_ = node_in_current_pos->previous_;
-            new_node->next_ = node_in_current_pos;
-            node_in_current_pos->previous_->next_ = new_node;
-            node_in_current_pos->previous_ = new_node;
+        if (this->IsEmpty() || node_in_current_pos == tail_next_) {
+            this->PushBack(value);
+            return;
         }
+        if (node_in_current_pos == head_) {
+            this->PushFront(value);
+            return;
+        }
+        Node* new_node = this->CreateNode(value);
+        new_node->previous_ = node_in_current_pos->previous_;
+        new_node->next_ = node_in_current_pos;
+        node_in_current_pos->previous_->next_ = new_node;
+        node_in_current_pos->previous_ = new_node;
         ++size_;
     }
 
+    // Keeps the End() sentinel
     void Clear() noexcept {
-        if (head_ == nullptr && tail_ == nullptr) {
-            return;
-        } else {
-            while (tail_ != nullptr) {
-                Node* node_to_delete = tail_;
-                tail_ = tail_->previous_;
-                delete node_to_delete;
-            }
+        while (tail_ != nullptr) {
+            Node* node_to_delete = tail_;
+            tail_ = tail_->previous_;
+            this->DestroyNode(node_to_delete);
         }
         head_ = nullptr;
-        tail_ = nullptr;
-        delete tail_next_;
-        tail_next_ = nullptr;
+        if (tail_next_ != nullptr) {
+            tail_next_->previous_ = nullptr;
+        }
         size_ = 0;
     }
 
     void PushBack(const T& value) {
-        Node* new_node = new Node(value);
+        this->EnsureSentinel();
+        Node* new_node = this->CreateNode(value);
         if (head_ == nullptr) {
             head_ = new_node;
             tail_ = new_node;
-            if (tail_next_ == nullptr) {
-                tail_next_ = new Node;
-            }
             tail_->next_ = tail_next_;
             tail_next_->previous_ = tail_;
         } else {
@@ -295,11 +270,11 @@ public:
     }
 
     void PushFront(const T& value) {
-        Node* new_node = new Node(value);
+        this->EnsureSentinel();
+        Node* new_node = this->CreateNode(value);
         if (head_ == nullptr) {
             head_ = new_node;
             tail_ = new_node;
-            tail_next_ = new Node;
             tail_->next_ = tail_next_;
             tail_next_->previous_ = tail_;
         } else {
@@ -314,21 +289,15 @@ public:
         if (head_ == nullptr) {
             throw ListIsEmptyException("List is empty");
         }
-        if (head_ == tail_) {
-            delete tail_;
-            tail_ = nullptr;
+        Node* tmp = tail_;
+        tail_ = tail_->previous_;
+        this->DestroyNode(tmp);
+        if (tail_ == nullptr) {
             head_ = nullptr;
-            delete tail_next_;
-            tail_next_ = nullptr;
         } else {
-            Node* tmp = tail_;
-            tail_ = tail_->previous_;
-            delete tmp;
-            delete tail_next_;
-            tail_next_ = new Node;
             tail_->next_ = tail_next_;
-            tail_next_->previous_ = tail_;
         }
+        tail_next_->previous_ = tail_;
         --size_;
     }
 
@@ -337,36 +306,52 @@ public:
             throw ListIsEmptyException("List is empty");
         }
         if (head_ == tail_) {
-            delete head_;
-            head_ = nullptr;
-            tail_ = nullptr;
-            delete tail_next_;
-            tail_next_ = nullptr;
-        } else {
-            head_ = head_->next_;
-            delete head_->previous_;
-            head_->previous_ = nullptr;
+            this->Clear();
+            return;
         }
+        head_ = head_->next_;
+        this->DestroyNode(head_->previous_);
+        head_->previous_ = nullptr;
         --size_;
     }
 
     ~List() {
-        Node* current_node = tail_;
-        while (current_node != nullptr) {
-            Node* tmp_node = current_node;
-            current_node = current_node->previous_;
-            delete tmp_node;
-        }
+        this->Clear();
         if (tail_next_ != nullptr) {
-            delete tail_next_;
+            this->DestroyNode(tail_next_);
         }
-        head_ = nullptr;
-        tail_ = nullptr;
         tail_next_ = nullptr;
-        size_ = 0;
     }
 
 private:
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeAllocTraits = std::allocator_traits<NodeAlloc>;
+
+    template <class... Args>
+    Node* CreateNode(const Args&... args) {
+        Node* node = NodeAllocTraits::allocate(alloc_, 1);
+        try {
+            NodeAllocTraits::construct(alloc_, node, args...);
+        } catch (...) {
+            NodeAllocTraits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void DestroyNode(Node* node) noexcept {
+        NodeAllocTraits::destroy(alloc_, node);
+        NodeAllocTraits::deallocate(alloc_, node, 1);
+    }
+
+    // The sentinel lives from the first insertion until the destructor, so PopBack never reallocates it
+    void EnsureSentinel() {
+        if (tail_next_ == nullptr) {
+            tail_next_ = this->CreateNode();
+        }
+    }
+
+    NodeAlloc alloc_;
     Node* head_ = nullptr;
     Node* tail_ = nullptr;
     Node* tail_next_ = nullptr;
@@ -375,9 +360,9 @@ private:
 
 namespace std {
 // Global swap overloading
-template <typename T>
+template <typename T, typename Alloc>
 // NOLINTNEXTLINE
-void swap(List<T>& a, List<T>& b) {
+void swap(List<T, Alloc>& a, List<T, Alloc>& b) {
     a.Swap(b);
 }
 }  // namespace std
@@ -6,8 +6,11 @@
 #include <fmt/core.h>
 
 #include "../list.hpp"
+#include "../../../vector/allocator/pool_allocator.hpp"
+#include "../../../vector/allocator/tracking_allocator.hpp"
 
-void ConstructRandomList(List<int>& list, int sz) {
+template <typename Alloc>
+void ConstructRandomList(List<int, Alloc>& list, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -19,7 +22,8 @@ void ConstructRandomList(List<int>& list, int sz) {
   }
 }
 
-void ConstructRandomList(std::list<int>& list, int sz) {
+template <typename Alloc>
+void ConstructRandomList(std::list<int, Alloc>& list, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -32,24 +36,58 @@ void ConstructRandomList(std::list<int>& list, int sz) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// Every benchmark also runs on a list that allocates its nodes through TrackingAllocator and reports
+// allocs/iter and bytes/iter, so the untracked timings stay comparable with earlier runs. The counters
+// cover the whole iteration, paused setup included.
+using TrackedList = List<int, TrackingAllocator<int>>;
+using TrackedStdList = std::list<int, TrackingAllocator<int>>;
+
+template <typename Container>
+constexpr bool kTracked = false;
+
+template <typename T, typename Inner>
+constexpr bool kTracked<List<T, TrackingAllocator<T, Inner>>> = true;
+
+template <typename T, typename Inner>
+constexpr bool kTracked<std::list<T, TrackingAllocator<T, Inner>>> = true;
+
+template <typename Container>
+void ReportAllocations(benchmark::State& state, const AllocationStats& before) {
+  if constexpr (kTracked<Container>) {
+    AllocationStats after = AllocationTag::Untagged().Snapshot();
+    state.counters["allocs/iter"] = benchmark::Counter(static_cast<double>(after.allocations - before.allocations),
+                                                       benchmark::Counter::kAvgIterations);
+    state.counters["bytes/iter"] = benchmark::Counter(
+        static_cast<double>(after.bytes_allocated - before.bytes_allocated), benchmark::Counter::kAvgIterations);
+  }
+}
+
+template <typename ListType>
 void BM_CustomListPushBack(benchmark::State& state) {
-  List<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     ConstructRandomList(list, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListPushBack(benchmark::State& state) {
-  std::list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     ConstructRandomList(list, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_CustomListMiddleInsert(benchmark::State& state) {
-  List<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   ConstructRandomList(list, 100);
   auto it = list.Begin();
   std::advance(it, 50);
@@ -59,10 +97,13 @@ void BM_CustomListMiddleInsert(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListMiddleInsert(benchmark::State& state) {
-  std::list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   ConstructRandomList(list, 100);
   auto it = list.begin();
   std::advance(it, 50);
@@ -72,10 +113,13 @@ void BM_StdListMiddleInsert(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_CustomListErase(benchmark::State& state) {
-  List<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     ConstructRandomList(list, state.range(0));
     for (int64_t i = 0; i < state.range(0); ++i) {
@@ -83,10 +127,13 @@ void BM_CustomListErase(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListErase(benchmark::State& state) {
-  std::list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     ConstructRandomList(list, state.range(0));
     for (int64_t i = 0; i < state.range(0); ++i) {
@@ -94,28 +141,37 @@ void BM_StdListErase(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_CustomListClear(benchmark::State& state) {
-  List<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     ConstructRandomList(list, state.range(0));
     list.Clear();
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListClear(benchmark::State& state) {
-  std::list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   for (auto _ : state) {
     ConstructRandomList(list, state.range(0));
     list.clear();
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_CustomListFind(benchmark::State& state) {
-  List<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -126,10 +182,13 @@ void BM_CustomListFind(benchmark::State& state) {
     list.Find(random_key);
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
 void BM_StdListFind(benchmark::State& state) {
-  std::list<int> list;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -140,19 +199,69 @@ void BM_StdListFind(benchmark::State& state) {
     std::ignore = std::find(list.begin(), list.end(), random_key);
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<ListType>(state, before);
+}
+
+// Heap vs pool nodes: build and clear, then a queue that keeps its size while every node is replaced
+template <typename ListType>
+void BM_ListPushBackClear(benchmark::State& state) {
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      list.PushBack(static_cast<int>(i));
+    }
+    list.Clear();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportAllocations<ListType>(state, before);
 }
 
+template <typename ListType>
+void BM_ListQueueChurn(benchmark::State& state) {
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  ListType list;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    list.PushBack(static_cast<int>(i));
+  }
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      list.PopFront();
+      list.PushBack(static_cast<int>(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportAllocations<ListType>(state, before);
+}
 
-BENCHMARK(BM_CustomListPushBack)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListPushBack)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomListMiddleInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListMiddleInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomListErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomListClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomListFind)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdListFind)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListPushBack, List<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListPushBack, TrackedList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListPushBack, std::list<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListPushBack, TrackedStdList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListMiddleInsert, List<int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListMiddleInsert, TrackedList)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListMiddleInsert, std::list<int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListMiddleInsert, TrackedStdList)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListErase, List<int>)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListErase, TrackedList)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListErase, std::list<int>)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListErase, TrackedStdList)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListClear, List<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListClear, TrackedList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListClear, std::list<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListClear, TrackedStdList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListFind, List<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomListFind, TrackedList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListFind, std::list<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdListFind, TrackedStdList)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ListPushBackClear, List<int>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ListPushBackClear, List<int, PoolAllocator<int>>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ListPushBackClear, TrackedList)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ListPushBackClear, List<int, TrackingAllocator<int, PoolAllocator<int>>>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ListQueueChurn, List<int>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ListQueueChurn, List<int, PoolAllocator<int>>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ListQueueChurn, TrackedList)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ListQueueChurn, List<int, TrackingAllocator<int, PoolAllocator<int>>>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
 
 
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <exception>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -21,18 +22,20 @@ public:
 private:
     std::string_view error_message_;
 };
-template <typename Key, typename Value, typename Compare = std::less<Key>>
-
 // We use the 'const key' in a std::pair,
 // because we don't have the right to change the key,
 // the tree will cease to be ordered -> UB
 
+// Nodes come from Alloc rebound to the node type
+template <typename Key, typename Value, typename Compare = std::less<Key>,
+          typename Alloc = std::allocator<std::pair<const Key, Value>>>
 class Map {
 
 private:
     class Node {
         friend class Map;
 
+    public:
         explicit Node(std::pair<const Key, Value> node)
             : key_(node.first), value_(node.second), left_(nullptr), right_(nullptr){};
 
@@ -47,6 +50,9 @@ public:
     Map() : root_(nullptr), size_(0), comp_() {
     }
 
+    explicit Map(const Alloc& alloc) : root_(nullptr), size_(0), comp_(), alloc_(alloc) {
+    }
+
     Value& operator[](const Key& key) {
         Node* current = FindNode(key);
         if (current) {  // if key already exists, update value
@@ -81,6 +87,8 @@ public:
 
         this->root_ = tmp_root;
         this->size_ = tmp_size;
+
+        std::swap(this->alloc_, a.alloc_);
     }
 
     Node* FindMinNode(Node* node) {  // Find min node in right subtree
@@ -125,7 +133,7 @@ public:
 
     void Insert(const std::pair<const Key, Value>& val) {
         if (root_ == nullptr) {
-            root_ = new Node(val);
+            root_ = this->CreateNode(val);
             ++size_;
             return;
         }
@@ -133,7 +141,7 @@ public:
         while (true) {
             if (comp_(val.first, current->key_)) {
                 if (current->left_ == nullptr) {
-                    current->left_ = new Node(val);
+                    current->left_ = this->CreateNode(val);
                     ++size_;
                     break;
                 } else {
@@ -141,7 +149,7 @@ public:
                 }
             } else {
                 if (current->right_ == nullptr) {
-                    current->right_ = new Node(val);
+                    current->right_ = this->CreateNode(val);
                     ++size_;
                     break;
                 } else {
@@ -192,7 +200,7 @@ public:
             } else {
                 parent->right_ = nullptr;
             }
-            delete current;
+            this->DestroyNode(current);
             --size_;
             return;
         }
@@ -205,7 +213,7 @@ public:
             } else {
                 parent->right_ = current->left_;
             }
-            delete current;
+            this->DestroyNode(current);
             --size_;
             return;
         }
@@ -218,21 +226,19 @@ public:
             } else {
                 parent->right_ = current->right_;
             }
-            delete current;
+            this->DestroyNode(current);
             --size_;
             return;
         }
 
         if ((current->left_ != nullptr && current->right_ != nullptr)) {
             Node* min_node = FindMinNode(current->right_);
-            Node* node_to_replace = new Node({min_node->key_, min_node->value_});
-
-            if (current->right_ == min_node) {
-                node_to_replace->right_ = min_node->right_;
-            }
-            node_to_replace->left_ = current->left_;
+            Node* node_to_replace = this->CreateNode({min_node->key_, min_node->value_});
 
+            // Unlinks min_node from current's right subtree, which may replace current->right_
             this->Erase(min_node->key_);
+            node_to_replace->left_ = current->left_;
+            node_to_replace->right_ = current->right_;
 
             if (parent == nullptr) {
                 root_ = node_to_replace;
@@ -241,7 +247,7 @@ public:
             } else {
                 parent->right_ = node_to_replace;
             }
-            delete current;
+            this->DestroyNode(current);
         }
     }
 
@@ -251,7 +257,7 @@ public:
         }
         Clear(node->left_);
         Clear(node->right_);
-        delete node;
+        this->DestroyNode(node);
     }
 
     void Clear() noexcept {
@@ -302,16 +308,36 @@ public:
     }
 
 private:
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeAllocTraits = std::allocator_traits<NodeAlloc>;
+
+    Node* CreateNode(const std::pair<const Key, Value>& val) {
+        Node* node = NodeAllocTraits::allocate(alloc_, 1);
+        try {
+            NodeAllocTraits::construct(alloc_, node, val);
+        } catch (...) {
+            NodeAllocTraits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void DestroyNode(Node* node) noexcept {
+        NodeAllocTraits::destroy(alloc_, node);
+        NodeAllocTraits::deallocate(alloc_, node, 1);
+    }
+
     Node* root_ = nullptr;
     size_t size_ = 0;
     Compare comp_;
+    NodeAlloc alloc_;
 };
 
 namespace std {
 // Global swap overloading
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Compare, typename Alloc>
 // NOLINTNEXTLINE
-void swap(Map<Key, Value>& a, Map<Key, Value>& b) {
+void swap(Map<Key, Value, Compare, Alloc>& a, Map<Key, Value, Compare, Alloc>& b) {
     a.Swap(b);
 }
 }  // namespace std
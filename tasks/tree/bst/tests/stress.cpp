@@ -1,13 +1,17 @@
 #include <random>
 #include <map>
+#include <numeric>
 #include <string>
 
 #include <benchmark/benchmark.h>
 #include <fmt/core.h>
 
 #include "../map.hpp"
+#include "../../../vector/allocator/pool_allocator.hpp"
+#include "../../../vector/allocator/tracking_allocator.hpp"
 
-void ConstructRandomMap(Map<int, int>& mp, int sz) {
+template <typename Compare, typename Alloc>
+void ConstructRandomMap(Map<int, int, Compare, Alloc>& mp, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -19,7 +23,8 @@ void ConstructRandomMap(Map<int, int>& mp, int sz) {
   }
 }
 
-void ConstructRandomMap(std::map<int, int>& mp, int sz) {
+template <typename Compare, typename Alloc>
+void ConstructRandomMap(std::map<int, int, Compare, Alloc>& mp, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -31,14 +36,16 @@ void ConstructRandomMap(std::map<int, int>& mp, int sz) {
   }
 }
 
-void ConstructLinearMap(Map<int, int>& mp, int sz) {
+template <typename Compare, typename Alloc>
+void ConstructLinearMap(Map<int, int, Compare, Alloc>& mp, int sz) {
   while(sz) {
     mp.Insert(std::pair{sz, 1});
     --sz;
   }
 }
 
-void ConstructLinearMap(std::map<int, int>& mp, int sz) {
+template <typename Compare, typename Alloc>
+void ConstructLinearMap(std::map<int, int, Compare, Alloc>& mp, int sz) {
   while(sz) {
     mp.insert(std::pair{sz, 1});
     --sz;
@@ -46,40 +53,80 @@ void ConstructLinearMap(std::map<int, int>& mp, int sz) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// Tracked variants, registered next to the plain ones, allocate their nodes through TrackingAllocator
+// and report allocs/iter and bytes/iter for the whole iteration, paused setup included
+using MapEntry = std::pair<const int, int>;
+using TrackedMap = Map<int, int, std::less<int>, TrackingAllocator<MapEntry>>;
+using TrackedStdMap = std::map<int, int, std::less<int>, TrackingAllocator<MapEntry>>;
+
+template <typename Container>
+constexpr bool kTracked = false;
+
+template <typename Key, typename Value, typename Compare, typename Inner>
+constexpr bool kTracked<Map<Key, Value, Compare, TrackingAllocator<std::pair<const Key, Value>, Inner>>> = true;
+
+template <typename Key, typename Value, typename Compare, typename Inner>
+constexpr bool kTracked<std::map<Key, Value, Compare, TrackingAllocator<std::pair<const Key, Value>, Inner>>> = true;
+
+template <typename Container>
+void ReportAllocations(benchmark::State& state, const AllocationStats& before) {
+  if constexpr (kTracked<Container>) {
+    AllocationStats after = AllocationTag::Untagged().Snapshot();
+    state.counters["allocs/iter"] = benchmark::Counter(static_cast<double>(after.allocations - before.allocations),
+                                                       benchmark::Counter::kAvgIterations);
+    state.counters["bytes/iter"] = benchmark::Counter(
+        static_cast<double>(after.bytes_allocated - before.bytes_allocated), benchmark::Counter::kAvgIterations);
+  }
+}
+
+template <typename MapType>
 void BM_CustomMapRandomInsert(benchmark::State& state) {
-  Map<int, int> mp;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  MapType mp;
   for (auto _ : state) {
     ConstructRandomMap(mp, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<MapType>(state, before);
 }
 
+template <typename MapType>
 void BM_StdMapRandomInsert(benchmark::State& state) {
-  std::map<int, int> mp;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  MapType mp;
   for (auto _ : state) {
     ConstructRandomMap(mp, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<MapType>(state, before);
 }
 
+template <typename MapType>
 void BM_CustomMapLinearInsert(benchmark::State& state) {
-  Map<int, int> mp;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  MapType mp;
   for (auto _ : state) {
     ConstructLinearMap(mp, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<MapType>(state, before);
 }
 
+template <typename MapType>
 void BM_StdMapLinearInsert(benchmark::State& state) {
-  std::map<int, int> mp;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  MapType mp;
   for (auto _ : state) {
     ConstructLinearMap(mp, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<MapType>(state, before);
 }
 
+template <typename MapType>
 void BM_CustomMapErase(benchmark::State& state) {
-  Map<int, int> mp;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  MapType mp;
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -98,10 +145,13 @@ void BM_CustomMapErase(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<MapType>(state, before);
 }
 
+template <typename MapType>
 void BM_StdMapErase(benchmark::State& state) {
-  std::map<int, int> mp;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  MapType mp;
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -120,10 +170,13 @@ void BM_StdMapErase(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<MapType>(state, before);
 }
 
+template <typename MapType>
 void BM_CustomMapClear(benchmark::State& state) {
-  Map<int, int> mp;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  MapType mp;
   for (auto _ : state) {
     state.PauseTiming();
     ConstructRandomMap(mp, state.range(0));
@@ -131,10 +184,13 @@ void BM_CustomMapClear(benchmark::State& state) {
     mp.Clear();
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<MapType>(state, before);
 }
 
+template <typename MapType>
 void BM_StdMapClear(benchmark::State& state) {
-  std::map<int, int> mp;
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  MapType mp;
   for (auto _ : state) {
     state.PauseTiming();
     ConstructRandomMap(mp, state.range(0));
@@ -142,16 +198,51 @@ void BM_StdMapClear(benchmark::State& state) {
     mp.clear();
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<MapType>(state, before);
 }
 
 
-BENCHMARK(BM_CustomMapRandomInsert)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdMapRandomInsert)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomMapLinearInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdMapLinearInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomMapErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdMapErase)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomMapClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdMapClear)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+// Heap vs pool nodes: distinct keys in random order, a round of erases, then Clear
+template <typename MapType>
+void BM_MapNodeChurn(benchmark::State& state) {
+  AllocationStats before = AllocationTag::Untagged().Snapshot();
+  std::vector<int> keys(state.range(0));
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  MapType mp;
+  for (auto _ : state) {
+    for (int key : keys) {
+      mp.Insert(std::pair{key, 1});
+    }
+    for (size_t i = 0; i < keys.size(); i += 4) {
+      mp.Erase(keys[i]);
+    }
+    mp.Clear();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportAllocations<MapType>(state, before);
+}
+
+BENCHMARK_TEMPLATE(BM_CustomMapRandomInsert, Map<int, int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomMapRandomInsert, TrackedMap)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdMapRandomInsert, std::map<int, int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdMapRandomInsert, TrackedStdMap)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomMapLinearInsert, Map<int, int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomMapLinearInsert, TrackedMap)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdMapLinearInsert, std::map<int, int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdMapLinearInsert, TrackedStdMap)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomMapErase, Map<int, int>)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomMapErase, TrackedMap)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdMapErase, std::map<int, int>)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdMapErase, TrackedStdMap)->Range(1<<10, 1<<17)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomMapClear, Map<int, int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomMapClear, TrackedMap)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdMapClear, std::map<int, int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdMapClear, TrackedStdMap)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_MapNodeChurn, Map<int, int>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MapNodeChurn, Map<int, int, std::less<int>, PoolAllocator<std::pair<const int, int>>>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MapNodeChurn, TrackedMap)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MapNodeChurn, Map<int, int, std::less<int>, TrackingAllocator<MapEntry, PoolAllocator<MapEntry>>>)->Range(1<<10, 1<<20)->Unit(benchmark::kMillisecond);
 
 BENCHMARK_MAIN();
\ No newline at end of file
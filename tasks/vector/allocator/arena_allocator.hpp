@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bump allocator over geometrically growing chunks. Memory comes back only all at once:
+// Reset() keeps a single chunk for reuse, large enough for everything allocated before it.
+class Arena {
+public:
+    explicit Arena(size_t first_chunk = 64 * 1024) : next_chunk_(first_chunk) {
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other) noexcept
+        : head_(std::exchange(other.head_, nullptr)),
+          cur_(std::exchange(other.cur_, nullptr)),
+          end_(std::exchange(other.end_, nullptr)),
+          next_chunk_(other.next_chunk_),
+          chunks_(std::exchange(other.chunks_, 0)) {
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            this->FreeChunks(nullptr);
+            head_ = std::exchange(other.head_, nullptr);
+            cur_ = std::exchange(other.cur_, nullptr);
+            end_ = std::exchange(other.end_, nullptr);
+            next_chunk_ = other.next_chunk_;
+            chunks_ = std::exchange(other.chunks_, 0);
+        }
+        return *this;
+    }
+
+    void* Allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        void* ptr = cur_;
+        size_t space = end_ - cur_;
+        if (cur_ == nullptr || std::align(align, bytes, ptr, space) == nullptr) {
+            this->AddChunk(bytes + align);
+            ptr = cur_;
+            space = end_ - cur_;
+            std::align(align, bytes, ptr, space);
+        }
+        cur_ = static_cast<char*>(ptr) + bytes;
+        return ptr;
+    }
+
+    // O(chunks): every allocation made so far becomes invalid. Several chunks are merged into one,
+    // so a workload that repeats between resets stops touching malloc after the first round.
+    void Reset() noexcept {
+        if (head_ == nullptr) {
+            return;
+        }
+        if (head_->prev != nullptr) {
+            size_t total = 0;
+            for (Chunk* chunk = head_; chunk != nullptr; chunk = chunk->prev) {
+                total += chunk->bytes;
+            }
+            this->FreeChunks(nullptr);
+            try {
+                this->AddChunk(total - sizeof(Chunk));
+            } catch (const std::bad_alloc&) {
+                return;  // the next Allocate starts from scratch
+            }
+        }
+        cur_ = reinterpret_cast<char*>(head_ + 1);
+    }
+
+    size_t ChunkCount() const noexcept {
+        return chunks_;
+    }
+
+    ~Arena() {
+        this->FreeChunks(nullptr);
+    }
+
+private:
+    struct Chunk {
+        Chunk* prev;
+        size_t bytes;
+    };
+
+    void AddChunk(size_t min_bytes) {
+        size_t bytes = next_chunk_ > min_bytes + sizeof(Chunk) ? next_chunk_ : min_bytes + sizeof(Chunk);
+        auto* chunk = static_cast<Chunk*>(std::malloc(bytes));
+        if (chunk == nullptr) {
+            throw std::bad_alloc();
+        }
+        *chunk = Chunk{head_, bytes};
+        head_ = chunk;
+        cur_ = reinterpret_cast<char*>(chunk + 1);
+        end_ = reinterpret_cast<char*>(chunk) + bytes;
+        next_chunk_ = bytes * 2;
+        ++chunks_;
+    }
+
+    // Frees the chunks behind keep (all of them for nullptr)
+    void FreeChunks(Chunk* keep) noexcept {
+        Chunk* chunk = keep != nullptr ? keep->prev : head_;
+        while (chunk != nullptr) {
+            Chunk* prev = chunk->prev;
+            std::free(chunk);
+            chunk = prev;
+            --chunks_;
+        }
+        if (keep != nullptr) {
+            keep->prev = nullptr;
+        } else {
+            head_ = nullptr;
+            cur_ = end_ = nullptr;
+        }
+    }
+
+    Chunk* head_ = nullptr;
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+    size_t next_chunk_;
+    size_t chunks_ = 0;
+};
+
+// Standard allocator over an Arena it does not own: deallocate is a no-op and the memory of every
+// container built on the arena comes back at once with Reset(). Copies and rebinds share the arena.
+// A default-constructed allocator is unbound and only exists because containers assign their
+// allocator after default-constructing it; allocating from it throws std::bad_alloc.
+template <typename T>
+class ArenaAllocator {
+public:
+    // NOLINTNEXTLINE
+    using value_type = T;
+
+    ArenaAllocator() = default;
+
+    explicit ArenaAllocator(Arena& arena) noexcept : arena_(&arena) {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.GetArena()) {  // NOLINT
+    }
+
+    // NOLINTNEXTLINE
+    T* allocate(size_t count) {
+        if (arena_ == nullptr || count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // NOLINTNEXTLINE
+    void deallocate(T* /*ptr*/, size_t /*count*/) noexcept {
+    }
+
+    // Frees everything allocated through any allocator sharing this arena
+    void Reset() noexcept {
+        if (arena_ != nullptr) {
+            arena_->Reset();
+        }
+    }
+
+    Arena* GetArena() const noexcept {
+        return arena_;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ == other.GetArena();
+    }
+
+private:
+    Arena* arena_ = nullptr;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Anonymous mappings aligned to and rounded up to whole 2 MB huge pages and marked MADV_HUGEPAGE, so
+// the kernel backs them with transparent huge pages and random access over them needs one TLB entry
+// per 2 MB instead of per 4 KB. When huge pages are disabled or none are free the same mapping simply
+// stays on normal pages.
+class HugePages {
+public:
+    static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+    static size_t RoundUp(size_t bytes) noexcept {
+        return (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    }
+
+    // Throws std::bad_alloc when the mapping fails
+    static void* Map(size_t bytes) {
+        size_t size = RoundUp(bytes);
+        if (size < bytes || size + kHugePageSize < size) {
+            throw std::bad_alloc();
+        }
+        // mmap only promises 4 KB alignment: map one huge page more and trim both ends
+        void* raw = ::mmap(nullptr, size + kHugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto begin = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (begin + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+        if (aligned != begin) {
+            ::munmap(raw, aligned - begin);
+        }
+        size_t tail = begin + size + kHugePageSize - (aligned + size);
+        if (tail != 0) {
+            ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+        }
+        auto* ptr = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+        ::madvise(ptr, size, MADV_HUGEPAGE);  // advisory: failure leaves normal pages
+#endif
+        return ptr;
+    }
+
+    // bytes must be the size passed to Map
+    static void Unmap(void* ptr, size_t bytes) noexcept {
+        ::munmap(ptr, RoundUp(bytes));
+    }
+};
+
+// Requests of at least Threshold bytes go to HugePages, smaller ones to Upstream. The decision only
+// depends on the size, so deallocate finds the right place without bookkeeping. Meant for the large
+// buffers of Vector and Deque; with the default threshold a request below one huge page never
+// wastes the rest of one.
+template <typename T, typename Upstream = std::allocator<T>, size_t Threshold = HugePages::kHugePageSize>
+class HugePageAllocator {
+    using UpstreamTraits = std::allocator_traits<Upstream>;
+
+    static_assert(alignof(T) <= HugePages::kHugePageSize);
+
+public:
+    // NOLINTNEXTLINE
+    using value_type = T;
+    // NOLINTNEXTLINE
+    using propagate_on_container_copy_assignment = typename UpstreamTraits::propagate_on_container_copy_assignment;
+    // NOLINTNEXTLINE
+    using propagate_on_container_move_assignment = typename UpstreamTraits::propagate_on_container_move_assignment;
+    // NOLINTNEXTLINE
+    using propagate_on_container_swap = typename UpstreamTraits::propagate_on_container_swap;
+    // NOLINTNEXTLINE
+    using is_always_equal = typename UpstreamTraits::is_always_equal;
+
+    template <typename U>
+    // NOLINTNEXTLINE
+    struct rebind {
+        using other = HugePageAllocator<U, typename UpstreamTraits::template rebind_alloc<U>, Threshold>;
+    };
+
+    HugePageAllocator() = default;
+
+    explicit HugePageAllocator(const Upstream& upstream) : upstream_(upstream) {
+    }
+
+    template <typename U, typename OtherUpstream>
+    HugePageAllocator(const HugePageAllocator<U, OtherUpstream, Threshold>& other)  // NOLINT
+        : upstream_(other.GetUpstream()) {
+    }
+
+    // NOLINTNEXTLINE
+    T* allocate(size_t count) {
+        if (IsHuge(count)) {
+            if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+                throw std::bad_array_new_length();
+            }
+            return static_cast<T*>(HugePages::Map(count * sizeof(T)));
+        }
+        return UpstreamTraits::allocate(upstream_, count);
+    }
+
+    // NOLINTNEXTLINE
+    void deallocate(T* ptr, size_t count) noexcept {
+        if (IsHuge(count)) {
+            HugePages::Unmap(ptr, count * sizeof(T));
+            return;
+        }
+        UpstreamTraits::deallocate(upstream_, ptr, count);
+    }
+
+    // NOLINTNEXTLINE
+    HugePageAllocator select_on_container_copy_construction() const {
+        return HugePageAllocator(UpstreamTraits::select_on_container_copy_construction(upstream_));
+    }
+
+    static bool IsHuge(size_t count) noexcept {
+        return count >= (Threshold + sizeof(T) - 1) / sizeof(T);
+    }
+
+    const Upstream& GetUpstream() const noexcept {
+        return upstream_;
+    }
+
+    template <typename U, typename OtherUpstream>
+    bool operator==(const HugePageAllocator<U, OtherUpstream, Threshold>& other) const noexcept {
+        return upstream_ == other.GetUpstream();
+    }
+
+private:
+    Upstream upstream_;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Bump allocation over a buffer somebody else owns. Freeing the most recent allocation gives its
+// bytes back, anything else is only reclaimed by Reset(). Allocate returns nullptr when the buffer
+// is full, the caller decides where to go instead.
+class InlineBuffer {
+public:
+    InlineBuffer(const InlineBuffer&) = delete;
+    InlineBuffer& operator=(const InlineBuffer&) = delete;
+
+    void* Allocate(size_t bytes, size_t align) noexcept {
+        void* ptr = cur_;
+        size_t space = end_ - cur_;
+        if (std::align(align, bytes, ptr, space) == nullptr) {
+            return nullptr;
+        }
+        cur_ = static_cast<char*>(ptr) + bytes;
+        return ptr;
+    }
+
+    void Deallocate(void* ptr, size_t bytes) noexcept {
+        if (static_cast<char*>(ptr) + bytes == cur_) {
+            cur_ = static_cast<char*>(ptr);
+        }
+    }
+
+    bool Owns(const void* ptr) const noexcept {
+        auto address = reinterpret_cast<uintptr_t>(ptr);
+        return reinterpret_cast<uintptr_t>(begin_) <= address && address < reinterpret_cast<uintptr_t>(end_);
+    }
+
+    // Every allocation served from the buffer becomes invalid
+    void Reset() noexcept {
+        cur_ = begin_;
+    }
+
+    size_t Used() const noexcept {
+        return cur_ - begin_;
+    }
+
+    size_t Capacity() const noexcept {
+        return end_ - begin_;
+    }
+
+protected:
+    InlineBuffer(char* begin, size_t bytes) noexcept : begin_(begin), cur_(begin), end_(begin + bytes) {
+    }
+
+    ~InlineBuffer() = default;
+
+private:
+    char* begin_;
+    char* cur_;
+    char* end_;
+};
+
+// An InlineBuffer with its storage inside: put it on the stack next to the scratch containers
+// that use it, e.g. InlineArena<4096> arena; Vector<int, InlineAllocator<int>> scratch(arena);
+template <size_t Bytes, size_t Align = alignof(std::max_align_t)>
+class InlineArena : public InlineBuffer {
+public:
+    InlineArena() noexcept : InlineBuffer(storage_, Bytes) {
+    }
+
+private:
+    alignas(Align) char storage_[Bytes];
+};
+
+// Standard allocator that serves requests from an InlineBuffer while it has room and from Upstream
+// otherwise. Copies and rebinds share the buffer. The buffer stays with the container: it is not
+// propagated on assignment or swap, and a copied container starts on Upstream alone, since a copy
+// is the usual way for scratch data to leave the function that owns the buffer.
+template <typename T, typename Upstream = std::allocator<T>>
+class InlineAllocator {
+    using UpstreamTraits = std::allocator_traits<Upstream>;
+
+public:
+    // NOLINTNEXTLINE
+    using value_type = T;
+    // NOLINTNEXTLINE
+    using propagate_on_container_copy_assignment = std::false_type;
+    // NOLINTNEXTLINE
+    using propagate_on_container_move_assignment = std::false_type;
+    // NOLINTNEXTLINE
+    using propagate_on_container_swap = std::false_type;
+
+    template <typename U>
+    // NOLINTNEXTLINE
+    struct rebind {
+        using other = InlineAllocator<U, typename UpstreamTraits::template rebind_alloc<U>>;
+    };
+
+    InlineAllocator() = default;
+
+    InlineAllocator(InlineBuffer& buffer, const Upstream& upstream = Upstream()) noexcept  // NOLINT
+        : buffer_(&buffer), upstream_(upstream) {
+    }
+
+    template <typename U, typename OtherUpstream>
+    InlineAllocator(const InlineAllocator<U, OtherUpstream>& other)  // NOLINT
+        : buffer_(other.GetBuffer()), upstream_(other.GetUpstream()) {
+    }
+
+    // NOLINTNEXTLINE
+    T* allocate(size_t count) {
+        if (buffer_ != nullptr && count <= std::numeric_limits<size_t>::max() / sizeof(T)) {
+            if (void* ptr = buffer_->Allocate(count * sizeof(T), alignof(T))) {
+                return static_cast<T*>(ptr);
+            }
+        }
+        return UpstreamTraits::allocate(upstream_, count);
+    }
+
+    // NOLINTNEXTLINE
+    void deallocate(T* ptr, size_t count) noexcept {
+        if (buffer_ != nullptr && buffer_->Owns(ptr)) {
+            buffer_->Deallocate(ptr, count * sizeof(T));
+            return;
+        }
+        UpstreamTraits::deallocate(upstream_, ptr, count);
+    }
+
+    // NOLINTNEXTLINE
+    InlineAllocator select_on_container_copy_construction() const {
+        InlineAllocator copy;
+        copy.upstream_ = UpstreamTraits::select_on_container_copy_construction(upstream_);
+        return copy;
+    }
+
+    InlineBuffer* GetBuffer() const noexcept {
+        return buffer_;
+    }
+
+    const Upstream& GetUpstream() const noexcept {
+        return upstream_;
+    }
+
+    template <typename U, typename OtherUpstream>
+    bool operator==(const InlineAllocator<U, OtherUpstream>& other) const noexcept {
+        return buffer_ == other.GetBuffer() && upstream_ == other.GetUpstream();
+    }
+
+private:
+    InlineBuffer* buffer_ = nullptr;
+    Upstream upstream_;
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "arena_allocator.hpp"
+#include "pool_allocator.hpp"
+
+// Where a PolymorphicAllocator gets its memory, chosen at runtime. The container type stays the
+// same whatever the resource is; the price is an indirect call per allocation.
+class MemoryResource {
+public:
+    virtual ~MemoryResource() = default;
+
+    void* Allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        return this->DoAllocate(bytes, align);
+    }
+
+    // bytes and align must be the ones passed to Allocate
+    void Deallocate(void* ptr, size_t bytes, size_t align = alignof(std::max_align_t)) noexcept {
+        this->DoDeallocate(ptr, bytes, align);
+    }
+
+    // Memory allocated from one resource may be deallocated through the other
+    bool IsEqual(const MemoryResource& other) const noexcept {
+        return this == &other || this->DoIsEqual(other);
+    }
+
+private:
+    virtual void* DoAllocate(size_t bytes, size_t align) = 0;
+    virtual void DoDeallocate(void* ptr, size_t bytes, size_t align) noexcept = 0;
+
+    virtual bool DoIsEqual(const MemoryResource& /*other*/) const noexcept {
+        return false;
+    }
+};
+
+// Aligned operator new and delete
+class NewDeleteResource : public MemoryResource {
+private:
+    void* DoAllocate(size_t bytes, size_t align) override {
+        return ::operator new(bytes, std::align_val_t(align));
+    }
+
+    void DoDeallocate(void* ptr, size_t /*bytes*/, size_t align) noexcept override {
+        ::operator delete(ptr, std::align_val_t(align));
+    }
+
+    bool DoIsEqual(const MemoryResource& other) const noexcept override {
+        return dynamic_cast<const NewDeleteResource*>(&other) != nullptr;
+    }
+};
+
+// Used by default-constructed polymorphic allocators. Never destroyed.
+inline MemoryResource* GetNewDeleteResource() noexcept {
+    static auto* resource = new NewDeleteResource();
+    return resource;
+}
+
+// Owns an Arena: Deallocate is a no-op, Reset() frees everything at once
+class ArenaResource : public MemoryResource {
+public:
+    explicit ArenaResource(size_t first_chunk = 64 * 1024) : arena_(first_chunk) {
+    }
+
+    void Reset() noexcept {
+        arena_.Reset();
+    }
+
+    const Arena& GetArena() const noexcept {
+        return arena_;
+    }
+
+private:
+    void* DoAllocate(size_t bytes, size_t align) override {
+        return arena_.Allocate(bytes, align);
+    }
+
+    void DoDeallocate(void* /*ptr*/, size_t /*bytes*/, size_t /*align*/) noexcept override {
+    }
+
+    Arena arena_;
+};
+
+// One NodePool per power-of-two size class from 16 to kMaxPooledSize bytes. Larger or over-aligned
+// requests go to the upstream resource. Pooled memory is kept until the resource is destroyed.
+class PoolResource : public MemoryResource {
+public:
+    static constexpr size_t kMaxPooledSize = 512;
+    static constexpr size_t kPoolAlign = 16;
+    static constexpr size_t kSlabSize = 16 * 1024;
+
+    explicit PoolResource(MemoryResource* upstream = GetNewDeleteResource()) : upstream_(upstream) {
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    size_t SlabCount() const noexcept {
+        return std::apply([](const auto&... pools) { return (pools.SlabCount() + ...); }, pools_);
+    }
+
+private:
+    static constexpr size_t kClassCount = std::bit_width(kMaxPooledSize / 16);
+
+    template <size_t... I>
+    static auto MakePools(std::index_sequence<I...>) -> std::tuple<NodePool<(size_t{16} << I), kPoolAlign, kSlabSize>...>;
+
+    using Pools = decltype(MakePools(std::make_index_sequence<kClassCount>()));
+
+    static bool IsPooled(size_t bytes, size_t align) noexcept {
+        return bytes <= kMaxPooledSize && align <= kPoolAlign;
+    }
+
+    static size_t SizeClass(size_t bytes) noexcept {
+        return bytes <= 16 ? 0 : std::bit_width(bytes - 1) - 4;
+    }
+
+    template <size_t... I>
+    void* AllocateFrom(size_t size_class, std::index_sequence<I...>) {
+        void* ptr = nullptr;
+        std::ignore = ((I == size_class && (ptr = std::get<I>(pools_).Allocate(), true)) || ...);
+        return ptr;
+    }
+
+    template <size_t... I>
+    void DeallocateTo(void* ptr, size_t size_class, std::index_sequence<I...>) noexcept {
+        std::ignore = ((I == size_class && (std::get<I>(pools_).Deallocate(ptr), true)) || ...);
+    }
+
+    void* DoAllocate(size_t bytes, size_t align) override {
+        if (!IsPooled(bytes, align)) {
+            return upstream_->Allocate(bytes, align);
+        }
+        return this->AllocateFrom(SizeClass(bytes), std::make_index_sequence<kClassCount>());
+    }
+
+    void DoDeallocate(void* ptr, size_t bytes, size_t align) noexcept override {
+        if (!IsPooled(bytes, align)) {
+            upstream_->Deallocate(ptr, bytes, align);
+            return;
+        }
+        this->DeallocateTo(ptr, SizeClass(bytes), std::make_index_sequence<kClassCount>());
+    }
+
+    MemoryResource* upstream_;
+    Pools pools_;
+};
+
+// Forwards to an upstream resource and counts what goes through it. Not thread-safe.
+class TrackingResource : public MemoryResource {
+public:
+    struct Stats {
+        size_t allocations = 0;
+        size_t deallocations = 0;
+        size_t bytes_in_use = 0;
+        size_t peak_bytes = 0;
+    };
+
+    explicit TrackingResource(MemoryResource* upstream = GetNewDeleteResource()) : upstream_(upstream) {
+    }
+
+    const Stats& GetStats() const noexcept {
+        return stats_;
+    }
+
+private:
+    void* DoAllocate(size_t bytes, size_t align) override {
+        void* ptr = upstream_->Allocate(bytes, align);
+        ++stats_.allocations;
+        stats_.bytes_in_use += bytes;
+        stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.bytes_in_use);
+        return ptr;
+    }
+
+    void DoDeallocate(void* ptr, size_t bytes, size_t align) noexcept override {
+        upstream_->Deallocate(ptr, bytes, align);
+        ++stats_.deallocations;
+        stats_.bytes_in_use -= bytes;
+    }
+
+    MemoryResource* upstream_;
+    Stats stats_;
+};
+
+// Standard allocator over a MemoryResource it does not own. As with std::pmr, the resource stays
+// with the container: it is not propagated on assignment or swap, and a copied container starts on
+// the default (new/delete) resource, so elements are copied between resources when they differ.
+template <typename T>
+class PolymorphicAllocator {
+public:
+    // NOLINTNEXTLINE
+    using value_type = T;
+    // NOLINTNEXTLINE
+    using propagate_on_container_copy_assignment = std::false_type;
+    // NOLINTNEXTLINE
+    using propagate_on_container_move_assignment = std::false_type;
+    // NOLINTNEXTLINE
+    using propagate_on_container_swap = std::false_type;
+
+    PolymorphicAllocator() noexcept : resource_(GetNewDeleteResource()) {
+    }
+
+    PolymorphicAllocator(MemoryResource* resource) noexcept : resource_(resource) {  // NOLINT
+    }
+
+    template <typename U>
+    PolymorphicAllocator(const PolymorphicAllocator<U>& other) noexcept : resource_(other.GetResource()) {  // NOLINT
+    }
+
+    // NOLINTNEXTLINE
+    T* allocate(size_t count) {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(resource_->Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // NOLINTNEXTLINE
+    void deallocate(T* ptr, size_t count) noexcept {
+        resource_->Deallocate(ptr, count * sizeof(T), alignof(T));
+    }
+
+    // NOLINTNEXTLINE
+    PolymorphicAllocator select_on_container_copy_construction() const noexcept {
+        return PolymorphicAllocator();
+    }
+
+    MemoryResource* GetResource() const noexcept {
+        return resource_;
+    }
+
+    template <typename U>
+    bool operator==(const PolymorphicAllocator<U>& other) const noexcept {
+        return resource_->IsEqual(*other.GetResource());
+    }
+
+private:
+    MemoryResource* resource_;
+};
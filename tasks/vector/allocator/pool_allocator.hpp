@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Fixed-size chunks carved from BlockSize-byte slabs. Freed chunks go onto an intrusive freelist
+// and are handed out again before the current slab is touched; slabs are returned only by the destructor.
+template <size_t ChunkSize, size_t ChunkAlign, size_t BlockSize>
+class NodePool {
+public:
+    static constexpr size_t kChunkAlign = ChunkAlign > alignof(void*) ? ChunkAlign : alignof(void*);
+    static constexpr size_t kChunkSize = (ChunkSize + kChunkAlign - 1) / kChunkAlign * kChunkAlign;
+    static constexpr size_t kHeaderSize = (sizeof(void*) + kChunkAlign - 1) / kChunkAlign * kChunkAlign;
+
+    static_assert(BlockSize >= kHeaderSize + kChunkSize, "BlockSize must fit at least one chunk");
+
+    NodePool() = default;
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    void* Allocate() {
+        if (free_ != nullptr) {
+            FreeChunk* chunk = free_;
+            free_ = chunk->next;
+            return chunk;
+        }
+        if (cur_ == end_) {
+            this->AddSlab();
+        }
+        void* ptr = cur_;
+        cur_ += kChunkSize;
+        return ptr;
+    }
+
+    void Deallocate(void* ptr) noexcept {
+        auto* chunk = static_cast<FreeChunk*>(ptr);
+        chunk->next = free_;
+        free_ = chunk;
+    }
+
+    size_t SlabCount() const noexcept {
+        return slabs_;
+    }
+
+    ~NodePool() {
+        while (head_ != nullptr) {
+            Slab* prev = head_->prev;
+            ::operator delete(head_, std::align_val_t(kChunkAlign));
+            head_ = prev;
+        }
+    }
+
+private:
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    struct Slab {
+        Slab* prev;
+    };
+
+    void AddSlab() {
+        auto* slab = static_cast<Slab*>(::operator new(BlockSize, std::align_val_t(kChunkAlign)));
+        slab->prev = head_;
+        head_ = slab;
+        cur_ = reinterpret_cast<char*>(slab) + kHeaderSize;
+        end_ = cur_ + (BlockSize - kHeaderSize) / kChunkSize * kChunkSize;
+        ++slabs_;
+    }
+
+    FreeChunk* free_ = nullptr;
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+    Slab* head_ = nullptr;
+    size_t slabs_ = 0;
+};
+
+// The pools behind one PoolAllocator and its rebinds: one NodePool per chunk type, created on first use
+class NodePoolSet {
+public:
+    NodePoolSet() = default;
+
+    NodePoolSet(const NodePoolSet&) = delete;
+    NodePoolSet& operator=(const NodePoolSet&) = delete;
+
+    template <class Pool>
+    Pool& Get() {
+        for (Entry* entry = head_; entry != nullptr; entry = entry->next) {
+            if (entry->key == Key<Pool>()) {
+                return static_cast<Holder<Pool>*>(entry)->pool;
+            }
+        }
+        auto* holder = new Holder<Pool>();
+        holder->key = Key<Pool>();
+        holder->next = head_;
+        head_ = holder;
+        return holder->pool;
+    }
+
+    ~NodePoolSet() {
+        while (head_ != nullptr) {
+            Entry* next = head_->next;
+            delete head_;
+            head_ = next;
+        }
+    }
+
+private:
+    struct Entry {
+        virtual ~Entry() = default;
+
+        const void* key = nullptr;
+        Entry* next = nullptr;
+    };
+
+    template <class Pool>
+    struct Holder : Entry {
+        Pool pool;
+    };
+
+    template <class Pool>
+    static const void* Key() noexcept {
+        static const char key = 0;
+        return &key;
+    }
+
+    Entry* head_ = nullptr;
+};
+
+// Allocator for node-based containers: single-object allocations come from a NodePool, anything
+// else goes to operator new. Copies and rebinds share one NodePoolSet, with a pool per chunk size,
+// and compare equal, so memory may be freed through any rebound copy of the allocating one.
+// The set lives as long as any allocator or container using it.
+template <typename T, size_t BlockSize = 4096>
+class PoolAllocator {
+public:
+    // NOLINTNEXTLINE
+    using value_type = T;
+    // NOLINTNEXTLINE
+    using propagate_on_container_copy_assignment = std::false_type;
+    // NOLINTNEXTLINE
+    using propagate_on_container_move_assignment = std::true_type;
+    // NOLINTNEXTLINE
+    using propagate_on_container_swap = std::true_type;
+
+    using Pool = NodePool<sizeof(T), alignof(T), BlockSize>;
+
+    template <typename U>
+    // NOLINTNEXTLINE
+    struct rebind {
+        using other = PoolAllocator<U, BlockSize>;
+    };
+
+    PoolAllocator() : pools_(std::make_shared<NodePoolSet>()), pool_(&pools_->Get<Pool>()) {
+    }
+
+    // No move operations: a moved-from container keeps a usable pool
+    PoolAllocator(const PoolAllocator&) = default;
+    PoolAllocator& operator=(const PoolAllocator&) = default;
+
+    template <typename U>
+    explicit PoolAllocator(const PoolAllocator<U, BlockSize>& other)
+        : pools_(other.pools_), pool_(&pools_->template Get<Pool>()) {
+    }
+
+    // NOLINTNEXTLINE
+    T* allocate(size_t count) {
+        if (count == 1) {
+            return static_cast<T*>(pool_->Allocate());
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    // NOLINTNEXTLINE
+    void deallocate(T* ptr, size_t count) noexcept {
+        if (count == 1) {
+            pool_->Deallocate(ptr);
+        } else {
+            std::allocator<T>().deallocate(ptr, count);
+        }
+    }
+
+    // A copied container gets pools of its own
+    // NOLINTNEXTLINE
+    PoolAllocator select_on_container_copy_construction() const {
+        return PoolAllocator();
+    }
+
+    const Pool& GetPool() const noexcept {
+        return *pool_;
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, BlockSize>& other) const noexcept {
+        return pools_ == other.pools_;
+    }
+
+private:
+    template <typename U, size_t>
+    friend class PoolAllocator;
+
+    std::shared_ptr<NodePoolSet> pools_;
+    Pool* pool_;
+};
@@ -0,0 +1,464 @@
+#include "../arena_allocator.hpp"
+#include "../huge_page_allocator.hpp"
+#include "../inline_allocator.hpp"
+#include "../memory_resource.hpp"
+#include "../pool_allocator.hpp"
+#include "../thread_caching_allocator.hpp"
+#include "../tracking_allocator.hpp"
+#include "../../vector/vector.hpp"
+#include "../../../abstract/deque/deque.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <tuple>
+#include <typeinfo>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#if __has_include(<mimalloc.h>)
+#include <mimalloc.h>
+#define HAVE_MIMALLOC 1
+#endif
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HAVE_PERF_EVENT 1
+#endif
+
+// Where the containers of one request get their memory and what happens when the request is done
+struct StdAllocatorSource {
+  template <typename T>
+  using Alloc = std::allocator<T>;
+
+  template <typename T>
+  Alloc<T> Make() {
+    return {};
+  }
+
+  void EndRequest() {
+  }
+};
+
+struct ArenaSource {
+  template <typename T>
+  using Alloc = ArenaAllocator<T>;
+
+  template <typename T>
+  Alloc<T> Make() {
+    return Alloc<T>(arena);
+  }
+
+  void EndRequest() {
+    arena.Reset();
+  }
+
+  Arena arena;
+};
+
+#ifdef HAVE_MIMALLOC
+struct MimallocSource {
+  template <typename T>
+  using Alloc = mi_stl_allocator<T>;
+
+  template <typename T>
+  Alloc<T> Make() {
+    return {};
+  }
+
+  void EndRequest() {
+  }
+};
+#endif
+
+// The same arena behind a virtual call: measures what runtime dispatch costs over ArenaSource
+struct PolymorphicArenaSource {
+  template <typename T>
+  using Alloc = PolymorphicAllocator<T>;
+
+  template <typename T>
+  Alloc<T> Make() {
+    return Alloc<T>(&resource);
+  }
+
+  void EndRequest() {
+    resource.Reset();
+  }
+
+  ArenaResource resource;
+};
+
+struct PolymorphicNewDeleteSource {
+  template <typename T>
+  using Alloc = PolymorphicAllocator<T>;
+
+  template <typename T>
+  Alloc<T> Make() {
+    return {};
+  }
+
+  void EndRequest() {
+  }
+};
+
+// Every benchmark counts its allocations under a tag of its own and reports them per iteration.
+// The tracking wrapper costs the same few thread-local stores for every allocator compared.
+template <typename... Key>
+const AllocationTag& BenchmarkTag() {
+  static AllocationTag tag(typeid(std::tuple<Key...>).name());
+  return tag;
+}
+
+// Call once per run, from thread 0 after the loop: counters are summed over threads and then
+// divided by the total number of iterations
+void ReportAllocations(benchmark::State& state, const AllocationTag& tag, const AllocationStats& before) {
+  AllocationStats after = tag.Snapshot();
+  state.counters["allocs/iter"] =
+      benchmark::Counter(static_cast<double>(after.allocations - before.allocations), benchmark::Counter::kAvgIterations);
+  state.counters["bytes/iter"] = benchmark::Counter(static_cast<double>(after.bytes_allocated - before.bytes_allocated),
+                                                    benchmark::Counter::kAvgIterations);
+}
+
+template <typename Source>
+struct TrackedSource {
+  template <typename T>
+  using Alloc = TrackingAllocator<T, typename Source::template Alloc<T>>;
+
+  template <typename T>
+  Alloc<T> Make() {
+    return Alloc<T>(BenchmarkTag<Source>(), source.template Make<T>());
+  }
+
+  void EndRequest() {
+    source.EndRequest();
+  }
+
+  Source source;
+};
+
+struct Record {
+  int64_t id;
+  double score;
+  int32_t flags;
+};
+
+// One request: a few short-lived containers of arg 0 elements each, then everything is dropped
+template <typename Source>
+void BM_RequestContainers(benchmark::State& state) {
+  TrackedSource<Source> source;
+  using Alloc = typename TrackedSource<Source>::template Alloc<Record>;
+  using IdAlloc = typename TrackedSource<Source>::template Alloc<int64_t>;
+  AllocationStats before = BenchmarkTag<Source>().Snapshot();
+  for (auto _ : state) {
+    {
+      Vector<Record, Alloc> records(source.template Make<Record>());
+      Vector<int64_t, IdAlloc> ids(source.template Make<int64_t>());
+      Deque<int64_t, IdAlloc> queue(source.template Make<int64_t>());
+      for (int64_t i = 0; i < state.range(0); ++i) {
+        records.PushBack(Record{i, 0.5, 0});
+        ids.PushBack(i);
+        queue.PushBack(i);
+      }
+      for (int64_t batch = 0; batch < 16; ++batch) {
+        Vector<int64_t, IdAlloc> scratch(source.template Make<int64_t>());
+        for (int64_t i = 0; i < state.range(0) / 16; ++i) {
+          scratch.PushBack(ids[i]);
+        }
+        benchmark::DoNotOptimize(scratch.Data());
+      }
+      benchmark::DoNotOptimize(records.Data());
+      benchmark::DoNotOptimize(queue.Size());
+    }
+    source.EndRequest();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportAllocations(state, BenchmarkTag<Source>(), before);
+}
+
+// Single-object allocations, where an indirect call is the largest share of the work:
+// PoolAllocator inlines the freelist, PolymorphicAllocator reaches the same kind of pool through PoolResource
+template <typename Alloc>
+void BM_NodeChurn(benchmark::State& state, Alloc inner) {
+  const AllocationTag& tag = BenchmarkTag<Alloc>();
+  TrackingAllocator<Record, Alloc> alloc(tag, inner);
+  AllocationStats before = tag.Snapshot();
+  std::vector<Record*> nodes(state.range(0));
+  for (auto _ : state) {
+    for (auto& node : nodes) {
+      node = alloc.allocate(1);
+      node->id = 1;
+    }
+    for (auto& node : nodes) {
+      alloc.deallocate(node, 1);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportAllocations(state, tag, before);
+}
+
+void BM_NodeChurnStaticPool(benchmark::State& state) {
+  BM_NodeChurn(state, PoolAllocator<Record>());
+}
+
+void BM_NodeChurnPolymorphicPool(benchmark::State& state) {
+  PoolResource resource;
+  BM_NodeChurn(state, PolymorphicAllocator<Record>(&resource));
+}
+
+// A function with short-lived scratch containers of count elements
+template <typename Alloc>
+int64_t ScratchCall(int64_t count, const Alloc& alloc) {
+  Vector<int64_t, Alloc> values(alloc);
+  for (int64_t i = 0; i < count; ++i) {
+    values.PushBack(i * 7 % 13);
+  }
+  Deque<int64_t, Alloc> pending(alloc);
+  for (int64_t i = 0; i < count / 4; ++i) {
+    pending.PushBack(values[i]);
+  }
+  int64_t sum = 0;
+  for (int64_t i = 0; i < count; ++i) {
+    sum += values[i];
+  }
+  return sum + static_cast<int64_t>(pending.Size());
+}
+
+// Bytes is the stack buffer of every call, 0 for none. Only upstream allocations are tracked,
+// so allocs/iter shows the heap traffic that is left.
+template <size_t Bytes>
+void BM_ScratchVectors(benchmark::State& state) {
+  const AllocationTag& tag = BenchmarkTag<std::integral_constant<size_t, Bytes>>();
+  AllocationStats before = tag.Snapshot();
+  for (auto _ : state) {
+    for (int call = 0; call < 16; ++call) {
+      if constexpr (Bytes == 0) {
+        benchmark::DoNotOptimize(ScratchCall(state.range(0), TrackingAllocator<int64_t>(tag)));
+      } else {
+        InlineArena<Bytes> arena;
+        InlineAllocator<int64_t, TrackingAllocator<int64_t>> alloc(arena, TrackingAllocator<int64_t>(tag));
+        benchmark::DoNotOptimize(ScratchCall(state.range(0), alloc));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 16 * state.range(0));
+  ReportAllocations(state, tag, before);
+}
+
+// dTLB load misses of the calling thread in user space. Unavailable without a PMU or when
+// perf_event_paranoid forbids it; the benchmark then reports latency only.
+class DtlbMissCounter {
+ public:
+  DtlbMissCounter() {
+#ifdef HAVE_PERF_EVENT
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+
+  DtlbMissCounter(const DtlbMissCounter&) = delete;
+  DtlbMissCounter& operator=(const DtlbMissCounter&) = delete;
+
+  bool IsAvailable() const {
+    return fd_ >= 0;
+  }
+
+  void Start() {
+#ifdef HAVE_PERF_EVENT
+    ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  uint64_t Stop() {
+    uint64_t misses = 0;
+#ifdef HAVE_PERF_EVENT
+    ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    if (::read(fd_, &misses, sizeof(misses)) != sizeof(misses)) {
+      misses = 0;
+    }
+#endif
+    return misses;
+  }
+
+  ~DtlbMissCounter() {
+#ifdef HAVE_PERF_EVENT
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+#endif
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+// AnonHugePages of the process, to see whether the kernel actually gave us huge pages
+size_t AnonHugeBytes() {
+  std::ifstream smaps("/proc/self/smaps_rollup");
+  std::string key;
+  size_t kilobytes = 0;
+  while (smaps >> key) {
+    if (key == "AnonHugePages:") {
+      smaps >> kilobytes;
+      return kilobytes * 1024;
+    }
+    smaps.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+  return 0;
+}
+
+// Dependent loads along one random cycle through arg 0 MB of int64_t: every step is a cache miss
+// and, on 4 KB pages, almost always a TLB miss
+template <typename Alloc>
+void BM_RandomGather(benchmark::State& state) {
+  constexpr int64_t kSteps = 1 << 16;
+  const AllocationTag& tag = BenchmarkTag<Alloc>();
+  AllocationStats before = tag.Snapshot();
+  size_t huge_before = AnonHugeBytes();
+
+  auto count = static_cast<int64_t>((state.range(0) << 20) / sizeof(int64_t));
+  Vector<int64_t, TrackingAllocator<int64_t, Alloc>> next{TrackingAllocator<int64_t, Alloc>(tag)};
+  next.Reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    next.PushBack(i);
+  }
+  std::mt19937_64 random(42);
+  for (int64_t i = count - 1; i > 0; --i) {  // Sattolo: a single cycle through every element
+    std::swap(next[i], next[std::uniform_int_distribution<int64_t>(0, i - 1)(random)]);
+  }
+
+  DtlbMissCounter tlb;
+  uint64_t misses = 0;
+  int64_t pos = 0;
+  for (auto _ : state) {
+    tlb.Start();
+    for (int64_t step = 0; step < kSteps; ++step) {
+      pos = next[pos];
+    }
+    misses += tlb.Stop();
+    benchmark::DoNotOptimize(pos);
+  }
+  state.SetItemsProcessed(state.iterations() * kSteps);
+  if (tlb.IsAvailable()) {
+    state.counters["dTLB-misses/load"] = static_cast<double>(misses) / static_cast<double>(state.iterations() * kSteps);
+  }
+  state.counters["huge_MB"] = static_cast<double>(AnonHugeBytes() - std::min(huge_before, AnonHugeBytes())) / (1 << 20);
+  ReportAllocations(state, tag, before);
+}
+
+// Small blocks of mixed sizes, every thread frees what it allocated
+constexpr size_t kChurnBatch = 256;
+
+size_t ChurnSize(size_t i) {
+  return 16 + (i * 40) % 496;
+}
+
+template <typename Alloc>
+void BM_ThreadLocalChurn(benchmark::State& state) {
+  const AllocationTag& tag = BenchmarkTag<Alloc, std::true_type>();
+  AllocationStats before = tag.Snapshot();
+  TrackingAllocator<std::byte, Alloc> alloc(tag);
+  std::array<std::byte*, kChurnBatch> blocks;
+  for (auto _ : state) {
+    for (size_t i = 0; i < kChurnBatch; ++i) {
+      blocks[i] = alloc.allocate(ChurnSize(i));
+      blocks[i][0] = std::byte{1};
+    }
+    for (size_t i = 0; i < kChurnBatch; ++i) {
+      alloc.deallocate(blocks[i], ChurnSize(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kChurnBatch);
+  if (state.thread_index() == 0) {
+    ReportAllocations(state, tag, before);
+  }
+}
+
+// Every thread hands its batch over to be freed by whichever thread comes next
+template <typename Alloc>
+void BM_CrossThreadFree(benchmark::State& state) {
+  using Batch = std::array<std::byte*, kChurnBatch>;
+  static std::mutex mutex;
+  static std::vector<Batch> handed_over;
+
+  const AllocationTag& tag = BenchmarkTag<Alloc, std::false_type>();
+  AllocationStats before = tag.Snapshot();
+  TrackingAllocator<std::byte, Alloc> alloc(tag);
+  Batch blocks;
+  for (auto _ : state) {
+    for (size_t i = 0; i < kChurnBatch; ++i) {
+      blocks[i] = alloc.allocate(ChurnSize(i));
+      blocks[i][0] = std::byte{1};
+    }
+    bool taken = false;
+    {
+      std::lock_guard lock(mutex);
+      if (!handed_over.empty()) {
+        std::swap(blocks, handed_over.back());
+        taken = true;
+      } else {
+        handed_over.push_back(blocks);
+      }
+    }
+    if (taken) {
+      for (size_t i = 0; i < kChurnBatch; ++i) {
+        alloc.deallocate(blocks[i], ChurnSize(i));
+      }
+    }
+  }
+  // The loop ends for all threads at once, so nobody touches the handed over batches any more
+  if (state.thread_index() == 0) {
+    for (auto& batch : handed_over) {
+      for (size_t i = 0; i < kChurnBatch; ++i) {
+        alloc.deallocate(batch[i], ChurnSize(i));
+      }
+    }
+    handed_over.clear();
+    ReportAllocations(state, tag, before);
+  }
+  state.SetItemsProcessed(state.iterations() * kChurnBatch);
+}
+
+BENCHMARK_TEMPLATE(BM_RequestContainers, StdAllocatorSource)->Range(16, 1<<16);
+BENCHMARK_TEMPLATE(BM_RequestContainers, ArenaSource)->Range(16, 1<<16);
+BENCHMARK_TEMPLATE(BM_RequestContainers, PolymorphicArenaSource)->Range(16, 1<<16);
+BENCHMARK_TEMPLATE(BM_RequestContainers, PolymorphicNewDeleteSource)->Range(16, 1<<16);
+#ifdef HAVE_MIMALLOC
+BENCHMARK_TEMPLATE(BM_RequestContainers, MimallocSource)->Range(16, 1<<16);
+#endif
+BENCHMARK_TEMPLATE(BM_ScratchVectors, 0)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_ScratchVectors, 16 * 1024)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_ScratchVectors, 1024)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_RandomGather, std::allocator<int64_t>)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_RandomGather, HugePageAllocator<int64_t>)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_NodeChurnStaticPool)->Range(64, 1<<14);
+BENCHMARK(BM_NodeChurnPolymorphicPool)->Range(64, 1<<14);
+
+BENCHMARK_TEMPLATE(BM_ThreadLocalChurn, std::allocator<std::byte>)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ThreadLocalChurn, ThreadCachingAllocator<std::byte>)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_CrossThreadFree, std::allocator<std::byte>)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_CrossThreadFree, ThreadCachingAllocator<std::byte>)->ThreadRange(1, 8)->UseRealTime();
+#ifdef HAVE_MIMALLOC
+BENCHMARK_TEMPLATE(BM_ThreadLocalChurn, mi_stl_allocator<std::byte>)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_CrossThreadFree, mi_stl_allocator<std::byte>)->ThreadRange(1, 8)->UseRealTime();
+#endif
+
+BENCHMARK_MAIN();
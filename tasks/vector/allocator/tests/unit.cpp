@@ -1,180 +1,721 @@
-#include <chrono>
-#include <future>
-#include <map>
-#include <iostream>
+#include "../arena_allocator.hpp"
+#include "../huge_page_allocator.hpp"
+#include "../inline_allocator.hpp"
+#include "../memory_resource.hpp"
+#include "../pool_allocator.hpp"
+#include "../thread_caching_allocator.hpp"
+#include "../tracking_allocator.hpp"
+#include "../../vector/vector.hpp"
+#include "../../vector/concurrent_segmented_vector.hpp"
+#include "../../vector/soa_vector.hpp"
+#include "../../../abstract/deque/deque.hpp"
+#include "../../../lists/list/list.hpp"
+#include "../../../tree/bst/map.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
 
-#include <fmt/core.h>
-#include <gtest/gtest.h>
+TEST(ArenaAllocatorTest, AllocatorTraits) {
+    Arena arena;
+    ArenaAllocator<int> ints(arena);
+    using Traits = std::allocator_traits<ArenaAllocator<int>>;
+
+    int* first = Traits::allocate(ints, 3);
+    int* second = Traits::allocate(ints, 5);
+    ASSERT_EQ(first + 3, second) << "Allocations are bumped one after another";
+    Traits::deallocate(ints, first, 3);
+    ASSERT_EQ(Traits::allocate(ints, 1), second + 5) << "deallocate does not hand memory back";
+
+    Traits::rebind_alloc<double> doubles(ints);
+    ASSERT_EQ(doubles.GetArena(), &arena);
+    ASSERT_TRUE(doubles == ints);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(Traits::rebind_traits<double>::allocate(doubles, 1)) % alignof(double), 0);
+
+    Arena other;
+    ASSERT_FALSE(ArenaAllocator<int>(other) == ints);
+}
+
+TEST(ArenaAllocatorTest, OverAlignedAndLarge) {
+    struct alignas(64) Line {
+        char bytes[64];
+    };
+    Arena arena(256);
+    ArenaAllocator<Line> lines(arena);
+    for (size_t count : {1, 3, 100, 1}) {
+        Line* ptr = lines.allocate(count);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+        ptr[count - 1].bytes[63] = 1;
+    }
+    ASSERT_GT(arena.ChunkCount(), 1) << "An allocation larger than a chunk gets its own chunk";
+}
+
+TEST(ArenaAllocatorTest, UnboundAllocatorThrows) {
+    ArenaAllocator<int> unbound;
+    ASSERT_EQ(unbound.GetArena(), nullptr);
+    ASSERT_THROW(unbound.allocate(1), std::bad_alloc);
+}
+
+TEST(ArenaAllocatorTest, VectorOnArena) {
+    Arena arena(1024);
+    ArenaAllocator<std::string> alloc(arena);
+    for (int request = 0; request < 10; ++request) {
+        {
+            Vector<std::string, ArenaAllocator<std::string>> names(alloc);
+            for (int i = 0; i < 1000; ++i) {
+                names.PushBack("name number " + std::to_string(i));
+            }
+            Vector<std::string, ArenaAllocator<std::string>> copy = names;
+            ASSERT_EQ(copy.Size(), 1000);
+            ASSERT_EQ(copy[999], "name number 999");
+            if (request > 0) {
+                ASSERT_EQ(arena.ChunkCount(), 1) << "Repeated work fits into the merged chunk";
+            }
+        }
+        alloc.Reset();
+        ASSERT_EQ(arena.ChunkCount(), 1);
+    }
+}
+
+TEST(ArenaAllocatorTest, NestedVectorsShareArena) {
+    using Inner = Vector<int, ArenaAllocator<int>>;
+    Arena arena;
+    Vector<Inner, ArenaAllocator<Inner>> rows{ArenaAllocator<Inner>(arena)};
+    for (int row = 0; row < 10; ++row) {
+        Inner inner{ArenaAllocator<int>(arena)};
+        for (int i = 0; i < row; ++i) {
+            inner.PushBack(i);
+        }
+        rows.PushBack(inner);
+    }
+    ASSERT_EQ(rows.Size(), 10);
+    ASSERT_EQ(rows[9].Size(), 9);
+    ASSERT_EQ(rows[9][8], 8);
+}
+
+TEST(ArenaAllocatorTest, DequeOnArena) {
+    Arena arena(512);
+    Deque<int, ArenaAllocator<int>> deque{ArenaAllocator<int>(arena)};
+    for (int i = 0; i < 100; ++i) {
+        deque.PushBack(i);
+        deque.PushFront(-i);
+    }
+    ASSERT_EQ(deque.Size(), 200);
+    ASSERT_EQ(deque.Front(), -99);
+    ASSERT_EQ(deque[199], 99);
+
+    Deque<int, ArenaAllocator<int>> copy = deque;
+    ASSERT_EQ(copy.Size(), 200);
+    ASSERT_EQ(copy[0], -99);
+    ASSERT_GT(arena.ChunkCount(), 1);
+}
+
+TEST(PoolAllocatorTest, ReusesFreedChunks) {
+    PoolAllocator<int64_t, 256> alloc;
+    int64_t* first = alloc.allocate(1);
+    int64_t* second = alloc.allocate(1);
+    ASSERT_EQ(first + 1, second);
+    alloc.deallocate(first, 1);
+    ASSERT_EQ(alloc.allocate(1), first) << "The freelist is used before the slab";
+
+    for (int i = 0; i < 100; ++i) {
+        *alloc.allocate(1) = i;
+    }
+    ASSERT_EQ(alloc.GetPool().SlabCount(), 4) << "31 chunks of 8 bytes per 256-byte slab";
+
+    int64_t* array = alloc.allocate(10);
+    array[9] = 1;
+    alloc.deallocate(array, 10);
+    ASSERT_EQ(alloc.GetPool().SlabCount(), 4) << "Arrays bypass the pool";
+}
+
+TEST(PoolAllocatorTest, CopiesAndRebindsShare) {
+    PoolAllocator<int> alloc;
+    PoolAllocator<int> copy = alloc;
+    ASSERT_TRUE(copy == alloc);
+    int* ptr = copy.allocate(1);
+    alloc.deallocate(ptr, 1);
+    ASSERT_EQ(alloc.allocate(1), ptr);
+
+    PoolAllocator<double> doubles(alloc);
+    ASSERT_TRUE(doubles == alloc);
+    ASSERT_TRUE(PoolAllocator<int>(doubles) == alloc) << "Rebinding back gives an equal allocator";
+    ASSERT_EQ(doubles.GetPool().SlabCount(), 0) << "Doubles get a pool of their own";
+    double* number = doubles.allocate(1);
+    PoolAllocator<double>(PoolAllocator<int>(doubles)).deallocate(number, 1);
+    ASSERT_EQ(doubles.allocate(1), number) << "A rebound copy frees into the same pool";
+    ASSERT_FALSE(std::allocator_traits<PoolAllocator<int>>::select_on_container_copy_construction(alloc) == alloc);
+}
+
+TEST(PoolAllocatorTest, DequeMovedAfterShrink) {
+    struct Big {
+        char bytes[8192];
+    };
+    using BigDeque = Deque<Big, PoolAllocator<Big, 16384>>;
+    auto source = std::make_unique<BigDeque>();
+    source->PushBack(Big{});
+    source->ShrinkToFit();  // one block and a one-slot map, both pool chunks
+    BigDeque moved = std::move(*source);
+    source.reset();
+    ASSERT_EQ(moved.Size(), 1);
+    moved.PushFront(Big{});
+    moved.PushBack(Big{});
+    ASSERT_EQ(moved.Size(), 3);
+}
+
+TEST(PoolAllocatorTest, OverAligned) {
+    struct alignas(32) Wide {
+        char bytes[40];
+    };
+    PoolAllocator<Wide> alloc;
+    for (int i = 0; i < 300; ++i) {
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(alloc.allocate(1)) % 32, 0);
+    }
+}
+
+TEST(PoolAllocatorTest, ListOnPool) {
+    List<std::string, PoolAllocator<std::string>> list;
+    for (int i = 0; i < 1000; ++i) {
+        list.PushBack(std::to_string(i));
+        list.PushFront(std::to_string(-i));
+    }
+    for (int i = 0; i < 500; ++i) {
+        list.PopBack();
+        list.Erase(list.Begin());
+    }
+    ASSERT_EQ(list.Size(), 1000);
+    ASSERT_EQ(list.Front(), "-499");
+    ASSERT_EQ(list.Back(), "499");
+
+    List<std::string, PoolAllocator<std::string>> copy = list;
+    List<std::string, PoolAllocator<std::string>> other;
+    other.PushBack("other");
+    std::swap(copy, other);
+    ASSERT_EQ(other.Size(), 1000);
+    ASSERT_EQ(copy.Front(), "other");
+    other.Clear();
+    ASSERT_TRUE(other.IsEmpty());
+}
+
+TEST(PoolAllocatorTest, MapOnPool) {
+    Map<int, std::string, std::less<int>, PoolAllocator<std::pair<const int, std::string>>> map;
+    for (int i = 0; i < 1000; ++i) {
+        map.Insert({(i * 7919) % 1000, std::to_string(i)});
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        map.Erase(i);
+    }
+    ASSERT_EQ(map.Size(), 500);
+    ASSERT_TRUE(map.Find(1));
+    ASSERT_FALSE(map.Find(2));
+}
+
+TEST(ThreadCachingHeapTest, SizeClasses) {
+    for (size_t bytes = 1; bytes <= ThreadCachingHeap::kMaxSmallSize; ++bytes) {
+        size_t size_class = ThreadCachingHeap::SizeClass(bytes);
+        ASSERT_LT(size_class, ThreadCachingHeap::kClassCount);
+        ASSERT_GE(ThreadCachingHeap::ClassSize(size_class), bytes);
+        ASSERT_EQ(ThreadCachingHeap::ClassSize(size_class) % ThreadCachingHeap::kAlign, 0);
+        if (size_class > 0) {
+            ASSERT_LT(ThreadCachingHeap::ClassSize(size_class - 1), bytes) << "The smallest class that fits";
+        }
+    }
+    ASSERT_EQ(ThreadCachingHeap::ClassSize(ThreadCachingHeap::kClassCount - 1), ThreadCachingHeap::kMaxSmallSize);
+}
+
+TEST(ThreadCachingHeapTest, SameThreadReuse) {
+    void* first = ThreadCachingHeap::Allocate(24);
+    ThreadCachingHeap::Deallocate(first, 24);
+    ASSERT_EQ(ThreadCachingHeap::Allocate(24), first);
+    ThreadCachingHeap::Deallocate(first, 24);
+}
+
+TEST(ThreadCachingHeapTest, RemoteFreesGoBackToOwner) {
+    // A class no other test touches: the first allocation carves a slab owned by this thread
+    constexpr size_t kBytes = 20000;
+    constexpr size_t kCount = (ThreadCachingHeap::kSlabSize - 16) / 20480;
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < kCount; ++i) {
+        blocks.push_back(ThreadCachingHeap::Allocate(kBytes));
+    }
+    auto before = ThreadCachingHeap::GetStats();
+
+    std::thread([&] {
+        for (void* block : blocks) {
+            ThreadCachingHeap::Deallocate(block, kBytes);
+        }
+    }).join();
+    auto after = ThreadCachingHeap::GetStats();
+    ASSERT_EQ(after.remote_frees - before.remote_frees, kCount);
+
+    std::vector<void*> again;
+    for (size_t i = 0; i < kCount; ++i) {
+        again.push_back(ThreadCachingHeap::Allocate(kBytes));
+    }
+    for (void* block : again) {
+        ASSERT_NE(std::find(blocks.begin(), blocks.end(), block), blocks.end())
+            << "The owner picks its blocks up from the inbox";
+    }
+    ASSERT_EQ(ThreadCachingHeap::GetStats().slabs, after.slabs);
+    for (void* block : again) {
+        ThreadCachingHeap::Deallocate(block, kBytes);
+    }
+}
+
+TEST(ThreadCachingHeapTest, ContainersAcrossThreads) {
+    using Strings = Vector<std::string, ThreadCachingAllocator<std::string>>;
+    ThreadCachingHeap::Deallocate(ThreadCachingHeap::Allocate(16), 16);  // this thread keeps its own cache
+    size_t caches = 0;
+    for (int round = 0; round < 2; ++round) {
+        std::mutex mutex;
+        std::latch started(4);
+        Vector<Strings> produced;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                ThreadCachingHeap::Deallocate(ThreadCachingHeap::Allocate(16), 16);
+                started.arrive_and_wait();  // four caches are live at once, none adopted from a sibling
+                for (int i = 0; i < 50; ++i) {
+                    Strings strings;
+                    for (int j = 0; j < i; ++j) {
+                        strings.PushBack(std::to_string(t * 1000 + j));
+                    }
+                    Deque<int, ThreadCachingAllocator<int>> deque;
+                    for (int j = 0; j < 100; ++j) {
+                        deque.PushBack(j);
+                    }
+                    std::lock_guard lock(mutex);
+                    produced.PushBack(std::move(strings));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(produced.Size(), 200);
+        ASSERT_EQ(produced[199].Size(), 49);
+        produced.Clear();  // every buffer is freed by a thread that did not allocate it
+
+        if (round == 0) {
+            caches = ThreadCachingHeap::GetStats().caches;
+        } else {
+            ASSERT_EQ(ThreadCachingHeap::GetStats().caches, caches) << "New threads adopt abandoned caches";
+        }
+    }
+}
 
-#include "../filesystem/fs.hpp"
+TEST(MemoryResourceTest, PoolResourceSizeClasses) {
+    TrackingResource upstream;
+    PoolResource pool(&upstream);
+    void* small = pool.Allocate(24, 8);
+    pool.Deallocate(small, 24, 8);
+    ASSERT_EQ(pool.Allocate(32, 16), small) << "24 and 32 bytes share a size class";
+    ASSERT_EQ(pool.SlabCount(), 1);
+    ASSERT_EQ(upstream.GetStats().allocations, 0);
 
-class FsTest: public testing::Test {
-  protected:
-    void SetUp() override {
-      fs.MakeDir("/mnt/c/Users/Sysoev/VSCodeProjects/", true);
-      fs.CreateFile("/mnt/c/Users/Sysoev/VSCodeProjects/test.txt", false);
-      fs.CreateFile("/mnt/c/Users/Sysoev/VSCodeProjects/test1.txt", false);
-      fs.CreateFile("/mnt/c/Users/Sysoev/VSCodeProjects/test2.txt", false);
-      fs.CreateFile("/mnt/c/Users/Sysoev/VSCodeProjects/test3.txt", false);
-      fs.CreateFile("/mnt/c/Users/Sysoev/test3.txt", false);
-      fs.CreateFile("/mnt/c/Users/test1.txt", false);
-    }
-  
-public:
-  filesystem::Fs fs;
-};
-
-
-TEST(EmptyFsTest, PWDOnRoot) {
-  filesystem::Fs fs;
-  fs.PWD();
-  // expect: "/"
-}
-
-TEST(EmptyFsTest, EmptyListFiles) {
-  filesystem::Fs fs;
-  fs.ListFiles(".");
-  // expect: 
+    void* large = pool.Allocate(1000);
+    void* aligned = pool.Allocate(64, 64);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+    ASSERT_EQ(upstream.GetStats().allocations, 2) << "Large and over-aligned requests go upstream";
+    pool.Deallocate(large, 1000);
+    pool.Deallocate(aligned, 64, 64);
+    ASSERT_EQ(upstream.GetStats().bytes_in_use, 0);
+    ASSERT_EQ(upstream.GetStats().peak_bytes, 1064);
 }
-
-TEST(EmptyFsTest, SimpleMakeDir) {
-  filesystem::Fs fs;
-  fs.MakeDir("/dir", false);
-  fs.ChangeDir("/dir");
-  fs.PWD();
-  // expect: "/dir"
+
+TEST(MemoryResourceTest, Equality) {
+    NewDeleteResource other_new_delete;
+    ASSERT_TRUE(GetNewDeleteResource()->IsEqual(other_new_delete));
+    ArenaResource first;
+    ArenaResource second;
+    ASSERT_TRUE(first.IsEqual(first));
+    ASSERT_FALSE(first.IsEqual(second));
+    ASSERT_TRUE(PolymorphicAllocator<int>(&first) == PolymorphicAllocator<double>(&first));
+    ASSERT_FALSE(PolymorphicAllocator<int>(&first) == PolymorphicAllocator<int>());
 }
-
-TEST(EmptyFsTest, MakeDirWithFlag) {
-  filesystem::Fs fs;
-  fs.MakeDir("/dir/other_dir", true);
-  fs.ChangeDir("/dir");
-  fs.ChangeDir("other_dir");
-  fs.PWD();
-  // expect: "/dir/other_dir"
-}
-
-TEST(EmptyFsTest, MakeSeveralDirsWithoutFlag) {
-  filesystem::Fs fs;
-  EXPECT_THROW({
-    fs.MakeDir("/dir/other_dir", false);
-  }, filesystem::exceptions::FileNotFoundException);
+
+// Same container type whatever the resource
+using PmrStrings = Vector<std::string, PolymorphicAllocator<std::string>>;
+
+void FillStrings(PmrStrings& strings, int count) {
+    for (int i = 0; i < count; ++i) {
+        strings.PushBack("string number " + std::to_string(i));
+    }
 }
-
-TEST(EmptyFsTest, ChangeDirToNotExistingDir) {
-  filesystem::Fs fs;
-  EXPECT_THROW({
-    fs.ChangeDir("/dir");
-  }, filesystem::exceptions::FileNotFoundException);
+
+TEST(MemoryResourceTest, ResourceChosenAtRuntime) {
+    ArenaResource arena;
+    PoolResource pool;
+    TrackingResource tracking(&pool);
+    for (MemoryResource* resource : {static_cast<MemoryResource*>(&arena), static_cast<MemoryResource*>(&tracking)}) {
+        PmrStrings strings(resource);
+        FillStrings(strings, 100);
+        ASSERT_EQ(strings.Size(), 100);
+        ASSERT_EQ(strings[99], "string number 99");
+    }
+    ASSERT_GT(arena.GetArena().ChunkCount(), 0);
+    ASSERT_GT(tracking.GetStats().allocations, 0);
+    ASSERT_EQ(tracking.GetStats().bytes_in_use, 0);
 }
 
-TEST(EmptyFsTest, SimpleCreateFile) {
-  filesystem::Fs fs;
-  fs.CreateFile("file.txt", false);
-  fs.ListFiles(".");
-  // expect: "file.txt"
+TEST(MemoryResourceTest, PropagationFollowsPmr) {
+    TrackingResource first;
+    TrackingResource second;
+    PmrStrings strings(&first);
+    FillStrings(strings, 50);
+    size_t allocations = first.GetStats().allocations;
+
+    PmrStrings copy = strings;
+    ASSERT_EQ(first.GetStats().allocations, allocations) << "A copy starts on the default resource";
+
+    PmrStrings moved = std::move(strings);
+    ASSERT_EQ(moved.Size(), 50);
+    ASSERT_EQ(first.GetStats().allocations, allocations) << "A move takes the buffer and its resource";
+
+    PmrStrings target(&second);
+    target = std::move(moved);
+    ASSERT_EQ(target[49], "string number 49");
+    ASSERT_GT(second.GetStats().allocations, 0) << "Different resources: elements move into the target's buffer";
+
+    size_t second_allocations = second.GetStats().allocations;
+    target = copy;
+    ASSERT_EQ(target.Size(), 50);
+    ASSERT_GT(second.GetStats().allocations, second_allocations) << "The target keeps its resource on copy";
+}
+
+TEST(MemoryResourceTest, DequeOnResources) {
+    TrackingResource first;
+    TrackingResource second;
+    {
+        Deque<int, PolymorphicAllocator<int>> deque(&first);
+        for (int i = 0; i < 100; ++i) {
+            deque.PushBack(i);
+            deque.PushFront(-i);
+        }
+        Deque<int, PolymorphicAllocator<int>> copy = deque;
+        ASSERT_EQ(copy[0], -99);
+
+        Deque<int, PolymorphicAllocator<int>> other(&second);
+        other.PushBack(1);
+        other = std::move(deque);
+        ASSERT_EQ(other.Size(), 200);
+        ASSERT_EQ(other[199], 99);
+        ASSERT_EQ(first.GetStats().bytes_in_use, 0) << "The moved-from deque gave its blocks back";
+
+        size_t second_allocations = second.GetStats().allocations;
+        Deque<int, PolymorphicAllocator<int>> stolen = std::move(other);
+        ASSERT_EQ(stolen.Size(), 200);
+        ASSERT_EQ(second.GetStats().allocations, second_allocations);
+    }
+    ASSERT_EQ(first.GetStats().bytes_in_use, 0);
+    ASSERT_EQ(second.GetStats().bytes_in_use, 0);
+}
+
+TEST(MemoryResourceTest, SoAVectorOnResources) {
+    using Records = BasicSoAVector<PolymorphicAllocator<std::byte>, OneAndHalfGrowth, int64_t, std::string>;
+    TrackingResource first;
+    TrackingResource second;
+    {
+        Records records(&first);
+        for (int i = 0; i < 50; ++i) {
+            records.EmplaceBack(i, "record " + std::to_string(i));
+        }
+        ASSERT_EQ(records.Capacity(), 63) << "Capacities come from the growth policy";
+        ASSERT_EQ(first.GetStats().allocations, 2 * 11) << "Both columns of every growth step use the resource";
+
+        Records copy = records;
+        Records moved = std::move(records);
+        ASSERT_EQ(first.GetStats().allocations, 2 * 11) << "A copy starts on the default resource, a move steals";
+
+        Records target(&second);
+        target = std::move(moved);
+        ASSERT_EQ(std::get<1>(target[49]), "record 49");
+        ASSERT_GT(second.GetStats().allocations, 0) << "Different resources: rows move into the target's columns";
+        ASSERT_EQ(moved.Size(), 0);
+
+        target = copy;
+        ASSERT_EQ(target.Size(), 50);
+        ASSERT_EQ(first.GetStats().allocations, 2 * 11) << "The target keeps its resource on copy";
+    }
+    ASSERT_EQ(first.GetStats().bytes_in_use, 0);
+    ASSERT_EQ(second.GetStats().bytes_in_use, 0);
 }
 
-TEST(EmptyFsTest, ShowFileContent) {
-  filesystem::Fs fs;
-  std::ostringstream oss;
-  oss << "Hello world!\n";
-  fs.CreateFile("file.txt", false);
-  fs.WriteToFile("file.txt", false, oss);
-  fs.ShowFileContent("file.txt");
-  // expect: "Hello world!"
+TEST(TrackingAllocatorTest, Buckets) {
+    ASSERT_EQ(AllocationStats::Bucket(1), 0);
+    ASSERT_EQ(AllocationStats::Bucket(2), 1);
+    ASSERT_EQ(AllocationStats::Bucket(3), 2);
+    ASSERT_EQ(AllocationStats::Bucket(64), 6);
+    ASSERT_EQ(AllocationStats::Bucket(65), 7);
+    ASSERT_EQ(AllocationStats::Bucket(SIZE_MAX), AllocationStats::kBuckets - 1);
 }
 
-TEST(EmptyFsTest, OverwriteFile) {
-  filesystem::Fs fs;
-  std::ostringstream oss;
-  oss << "Hello world!\n";
-  fs.CreateFile("file.txt", false);
-  fs.WriteToFile("file.txt", false, oss);
-  oss << "Hello Meeeen!\n";
-  fs.WriteToFile("file.txt", true, oss);
-  fs.ShowFileContent("file.txt");
-  // expect: "Hello Meeeen!"
+TEST(TrackingAllocatorTest, CountsAndPeak) {
+    static AllocationTag tag("counts and peak");
+    TrackingAllocator<char> alloc(tag);
+    char* first = alloc.allocate(100);
+    char* second = alloc.allocate(200);
+    alloc.deallocate(first, 100);
+    char* third = alloc.allocate(300);
+    alloc.deallocate(second, 200);
+    alloc.deallocate(third, 300);
+
+    AllocationStats stats = tag.Snapshot();
+    ASSERT_EQ(stats.allocations, 3);
+    ASSERT_EQ(stats.deallocations, 3);
+    ASSERT_EQ(stats.bytes_allocated, 600);
+    ASSERT_EQ(stats.live_bytes, 0);
+    ASSERT_EQ(stats.peak_bytes, 500);
+    ASSERT_EQ(stats.histogram[AllocationStats::Bucket(100)], 1);
+    ASSERT_EQ(stats.histogram[AllocationStats::Bucket(200)], 1);
+    ASSERT_EQ(stats.histogram[AllocationStats::Bucket(300)], 1);
 }
 
-TEST(EmptyFsTest, OverwriteFileByCreate) {
-  filesystem::Fs fs;
-  std::ostringstream oss;
-  oss << "Hello world!\n";
-  fs.CreateFile("file.txt", false);
-  fs.WriteToFile("file.txt", false, oss);
-  fs.CreateFile("file.txt", true);
-  fs.ShowFileContent("file.txt");
-  // expect:
+TEST(TrackingAllocatorTest, ContainersPerTag) {
+    static AllocationTag vector_tag("vector");
+    static AllocationTag list_tag("list on pool");
+    {
+        Vector<int, TrackingAllocator<int>> vector{TrackingAllocator<int>(vector_tag)};
+        List<int, TrackingAllocator<int, PoolAllocator<int>>> list{TrackingAllocator<int, PoolAllocator<int>>(list_tag)};
+        for (int i = 0; i < 1000; ++i) {
+            vector.PushBack(i);
+            list.PushBack(i);
+        }
+        Vector<int, TrackingAllocator<int>> copy = vector;
+        ASSERT_EQ(copy.Size(), 1000);
+        ASSERT_GE(vector_tag.Snapshot().live_bytes, 2 * 1000 * sizeof(int)) << "The copy keeps the tag";
+        ASSERT_EQ(list_tag.Snapshot().allocations, 1001) << "One node per element and the sentinel";
+    }
+    AllocationStats vector_stats = vector_tag.Snapshot();
+    ASSERT_GT(vector_stats.allocations, 2) << "Growth shows up as several allocations";
+    ASSERT_EQ(vector_stats.allocations, vector_stats.deallocations);
+    ASSERT_EQ(vector_stats.live_bytes, 0);
+    ASSERT_EQ(list_tag.Snapshot().live_bytes, 0);
+
+    std::ostringstream out;
+    AllocationTracker::Dump(out);
+    ASSERT_NE(out.str().find("list on pool: 1001 allocations"), std::string::npos);
 }
 
-TEST(EmptyFsTest, OverwriteFirstCreateFile) {
-  filesystem::Fs fs;
-  std::ostringstream oss;
-  oss << "Hello world!\n";
-  fs.CreateFile("file.txt", true);
-  fs.WriteToFile("file.txt", false, oss);
-  fs.ShowFileContent("file.txt");
-  // expect:
+TEST(TrackingAllocatorTest, Threads) {
+    static AllocationTag tag("threads");
+    constexpr int kThreads = 4;
+    constexpr int kBlocks = 10000;
+    for (int round = 0; round < 2; ++round) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([] {
+                TrackingAllocator<int64_t> alloc(tag);
+                std::vector<int64_t*> blocks;
+                for (int i = 0; i < kBlocks; ++i) {
+                    blocks.push_back(alloc.allocate(4));
+                }
+                for (int64_t* block : blocks) {
+                    alloc.deallocate(block, 4);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    AllocationStats stats = tag.Snapshot();
+    ASSERT_EQ(stats.allocations, 2 * kThreads * kBlocks);
+    ASSERT_EQ(stats.live_bytes, 0);
+    ASSERT_GE(stats.peak_bytes, kBlocks * 32);
+    ASSERT_LE(stats.peak_bytes, kThreads * kBlocks * 32);
 }
 
-TEST(EmptyFsTest, SimpleRemoveFile) {
-  filesystem::Fs fs;
-  std::ostringstream oss;
-  oss << "Hello world!\n";
-  fs.CreateFile("file.txt", false);
-  fs.RemoveFile("file.txt");
-  fs.ListFiles(".");
-  // expect:
+TEST(TrackingAllocatorTest, ConcurrentSegmentedVector) {
+    static AllocationTag tag("concurrent segmented vector");
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 10000;
+    {
+        ConcurrentSegmentedVector<int64_t, TrackingAllocator<int64_t>> vec{TrackingAllocator<int64_t>(tag)};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&vec] {
+                for (int i = 0; i < kPerThread; ++i) {
+                    vec.PushBack(i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT_GE(tag.Snapshot().live_bytes, kThreads * kPerThread * sizeof(int64_t))
+            << "Segments and ready bitmaps come from the allocator";
+    }
+    AllocationStats stats = tag.Snapshot();
+    ASSERT_EQ(stats.allocations, stats.deallocations);
+    ASSERT_EQ(stats.live_bytes, 0);
 }
 
-TEST(EmptyFsTest, RemoveNotExistFile) {
-  filesystem::Fs fs;
-  EXPECT_THROW({
-    fs.RemoveFile("file.txt");
-  }, filesystem::exceptions::FileNotFoundException);
+TEST(InlineAllocatorTest, BufferThenUpstream) {
+    static AllocationTag tag("inline upstream");
+    InlineArena<256> arena;
+    InlineAllocator<int, TrackingAllocator<int>> alloc(arena, TrackingAllocator<int>(tag));
+    int* small = alloc.allocate(10);
+    ASSERT_TRUE(arena.Owns(small));
+    int* large = alloc.allocate(100);
+    ASSERT_FALSE(arena.Owns(large));
+    ASSERT_EQ(tag.Snapshot().allocations, 1) << "Only the overflow goes upstream";
+
+    int* top = alloc.allocate(4);
+    size_t used = arena.Used();
+    alloc.deallocate(small, 10);
+    ASSERT_EQ(arena.Used(), used) << "Older blocks wait for Reset";
+    alloc.deallocate(top, 4);
+    ASSERT_EQ(arena.Used(), used - 4 * sizeof(int)) << "The most recent block is given back";
+    alloc.deallocate(large, 100);
+    ASSERT_EQ(tag.Snapshot().live_bytes, 0);
+
+    arena.Reset();
+    ASSERT_EQ(alloc.allocate(1), small);
 }
 
+TEST(InlineAllocatorTest, OverAligned) {
+    struct alignas(64) Line {
+        char bytes[64];
+    };
+    InlineArena<512> arena;
+    InlineAllocator<char> chars(arena);
+    chars.allocate(1);
+    InlineAllocator<Line> lines(chars);
+    Line* line = lines.allocate(2);
+    ASSERT_TRUE(arena.Owns(line));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(line) % 64, 0);
+}
 
-TEST_F(FsTest, SimpleFind) {
-  fs.FindFile("text3.txt");
-  // expect: 
-  // /mnt/c/Users/Sysoev/VSCodeProjects/test3.txt
-  // /mnt/c/Users/Sysoev/test3.txt
-  // 
+TEST(InlineAllocatorTest, ScratchVectorOutgrowsBuffer) {
+    InlineArena<1024> arena;
+    Vector<std::string, InlineAllocator<std::string>> scratch(arena);
+    scratch.Reserve(8);
+    for (int i = 0; i < 8; ++i) {
+        scratch.PushBack(std::to_string(i));
+    }
+    ASSERT_TRUE(arena.Owns(scratch.Data()));
+    for (int i = 8; i < 1000; ++i) {
+        scratch.PushBack(std::to_string(i));
+    }
+    ASSERT_FALSE(arena.Owns(scratch.Data()));
+    ASSERT_EQ(scratch[999], "999");
 }
 
-TEST_F(FsTest, FailedChangeDirToFile) {
-  EXPECT_THROW({
-    fs.ChangeDir("/mnt/c/Users/Sysoev/test3.txt");
-  }, filesystem::exceptions::FileNotFoundException);
+TEST(InlineAllocatorTest, CopyAndMove) {
+    InlineArena<1024> first_arena;
+    InlineArena<1024> second_arena;
+    using Scratch = Vector<int, InlineAllocator<int>>;
+    Scratch first(first_arena);
+    Scratch second(second_arena);
+    for (int i = 0; i < 20; ++i) {
+        first.PushBack(i);
+    }
+    second.PushBack(-1);
+
+    Scratch copy = first;
+    ASSERT_FALSE(first_arena.Owns(copy.Data())) << "A copy may leave the function, so it goes upstream";
+    ASSERT_EQ(copy[19], 19);
+
+    second = first;
+    ASSERT_TRUE(second_arena.Owns(second.Data())) << "The target keeps its buffer";
+    ASSERT_EQ(second.Size(), 20);
+
+    Scratch moved = std::move(first);
+    ASSERT_TRUE(first_arena.Owns(moved.Data())) << "A move keeps buffer and allocator together";
+
+    second = std::move(moved);
+    ASSERT_TRUE(second_arena.Owns(second.Data()));
+    ASSERT_EQ(second[19], 19);
+
+    copy = second;
+    ASSERT_FALSE(second_arena.Owns(copy.Data()));
+    ASSERT_EQ(copy.Size(), 20);
+
+    InlineArena<1024> arena;
+    Scratch target(arena);
+    Scratch empty(arena);
+    target.PushBack(1);
+    for (int i = 0; i < 5; ++i) {
+        target = empty;
+    }
+    ASSERT_EQ(arena.Used(), 0) << "Assigning an empty vector frees the buffer and allocates nothing";
+
+    Scratch small(arena);
+    small.Reserve(2);
+    small.PushBack(7);
+    size_t used = arena.Used();
+    target = small;
+    ASSERT_EQ(arena.Used(), used + DEFAULT_CAPACITY * sizeof(int));
+    target = empty;
+    ASSERT_EQ(arena.Used(), used) << "The buffer is freed with the size it was allocated with";
+    target = std::move(small);
+    ASSERT_EQ(target[0], 7);
+    target = std::move(empty);
+    ASSERT_EQ(arena.Used(), used) << "The same holds for move assignment";
 }
 
-TEST_F(FsTest, DirNotExistForCreateFile) {
-  EXPECT_THROW({
-    fs.ChangeDir("/mnt/c/Users/Sysoev/VSCodeProjects");
-    fs.PWD();
-    // expect: /mnt/c/Users/Sysoev/VSCodeProjects/
-    fs.CreateFile("/dir/file.txt", false);
-  }, filesystem::exceptions::FileNotFoundException);
+TEST(InlineAllocatorTest, Deque) {
+    InlineArena<4096> arena;
+    Deque<int, InlineAllocator<int>> deque{InlineAllocator<int>(arena)};
+    for (int i = 0; i < 200; ++i) {
+        deque.PushBack(i);
+        deque.PushFront(-i);
+    }
+    ASSERT_EQ(deque.Size(), 400);
+    ASSERT_EQ(deque[0], -199);
+    ASSERT_EQ(deque[399], 199);
+    ASSERT_GT(arena.Used(), 0);
 }
 
-TEST_F(FsTest, FileNotFound) {
-  EXPECT_THROW({
-    fs.FindFile("file.cpp");
-  }, filesystem::exceptions::FileNotFoundException);
+TEST(HugePageAllocatorTest, MapIsAligned) {
+    for (size_t bytes : {size_t{1}, HugePages::kHugePageSize, 3 * HugePages::kHugePageSize + 1}) {
+        auto* ptr = static_cast<char*>(HugePages::Map(bytes));
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % HugePages::kHugePageSize, 0);
+        ptr[0] = 1;
+        ptr[HugePages::RoundUp(bytes) - 1] = 1;
+        HugePages::Unmap(ptr, bytes);
+    }
 }
 
-TEST_F(FsTest, DeleteRoot) {
-  fs.RemoveFile("/");
-  fs.ListFiles(".");
-  // expect: 
+TEST(HugePageAllocatorTest, SmallRequestsGoUpstream) {
+    static AllocationTag tag("huge page upstream");
+    using Alloc = HugePageAllocator<int64_t, TrackingAllocator<int64_t>>;
+    Alloc alloc{TrackingAllocator<int64_t>(tag)};
+    size_t threshold = HugePages::kHugePageSize / sizeof(int64_t);
+    ASSERT_FALSE(Alloc::IsHuge(threshold - 1));
+    ASSERT_TRUE(Alloc::IsHuge(threshold));
+
+    int64_t* small = alloc.allocate(threshold - 1);
+    int64_t* large = alloc.allocate(threshold);
+    ASSERT_EQ(tag.Snapshot().allocations, 1);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(large) % HugePages::kHugePageSize, 0);
+    alloc.deallocate(small, threshold - 1);
+    alloc.deallocate(large, threshold);
+    ASSERT_EQ(tag.Snapshot().live_bytes, 0);
 }
 
-int main(int argc, char **argv) {
-  ::testing::InitGoogleTest(&argc, argv);
+TEST(HugePageAllocatorTest, Containers) {
+    Vector<int64_t, HugePageAllocator<int64_t>> vector;
+    for (int64_t i = 0; i < (1 << 20); ++i) {
+        vector.PushBack(i);
+    }
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(vector.Data()) % HugePages::kHugePageSize, 0);
+    ASSERT_EQ(vector[(1 << 20) - 1], (1 << 20) - 1);
+    Vector<int64_t, HugePageAllocator<int64_t>> copy = vector;
+    ASSERT_EQ(copy[12345], 12345);
 
-  return RUN_ALL_TESTS();
-}
\ No newline at end of file
+    Deque<int64_t, HugePageAllocator<int64_t>> deque;
+    for (int64_t i = 0; i < 10000; ++i) {
+        deque.PushBack(i);
+    }
+    ASSERT_EQ(deque[9999], 9999);
+}
@@ -0,0 +1,377 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+// Size-class heap with a cache per thread, in the spirit of tcmalloc and mimalloc.
+//
+// Small blocks (up to kMaxSmallSize) are carved from kSlabSize-aligned slabs. Every slab belongs
+// to the thread cache that carved it; the owner is found by masking the block address. A block freed
+// by its owner goes onto the owner's local freelist, a block freed by any other thread is pushed onto
+// the owner's lock-free inbox and picked up by the owner on its next miss. Local lists that grow past
+// a watermark give a batch back to the central heap, and a miss that the inbox cannot serve takes a
+// batch from there, so the central mutex is touched once per batch rather than once per block.
+//
+// Caches are never destroyed: a cache of an exited thread is flushed to the central heap and adopted
+// by the next new thread, so a late remote free never lands in freed memory. Slabs are kept for the
+// lifetime of the process.
+class ThreadCachingHeap {
+public:
+    static constexpr size_t kSlabSize = 256 * 1024;
+    static constexpr size_t kMaxSmallSize = 32 * 1024;
+    static constexpr size_t kAlign = 16;  // every class size is a multiple of it
+    static constexpr size_t kClassCount = 40;
+
+    // 16-byte steps up to 128, then four classes per power of two
+    static constexpr size_t SizeClass(size_t bytes) {
+        if (bytes <= 128) {
+            return bytes <= 16 ? 0 : (bytes - 1) / 16;
+        }
+        size_t power = std::bit_width(bytes - 1) - 1;  // 2^power < bytes <= 2^(power + 1)
+        return 8 + (power - 7) * 4 + ((bytes - 1 - (size_t{1} << power)) >> (power - 2));
+    }
+
+    static constexpr size_t ClassSize(size_t size_class) {
+        if (size_class < 8) {
+            return 16 * (size_class + 1);
+        }
+        size_t power = 7 + (size_class - 8) / 4;
+        return (size_t{1} << power) + ((size_class - 8) % 4 + 1) * (size_t{1} << (power - 2));
+    }
+
+    // Blocks moved between a thread cache and the central heap at once
+    static constexpr size_t BatchSize(size_t size_class) {
+        return std::clamp<size_t>(16 * 1024 / ClassSize(size_class), 2, 64);
+    }
+
+    struct Stats {
+        size_t slabs = 0;
+        size_t central_refills = 0;  // batches a thread cache took from the central heap
+        size_t central_returns = 0;  // batches a thread cache gave back
+        size_t remote_frees = 0;     // blocks freed by a thread that does not own their slab
+        size_t caches = 0;           // thread caches ever created (live and adopted ones)
+    };
+
+    // bytes must be at most kMaxSmallSize
+    static void* Allocate(size_t bytes) {
+        size_t size_class = SizeClass(bytes);
+        ThreadCache* cache = LocalCache();
+        if (cache == nullptr) {
+            return Central().AllocateOne(size_class);
+        }
+        FreeList& list = cache->local[size_class];
+        if (list.head == nullptr) {
+            cache->Refill(size_class);
+        }
+        FreeBlock* block = list.head;
+        list.head = block->next;
+        --list.count;
+        return block;
+    }
+
+    // bytes must be the size passed to Allocate
+    static void Deallocate(void* ptr, size_t bytes) noexcept {
+        size_t size_class = SizeClass(bytes);
+        auto* block = static_cast<FreeBlock*>(ptr);
+        ThreadCache* owner = SlabOf(ptr)->owner;
+        ThreadCache* cache = tls_cache;
+        if (owner == cache && cache != nullptr) {
+            FreeList& list = cache->local[size_class];
+            block->next = list.head;
+            list.head = block;
+            if (++list.count > 2 * BatchSize(size_class)) {
+                Central().Return(list, size_class, BatchSize(size_class));
+            }
+            return;
+        }
+        Central().remote_frees.fetch_add(1, std::memory_order_relaxed);
+        if (owner == nullptr) {
+            Central().Push(block, block, 1, size_class);
+            return;
+        }
+        std::atomic<FreeBlock*>& inbox = owner->inbox[size_class];
+        block->next = inbox.load(std::memory_order_relaxed);
+        while (!inbox.compare_exchange_weak(block->next, block, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+
+    static Stats GetStats() {
+        CentralHeap& central = Central();
+        std::lock_guard lock(central.mutex);
+        Stats stats;
+        stats.slabs = central.slabs;
+        stats.central_refills = central.refills;
+        stats.central_returns = central.returns;
+        stats.remote_frees = central.remote_frees.load(std::memory_order_relaxed);
+        stats.caches = central.caches;
+        return stats;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct FreeList {
+        FreeBlock* head = nullptr;
+        size_t count = 0;
+    };
+
+    struct ThreadCache;
+
+    struct alignas(kAlign) Slab {
+        ThreadCache* owner;  // nullptr for slabs carved after the calling thread's cache was released
+        Slab* next;
+    };
+
+    static constexpr size_t kHeaderSize = sizeof(Slab);
+
+    struct ThreadCache {
+        FreeList local[kClassCount];
+        std::atomic<FreeBlock*> inbox[kClassCount] = {};
+        ThreadCache* next_abandoned = nullptr;
+
+        void Refill(size_t size_class) {
+            FreeBlock* remote = inbox[size_class].exchange(nullptr, std::memory_order_acquire);
+            if (remote != nullptr) {
+                size_t count = 0;
+                for (FreeBlock* block = remote; block != nullptr; block = block->next) {
+                    ++count;
+                }
+                local[size_class] = {remote, count};
+                return;
+            }
+            Central().Refill(this, size_class);
+        }
+    };
+
+    struct CentralHeap {
+        std::mutex mutex;
+        FreeList lists[kClassCount];
+        ThreadCache* abandoned = nullptr;
+        Slab* slabs_head = nullptr;
+        size_t slabs = 0;
+        size_t refills = 0;
+        size_t returns = 0;
+        size_t caches = 0;
+        std::atomic<size_t> remote_frees = 0;
+
+        void Refill(ThreadCache* cache, size_t size_class) {
+            std::lock_guard lock(mutex);
+            ++refills;
+            FreeList& central = lists[size_class];
+            if (central.head == nullptr) {
+                this->DrainAbandoned(size_class);
+            }
+            if (central.head == nullptr) {
+                // The cache takes a batch of the new slab like any other, the rest waits here
+                central = this->CarveSlab(cache, size_class);
+            }
+            FreeList& local = cache->local[size_class];
+            size_t take = std::min(central.count, BatchSize(size_class));
+            FreeBlock* last = central.head;
+            for (size_t i = 1; i < take; ++i) {
+                last = last->next;
+            }
+            local.head = central.head;
+            local.count = take;
+            central.head = last->next;
+            central.count -= take;
+            last->next = nullptr;
+        }
+
+        // Moves the first count blocks of list to the central heap
+        void Return(FreeList& list, size_t size_class, size_t count) {
+            FreeBlock* first = list.head;
+            FreeBlock* last = first;
+            for (size_t i = 1; i < count; ++i) {
+                last = last->next;
+            }
+            list.head = last->next;
+            list.count -= count;
+            std::lock_guard lock(mutex);
+            ++returns;
+            this->PushLocked(first, last, count, size_class);
+        }
+
+        void Push(FreeBlock* first, FreeBlock* last, size_t count, size_t size_class) {
+            std::lock_guard lock(mutex);
+            this->PushLocked(first, last, count, size_class);
+        }
+
+        void PushLocked(FreeBlock* first, FreeBlock* last, size_t count, size_t size_class) {
+            FreeList& central = lists[size_class];
+            last->next = central.head;
+            central.head = first;
+            central.count += count;
+        }
+
+        void* AllocateOne(size_t size_class) {
+            std::lock_guard lock(mutex);
+            FreeList& central = lists[size_class];
+            if (central.head == nullptr) {
+                this->DrainAbandoned(size_class);
+            }
+            if (central.head == nullptr) {
+                central = this->CarveSlab(nullptr, size_class);
+            }
+            FreeBlock* block = central.head;
+            central.head = block->next;
+            --central.count;
+            return block;
+        }
+
+        // Remote frees that arrived after their owner exited
+        void DrainAbandoned(size_t size_class) {
+            for (ThreadCache* cache = abandoned; cache != nullptr; cache = cache->next_abandoned) {
+                FreeBlock* block = cache->inbox[size_class].exchange(nullptr, std::memory_order_acquire);
+                while (block != nullptr) {
+                    FreeBlock* next = block->next;
+                    this->PushLocked(block, block, 1, size_class);
+                    block = next;
+                }
+            }
+        }
+
+        FreeList CarveSlab(ThreadCache* owner, size_t size_class) {
+            auto* slab = static_cast<Slab*>(::operator new(kSlabSize, std::align_val_t(kSlabSize)));
+            slab->owner = owner;
+            slab->next = slabs_head;
+            slabs_head = slab;
+            ++slabs;
+
+            size_t size = ClassSize(size_class);
+            size_t count = (kSlabSize - kHeaderSize) / size;
+            char* begin = reinterpret_cast<char*>(slab) + kHeaderSize;
+            for (size_t i = 0; i + 1 < count; ++i) {
+                reinterpret_cast<FreeBlock*>(begin + i * size)->next = reinterpret_cast<FreeBlock*>(begin + (i + 1) * size);
+            }
+            reinterpret_cast<FreeBlock*>(begin + (count - 1) * size)->next = nullptr;
+            return {reinterpret_cast<FreeBlock*>(begin), count};
+        }
+
+        ThreadCache* Acquire() {
+            std::lock_guard lock(mutex);
+            if (abandoned != nullptr) {
+                ThreadCache* cache = abandoned;
+                abandoned = cache->next_abandoned;
+                cache->next_abandoned = nullptr;
+                return cache;
+            }
+            ++caches;
+            return new ThreadCache();
+        }
+
+        // The local lists go to the central heap, the inbox stays with the cache
+        void Abandon(ThreadCache* cache) {
+            std::lock_guard lock(mutex);
+            for (size_t size_class = 0; size_class < kClassCount; ++size_class) {
+                FreeList& list = cache->local[size_class];
+                while (list.head != nullptr) {
+                    FreeBlock* next = list.head->next;
+                    this->PushLocked(list.head, list.head, 1, size_class);
+                    list.head = next;
+                }
+                list.count = 0;
+            }
+            cache->next_abandoned = abandoned;
+            abandoned = cache;
+        }
+    };
+
+    // Adopts a cache on the first allocation of a thread and abandons it when the thread exits
+    struct CacheOwner {
+        CacheOwner() : cache(Central().Acquire()) {
+            tls_cache = cache;
+        }
+
+        CacheOwner(const CacheOwner&) = delete;
+        CacheOwner& operator=(const CacheOwner&) = delete;
+
+        ~CacheOwner() {
+            tls_cache = nullptr;
+            tls_released = true;
+            Central().Abandon(cache);
+        }
+
+        ThreadCache* cache;
+    };
+
+    // Leaked on purpose: blocks may still be freed while other statics are destroyed
+    static CentralHeap& Central() {
+        static auto* central = new CentralHeap();
+        return *central;
+    }
+
+    // nullptr once the thread's cache was released during thread exit
+    static ThreadCache* LocalCache() {
+        if (tls_cache == nullptr && !tls_released) {
+            thread_local CacheOwner owner;
+        }
+        return tls_cache;
+    }
+
+    static Slab* SlabOf(void* ptr) noexcept {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(ptr) & ~(kSlabSize - 1));
+    }
+
+    static inline thread_local ThreadCache* tls_cache = nullptr;
+    static inline thread_local bool tls_released = false;
+};
+
+static_assert(ThreadCachingHeap::SizeClass(ThreadCachingHeap::kMaxSmallSize) == ThreadCachingHeap::kClassCount - 1);
+
+// std::allocator_traits adapter over ThreadCachingHeap. Stateless: any instance frees what another allocated.
+// Blocks larger than ThreadCachingHeap::kMaxSmallSize or over-aligned types go to operator new.
+template <typename T>
+class ThreadCachingAllocator {
+public:
+    // NOLINTNEXTLINE
+    using value_type = T;
+    // NOLINTNEXTLINE
+    using is_always_equal = std::true_type;
+
+    ThreadCachingAllocator() = default;
+
+    template <typename U>
+    ThreadCachingAllocator(const ThreadCachingAllocator<U>& /*other*/) noexcept {  // NOLINT
+    }
+
+    // NOLINTNEXTLINE
+    T* allocate(size_t count) {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        if (!IsSmall(count)) {
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        return static_cast<T*>(ThreadCachingHeap::Allocate(count * sizeof(T)));
+    }
+
+    // NOLINTNEXTLINE
+    void deallocate(T* ptr, size_t count) noexcept {
+        if (!IsSmall(count)) {
+            ::operator delete(ptr, std::align_val_t(alignof(T)));
+            return;
+        }
+        ThreadCachingHeap::Deallocate(ptr, count * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ThreadCachingAllocator<U>& /*other*/) const noexcept {
+        return true;
+    }
+
+private:
+    static bool IsSmall(size_t count) noexcept {
+        return alignof(T) <= ThreadCachingHeap::kAlign && count * sizeof(T) <= ThreadCachingHeap::kMaxSmallSize;
+    }
+};
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// What went through the allocators of one tag
+struct AllocationStats {
+    static constexpr size_t kBuckets = 48;  // bucket b counts requests of (2^(b-1), 2^b] bytes
+
+    static constexpr size_t Bucket(size_t bytes) {
+        return bytes <= 1 ? 0 : std::min<size_t>(std::bit_width(bytes - 1), kBuckets - 1);
+    }
+
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes_allocated = 0;
+    uint64_t live_bytes = 0;
+    uint64_t peak_bytes = 0;
+    std::array<uint64_t, kBuckets> histogram = {};
+};
+
+// Counters of every tag, kept per thread. A thread only writes its own counters, so recording is a
+// few relaxed loads and stores; Snapshot sums all threads. Counters of an exited thread are adopted
+// by the next new thread, so nothing is lost and the number of counter blocks stays bounded.
+//
+// Peak bytes need a shared live counter: a thread adds its net bytes to it when they exceed
+// kFlushBytes or when its own live bytes reach a new maximum. The peak is exact for a tag used by a
+// single thread and may miss up to kFlushBytes per concurrently allocating thread otherwise.
+class AllocationTracker {
+public:
+    static constexpr size_t kMaxTags = 64;
+    static constexpr int64_t kFlushBytes = 64 * 1024;
+
+    // Throws std::length_error when kMaxTags tags exist
+    static size_t Register(std::string name) {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        if (registry.tag_count == kMaxTags) {
+            throw std::length_error("too many allocation tags");
+        }
+        registry.names[registry.tag_count] = std::move(name);
+        return registry.tag_count++;
+    }
+
+    static void RecordAllocate(size_t tag, size_t bytes) noexcept {
+        Record(tag, [bytes](TagCounters& counters) {
+            Bump(counters.allocations, 1);
+            Bump(counters.bytes_allocated, bytes);
+            Bump(counters.histogram[AllocationStats::Bucket(bytes)], 1);
+            counters.pending += static_cast<int64_t>(bytes);
+            counters.live += static_cast<int64_t>(bytes);
+            return counters.pending >= kFlushBytes || counters.live > counters.peak;
+        });
+    }
+
+    static void RecordDeallocate(size_t tag, size_t bytes) noexcept {
+        Record(tag, [bytes](TagCounters& counters) {
+            Bump(counters.deallocations, 1);
+            Bump(counters.bytes_freed, bytes);
+            counters.pending -= static_cast<int64_t>(bytes);
+            counters.live -= static_cast<int64_t>(bytes);
+            return counters.pending <= -kFlushBytes;
+        });
+    }
+
+    static AllocationStats Snapshot(size_t tag) {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        AllocationStats stats;
+        uint64_t bytes_freed = 0;
+        for (ThreadCounters* thread = registry.threads; thread != nullptr; thread = thread->next) {
+            const TagCounters& counters = thread->tags[tag];
+            stats.allocations += counters.allocations.load(std::memory_order_relaxed);
+            stats.deallocations += counters.deallocations.load(std::memory_order_relaxed);
+            stats.bytes_allocated += counters.bytes_allocated.load(std::memory_order_relaxed);
+            bytes_freed += counters.bytes_freed.load(std::memory_order_relaxed);
+            for (size_t bucket = 0; bucket < AllocationStats::kBuckets; ++bucket) {
+                stats.histogram[bucket] += counters.histogram[bucket].load(std::memory_order_relaxed);
+            }
+        }
+        stats.live_bytes = stats.bytes_allocated > bytes_freed ? stats.bytes_allocated - bytes_freed : 0;
+        auto peak = static_cast<uint64_t>(std::max<int64_t>(registry.shared[tag].peak.load(std::memory_order_relaxed), 0));
+        stats.peak_bytes = std::max(peak, stats.live_bytes);
+        return stats;
+    }
+
+    static const std::string& Name(size_t tag) {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        return registry.names[tag];
+    }
+
+    // One line per tag that allocated anything, followed by its non-empty histogram buckets
+    static void Dump(std::ostream& out) {
+        size_t tag_count = 0;
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            tag_count = registry.tag_count;
+        }
+        for (size_t tag = 0; tag < tag_count; ++tag) {
+            AllocationStats stats = Snapshot(tag);
+            if (stats.allocations == 0) {
+                continue;
+            }
+            out << fmt::format("{}: {} allocations, {} deallocations, {} bytes, {} live, {} peak\n", Name(tag),
+                               stats.allocations, stats.deallocations, stats.bytes_allocated, stats.live_bytes,
+                               stats.peak_bytes);
+            for (size_t bucket = 0; bucket < AllocationStats::kBuckets; ++bucket) {
+                if (stats.histogram[bucket] != 0) {
+                    out << fmt::format("  <= {} bytes: {}\n", uint64_t{1} << bucket, stats.histogram[bucket]);
+                }
+            }
+        }
+    }
+
+private:
+    struct TagCounters {
+        std::atomic<uint64_t> allocations = 0;
+        std::atomic<uint64_t> deallocations = 0;
+        std::atomic<uint64_t> bytes_allocated = 0;
+        std::atomic<uint64_t> bytes_freed = 0;
+        std::atomic<uint64_t> histogram[AllocationStats::kBuckets] = {};
+        int64_t pending = 0;  // net bytes not yet added to the shared live counter
+        int64_t live = 0;     // net bytes of this thread
+        int64_t peak = 0;     // largest live seen by this thread
+    };
+
+    struct ThreadCounters {
+        TagCounters tags[kMaxTags];
+        ThreadCounters* next = nullptr;       // all blocks ever created
+        ThreadCounters* next_free = nullptr;  // blocks of exited threads
+    };
+
+    struct SharedCounters {
+        std::atomic<int64_t> live = 0;
+        std::atomic<int64_t> peak = 0;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::string names[kMaxTags];
+        size_t tag_count = 0;
+        SharedCounters shared[kMaxTags];
+        ThreadCounters orphan;  // used under the mutex by threads whose block was already released
+        ThreadCounters* threads = &orphan;
+        ThreadCounters* free = nullptr;
+    };
+
+    // Adopts a block on the first record of a thread and gives it back when the thread exits
+    struct CounterOwner {
+        CounterOwner() {
+            Registry& registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            if (registry.free != nullptr) {
+                counters = registry.free;
+                registry.free = counters->next_free;
+            } else {
+                counters = new ThreadCounters();
+                counters->next = registry.threads;
+                registry.threads = counters;
+            }
+            tls_counters = counters;
+        }
+
+        CounterOwner(const CounterOwner&) = delete;
+        CounterOwner& operator=(const CounterOwner&) = delete;
+
+        ~CounterOwner() {
+            tls_counters = nullptr;
+            tls_released = true;
+            Registry& registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            for (size_t tag = 0; tag < kMaxTags; ++tag) {
+                Flush(registry, tag, counters->tags[tag]);
+                counters->tags[tag].live = 0;
+                counters->tags[tag].peak = 0;
+            }
+            counters->next_free = registry.free;
+            registry.free = counters;
+        }
+
+        ThreadCounters* counters;
+    };
+
+    // Leaked on purpose: containers may still deallocate while other statics are destroyed
+    static Registry& GetRegistry() {
+        static auto* registry = new Registry();
+        return *registry;
+    }
+
+    static void Bump(std::atomic<uint64_t>& counter, uint64_t delta) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static void Flush(Registry& registry, size_t tag, TagCounters& counters) noexcept {
+        SharedCounters& shared = registry.shared[tag];
+        int64_t live = shared.live.fetch_add(counters.pending, std::memory_order_relaxed) + counters.pending;
+        counters.pending = 0;
+        counters.peak = std::max(counters.peak, counters.live);
+        int64_t peak = shared.peak.load(std::memory_order_relaxed);
+        while (live > peak && !shared.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    // update changes the counters and tells whether to flush them into the shared live counter
+    template <typename Update>
+    static void Record(size_t tag, Update update) noexcept {
+        if (tls_counters == nullptr && !tls_released) {
+            try {
+                thread_local CounterOwner owner;
+            } catch (...) {
+                // out of memory for the block: fall back to the orphan counters below
+            }
+        }
+        if (tls_counters != nullptr) {
+            TagCounters& counters = tls_counters->tags[tag];
+            if (update(counters)) {
+                Flush(GetRegistry(), tag, counters);
+            }
+            return;
+        }
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        TagCounters& counters = registry.orphan.tags[tag];
+        update(counters);
+        Flush(registry, tag, counters);
+    }
+
+    static inline thread_local ThreadCounters* tls_counters = nullptr;
+    static inline thread_local bool tls_released = false;
+};
+
+// Names a group of allocations, e.g. one container or one kind of request. Tags are registered for
+// the lifetime of the process, so they are meant to be static objects.
+class AllocationTag {
+public:
+    explicit AllocationTag(std::string name) : id_(AllocationTracker::Register(std::move(name))) {
+    }
+
+    AllocationTag(const AllocationTag&) = delete;
+    AllocationTag& operator=(const AllocationTag&) = delete;
+
+    // Used by default-constructed tracking allocators
+    static AllocationTag& Untagged() {
+        static AllocationTag tag("untagged");
+        return tag;
+    }
+
+    size_t Id() const noexcept {
+        return id_;
+    }
+
+    const std::string& Name() const {
+        return AllocationTracker::Name(id_);
+    }
+
+    AllocationStats Snapshot() const {
+        return AllocationTracker::Snapshot(id_);
+    }
+
+private:
+    size_t id_;
+};
+
+// Wraps any allocator and records every allocation under a tag. Memory, equality and propagation
+// are those of Inner; copies and rebinds keep the tag.
+template <typename T, typename Inner = std::allocator<T>>
+class TrackingAllocator {
+    using InnerTraits = std::allocator_traits<Inner>;
+
+public:
+    // NOLINTNEXTLINE
+    using value_type = T;
+    // NOLINTNEXTLINE
+    using propagate_on_container_copy_assignment = typename InnerTraits::propagate_on_container_copy_assignment;
+    // NOLINTNEXTLINE
+    using propagate_on_container_move_assignment = typename InnerTraits::propagate_on_container_move_assignment;
+    // NOLINTNEXTLINE
+    using propagate_on_container_swap = typename InnerTraits::propagate_on_container_swap;
+    // NOLINTNEXTLINE
+    using is_always_equal = typename InnerTraits::is_always_equal;
+
+    template <typename U>
+    // NOLINTNEXTLINE
+    struct rebind {
+        using other = TrackingAllocator<U, typename InnerTraits::template rebind_alloc<U>>;
+    };
+
+    TrackingAllocator() : tag_(&AllocationTag::Untagged()) {
+    }
+
+    explicit TrackingAllocator(const AllocationTag& tag, const Inner& inner = Inner()) : inner_(inner), tag_(&tag) {
+    }
+
+    template <typename U, typename OtherInner>
+    TrackingAllocator(const TrackingAllocator<U, OtherInner>& other)  // NOLINT
+        : inner_(other.GetInner()), tag_(&other.GetTag()) {
+    }
+
+    // NOLINTNEXTLINE
+    T* allocate(size_t count) {
+        T* ptr = InnerTraits::allocate(inner_, count);
+        AllocationTracker::RecordAllocate(tag_->Id(), count * sizeof(T));
+        return ptr;
+    }
+
+    // NOLINTNEXTLINE
+    void deallocate(T* ptr, size_t count) noexcept {
+        AllocationTracker::RecordDeallocate(tag_->Id(), count * sizeof(T));
+        InnerTraits::deallocate(inner_, ptr, count);
+    }
+
+    // NOLINTNEXTLINE
+    TrackingAllocator select_on_container_copy_construction() const {
+        return TrackingAllocator(*tag_, InnerTraits::select_on_container_copy_construction(inner_));
+    }
+
+    const Inner& GetInner() const noexcept {
+        return inner_;
+    }
+
+    const AllocationTag& GetTag() const noexcept {
+        return *tag_;
+    }
+
+    template <typename U, typename OtherInner>
+    bool operator==(const TrackingAllocator<U, OtherInner>& other) const noexcept {
+        return inner_ == other.GetInner();
+    }
+
+private:
+    Inner inner_;
+    const AllocationTag* tag_;
+};
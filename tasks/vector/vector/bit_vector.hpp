@@ -0,0 +1,455 @@
+#pragma once
+
+#include <bit>
+
+#include "simd_algorithms.hpp"
+#include "vector.hpp"
+
+// Vector<bool> packs 64 flags into every word.
+// Bits at positions >= Size() are always zero, up to the whole capacity, so Count, Find*
+// and the bitwise operators work on whole words and PushBack only ever sets bits.
+template <typename Alloc, typename GrowthPolicy>
+class Vector<bool, Alloc, GrowthPolicy> {
+public:
+    using Word = uint64_t;
+    static constexpr size_t kWordBits = 64;
+
+    class Reference {
+    public:
+        operator bool() const noexcept {
+            return (*word_ & mask_) != 0;
+        }
+
+        Reference& operator=(bool value) noexcept {
+            *word_ = value ? *word_ | mask_ : *word_ & ~mask_;
+            return *this;
+        }
+
+        Reference& operator=(const Reference& other) noexcept {
+            return *this = static_cast<bool>(other);
+        }
+
+        void Flip() noexcept {
+            *word_ ^= mask_;
+        }
+
+    private:
+        friend Vector;
+
+        Reference(Word* word, Word mask) : word_(word), mask_(mask) {
+        }
+
+        Word* word_;
+        Word mask_;
+    };
+
+    // Random access over bit positions; dereferences to Reference or bool
+    template <bool Const>
+    class BitIterator {
+    public:
+        // NOLINTNEXTLINE
+        using value_type = bool;
+        // NOLINTNEXTLINE
+        using reference = std::conditional_t<Const, bool, Reference>;
+        // NOLINTNEXTLINE
+        using difference_type = std::ptrdiff_t;
+        // NOLINTNEXTLINE
+        using iterator_category = std::random_access_iterator_tag;
+
+        BitIterator() = default;
+
+        reference operator*() const noexcept {
+            if constexpr (Const) {
+                return (words_[pos_ / kWordBits] >> (pos_ % kWordBits) & 1) != 0;
+            } else {
+                return Reference(words_ + pos_ / kWordBits, Word{1} << (pos_ % kWordBits));
+            }
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return *(*this + offset);
+        }
+
+        BitIterator& operator++() noexcept {
+            ++pos_;
+            return *this;
+        }
+
+        BitIterator operator++(int) noexcept {
+            BitIterator copy = *this;
+            ++pos_;
+            return copy;
+        }
+
+        BitIterator& operator--() noexcept {
+            --pos_;
+            return *this;
+        }
+
+        BitIterator operator--(int) noexcept {
+            BitIterator copy = *this;
+            --pos_;
+            return copy;
+        }
+
+        BitIterator& operator+=(difference_type offset) noexcept {
+            pos_ += offset;
+            return *this;
+        }
+
+        BitIterator& operator-=(difference_type offset) noexcept {
+            pos_ -= offset;
+            return *this;
+        }
+
+        BitIterator operator+(difference_type offset) const noexcept {
+            return BitIterator(words_, pos_ + offset);
+        }
+
+        friend BitIterator operator+(difference_type offset, const BitIterator& it) noexcept {
+            return it + offset;
+        }
+
+        BitIterator operator-(difference_type offset) const noexcept {
+            return BitIterator(words_, pos_ - offset);
+        }
+
+        difference_type operator-(const BitIterator& other) const noexcept {
+            return static_cast<difference_type>(pos_) - static_cast<difference_type>(other.pos_);
+        }
+
+        bool operator==(const BitIterator& other) const noexcept {
+            return pos_ == other.pos_;
+        }
+
+        auto operator<=>(const BitIterator& other) const noexcept {
+            return pos_ <=> other.pos_;
+        }
+
+    private:
+        friend Vector;
+
+        using WordPtr = std::conditional_t<Const, const Word*, Word*>;
+
+        BitIterator(WordPtr words, size_t pos) : words_(words), pos_(pos) {
+        }
+
+        WordPtr words_ = nullptr;
+        size_t pos_ = 0;
+    };
+
+    using Iterator = BitIterator<false>;
+    using ConstIterator = BitIterator<true>;
+
+    Vector(){};
+
+    explicit Vector(size_t count, bool value = false) : Vector() {
+        this->Resize(count, value);
+    }
+
+    Vector(std::initializer_list<bool> init) : Vector() {
+        this->Reserve(init.size());
+        for (bool value : init) {
+            this->PushBack(value);
+        }
+    }
+
+    Vector(const Vector& other) : alloc_(WordAllocTraits::select_on_container_copy_construction(other.alloc_)) {
+        this->Reserve(other.size_);
+        if (other.size_ > 0) {
+            std::memcpy(words_, other.words_, WordsFor(other.size_) * sizeof(Word));
+        }
+        size_ = other.size_;
+    }
+
+    Vector(Vector&& other) noexcept
+        : words_(std::exchange(other.words_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          cap_(std::exchange(other.cap_, 0)),
+          alloc_(std::move(other.alloc_)) {
+    }
+
+    Vector& operator=(const Vector& other) {
+        if (this != &other) {
+            Vector tmp(other);
+            this->Swap(tmp);
+        }
+        return *this;
+    }
+
+    Vector& operator=(Vector&& other) noexcept {
+        if (this != &other) {
+            Vector tmp(std::move(other));
+            this->Swap(tmp);
+        }
+        return *this;
+    }
+
+    void Swap(Vector& other) noexcept {
+        std::swap(words_, other.words_);
+        std::swap(size_, other.size_);
+        std::swap(cap_, other.cap_);
+        std::swap(alloc_, other.alloc_);
+    }
+
+    Reference operator[](size_t pos) noexcept {
+        return Reference(words_ + pos / kWordBits, Word{1} << (pos % kWordBits));
+    }
+
+    bool operator[](size_t pos) const noexcept {
+        return this->Test(pos);
+    }
+
+    bool Test(size_t pos) const noexcept {
+        return (words_[pos / kWordBits] >> (pos % kWordBits) & 1) != 0;
+    }
+
+    void Set(size_t pos, bool value = true) noexcept {
+        (*this)[pos] = value;
+    }
+
+    void Reset(size_t pos) noexcept {
+        (*this)[pos] = false;
+    }
+
+    void Flip(size_t pos) noexcept {
+        (*this)[pos].Flip();
+    }
+
+    bool Front() const noexcept {
+        return this->Test(0);
+    }
+
+    bool Back() const noexcept {
+        return this->Test(size_ - 1);
+    }
+
+    void PushBack(bool value) {
+        if (size_ == cap_) {
+            this->Reserve(kWordBits * GrowthPolicy::NextCapacity(cap_ / kWordBits, WordsFor(size_ + 1), sizeof(Word)));
+        }
+        if (value) {
+            words_[size_ / kWordBits] |= Word{1} << (size_ % kWordBits);
+        }
+        ++size_;
+    }
+
+    void PopBack() noexcept {
+        if (size_ != 0) {
+            this->Reset(--size_);
+        }
+    }
+
+    // new_cap and Capacity() are in bits; new words are zeroed here once
+    void Reserve(size_t new_cap) {
+        size_t new_words = WordsFor(new_cap);
+        if (new_words <= cap_ / kWordBits) {
+            return;
+        }
+        Word* new_arr = WordAllocTraits::allocate(alloc_, new_words);
+        size_t used = WordsFor(size_);
+        if (used > 0) {
+            std::memcpy(new_arr, words_, used * sizeof(Word));
+        }
+        std::memset(new_arr + used, 0, (new_words - used) * sizeof(Word));
+        if (words_ != nullptr) {
+            WordAllocTraits::deallocate(alloc_, words_, cap_ / kWordBits);
+        }
+        words_ = new_arr;
+        cap_ = new_words * kWordBits;
+    }
+
+    void Resize(size_t count, bool value = false) {
+        if (count <= size_) {
+            this->ClearRange(count, size_);
+            size_ = count;
+            return;
+        }
+        if (count > cap_) {
+            this->Reserve(kWordBits * GrowthPolicy::NextCapacity(cap_ / kWordBits, WordsFor(count), sizeof(Word)));
+        }
+        size_t old_size = size_;
+        size_ = count;
+        if (value) {
+            this->SetRange(old_size, count);
+        }
+    }
+
+    void Clear() noexcept {
+        this->ClearRange(0, size_);
+        size_ = 0;
+    }
+
+    // Half-open [first, last): whole words are filled, only the two edges are masked
+    void SetRange(size_t first, size_t last) noexcept {
+        this->FillRange(first, last, ~Word{0});
+    }
+
+    void ClearRange(size_t first, size_t last) noexcept {
+        this->FillRange(first, last, 0);
+    }
+
+    // Number of set bits
+    size_t Count() const noexcept {
+        return simd::PopCount(words_, WordsFor(size_));
+    }
+
+    // Position of the first set bit at or after from, or Size()
+    size_t FindFirstSet(size_t from = 0) const noexcept {
+        return this->FindFirst(from, 0);
+    }
+
+    size_t FindFirstUnset(size_t from = 0) const noexcept {
+        return this->FindFirst(from, ~Word{0});
+    }
+
+    // Both vectors must have the same size
+    Vector& operator&=(const Vector& other) noexcept {
+        simd::BitwiseApply(words_, other.words_, WordsFor(size_), simd::BitOp::kAnd);
+        return *this;
+    }
+
+    Vector& operator|=(const Vector& other) noexcept {
+        simd::BitwiseApply(words_, other.words_, WordsFor(size_), simd::BitOp::kOr);
+        return *this;
+    }
+
+    Vector& operator^=(const Vector& other) noexcept {
+        simd::BitwiseApply(words_, other.words_, WordsFor(size_), simd::BitOp::kXor);
+        return *this;
+    }
+
+    friend Vector operator&(Vector lhs, const Vector& rhs) {
+        return lhs &= rhs;
+    }
+
+    friend Vector operator|(Vector lhs, const Vector& rhs) {
+        return lhs |= rhs;
+    }
+
+    friend Vector operator^(Vector lhs, const Vector& rhs) {
+        return lhs ^= rhs;
+    }
+
+    friend bool operator==(const Vector& lhs, const Vector& rhs) noexcept {
+        return lhs.size_ == rhs.size_ &&
+               (lhs.size_ == 0 || std::memcmp(lhs.words_, rhs.words_, WordsFor(lhs.size_) * sizeof(Word)) == 0);
+    }
+
+    Iterator Begin() noexcept {
+        return Iterator(words_, 0);
+    }
+
+    Iterator End() noexcept {
+        return Iterator(words_, size_);
+    }
+
+    ConstIterator Begin() const noexcept {
+        return ConstIterator(words_, 0);
+    }
+
+    ConstIterator End() const noexcept {
+        return ConstIterator(words_, size_);
+    }
+
+    Iterator begin() noexcept {
+        return Begin();
+    }
+
+    Iterator end() noexcept {
+        return End();
+    }
+
+    ConstIterator begin() const noexcept {
+        return Begin();
+    }
+
+    ConstIterator end() const noexcept {
+        return End();
+    }
+
+    // The packed words, WordCount() of them are in use
+    Word* Data() noexcept {
+        return words_;
+    }
+
+    const Word* Data() const noexcept {
+        return words_;
+    }
+
+    size_t WordCount() const noexcept {
+        return WordsFor(size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return cap_;
+    }
+
+    bool IsEmpty() const noexcept {
+        return size_ == 0;
+    }
+
+    ~Vector() {
+        if (words_ != nullptr) {
+            WordAllocTraits::deallocate(alloc_, words_, cap_ / kWordBits);
+        }
+    }
+
+private:
+    using WordAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Word>;
+    using WordAllocTraits = std::allocator_traits<WordAlloc>;
+
+    static size_t WordsFor(size_t bits) noexcept {
+        return (bits + kWordBits - 1) / kWordBits;
+    }
+
+    void FillRange(size_t first, size_t last, Word fill) noexcept {
+        if (first >= last) {
+            return;
+        }
+        size_t first_word = first / kWordBits;
+        size_t last_word = (last - 1) / kWordBits;
+        Word head = ~Word{0} << (first % kWordBits);
+        Word tail = ~Word{0} >> (kWordBits - 1 - (last - 1) % kWordBits);
+        if (first_word == last_word) {
+            head &= tail;
+        }
+        words_[first_word] = (words_[first_word] & ~head) | (fill & head);
+        if (first_word == last_word) {
+            return;
+        }
+        if (last_word > first_word + 1) {
+            size_t bytes = (last_word - first_word - 1) * sizeof(Word);
+            std::memset(words_ + first_word + 1, static_cast<int>(fill & 0xff), bytes);
+        }
+        words_[last_word] = (words_[last_word] & ~tail) | (fill & tail);
+    }
+
+    // skip is the word that holds no match: 0 when looking for a set bit, all ones for an unset one
+    size_t FindFirst(size_t from, Word skip) const noexcept {
+        if (from >= size_) {
+            return size_;
+        }
+        size_t word = from / kWordBits;
+        size_t words = WordsFor(size_);
+        Word bits = (words_[word] ^ skip) & (~Word{0} << (from % kWordBits));
+        if (bits == 0) {
+            word += 1 + simd::FindWord(words_ + word + 1, words - word - 1, skip);
+            if (word == words) {
+                return size_;
+            }
+            bits = words_[word] ^ skip;
+        }
+        size_t pos = word * kWordBits + std::countr_zero(bits);
+        return pos < size_ ? pos : size_;  // the zero padding past Size() looks unset
+    }
+
+    Word* words_ = nullptr;
+    size_t size_ = 0;
+    size_t cap_ = 0;
+    WordAlloc alloc_;
+};
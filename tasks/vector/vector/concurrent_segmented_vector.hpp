@@ -0,0 +1,260 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <iterator>
+
+#include "vector.hpp"
+
+// Append-only vector for many producers.
+// Segment k holds kFirstSegment << k elements and is never moved, so references stay valid.
+// A producer claims an index with fetch_add, constructs the element and then sets
+// its bit in the segment's ready bitmap; readers only look at published elements.
+// Segments are allocated concurrently, so a stateful Alloc has to be thread-safe.
+template <typename T, typename Alloc = std::allocator<T>>
+class ConcurrentSegmentedVector {
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using Word = std::atomic<uint64_t>;
+    using WordAlloc = typename AllocTraits::template rebind_alloc<Word>;
+    using WordAllocTraits = std::allocator_traits<WordAlloc>;
+
+public:
+    static constexpr size_t kFirstSegment =
+        std::bit_ceil(std::max(DEFAULT_CAPACITY, kCacheLineSize / sizeof(T)));
+
+    class Iterator;
+
+    ConcurrentSegmentedVector() = default;
+
+    explicit ConcurrentSegmentedVector(const Alloc& alloc) : alloc_(alloc) {
+    }
+
+    ConcurrentSegmentedVector(const ConcurrentSegmentedVector&) = delete;
+    ConcurrentSegmentedVector& operator=(const ConcurrentSegmentedVector&) = delete;
+
+    // Lock-free; returns the index of the new element
+    size_t PushBack(const T& value) {
+        return this->EmplaceBack(value);
+    }
+
+    size_t PushBack(T&& value) {
+        return this->EmplaceBack(std::move(value));
+    }
+
+    // If the constructor throws, the claimed slot stays unpublished and is skipped by readers
+    template <class... Args>
+    size_t EmplaceBack(Args&&... args) {
+        size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+        auto [segment, offset] = Locate(index);
+        T* data = this->EnsureSegment(segment);
+        AllocTraits::construct(alloc_, data + offset, std::forward<Args>(args)...);
+        ready_[segment].load(std::memory_order_relaxed)[offset / 64].fetch_or(uint64_t{1} << (offset % 64),
+                                                                               std::memory_order_release);
+        return index;
+    }
+
+    // Allocates the segments for the first count elements up front
+    void Reserve(size_t count) {
+        if (count == 0) {
+            return;
+        }
+        size_t last = Locate(count - 1).segment;
+        for (size_t segment = 0; segment <= last; ++segment) {
+            this->EnsureSegment(segment);
+        }
+    }
+
+    // Wait-free; pos must be an index returned by PushBack or one for which IsReady() was true
+    T& operator[](size_t pos) {
+        auto [segment, offset] = Locate(pos);
+        return segments_[segment].load(std::memory_order_acquire)[offset];
+    }
+
+    const T& operator[](size_t pos) const {
+        auto [segment, offset] = Locate(pos);
+        return segments_[segment].load(std::memory_order_acquire)[offset];
+    }
+
+    bool IsReady(size_t pos) const noexcept {
+        if (pos >= Size()) {
+            return false;
+        }
+        auto [segment, offset] = Locate(pos);
+        const Word* ready = ready_[segment].load(std::memory_order_acquire);
+        return ready != nullptr &&
+               (ready[offset / 64].load(std::memory_order_acquire) >> (offset % 64) & 1) != 0;
+    }
+
+    // Claimed indices, including elements that are still being constructed
+    size_t Size() const noexcept {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    bool IsEmpty() const noexcept {
+        return Size() == 0;
+    }
+
+    // Visits the published elements in index order; safe to run next to producers.
+    // The range is fixed by the size seen in Begin(): End() is a sentinel that equals every
+    // iterator past that snapshot, so elements pushed between the two calls are not visited.
+    Iterator Begin() const {
+        return Iterator(this, 0, Size());
+    }
+
+    Iterator End() const {
+        return Iterator();
+    }
+
+    Iterator begin() const {
+        return Begin();
+    }
+
+    Iterator end() const {
+        return End();
+    }
+
+    // Not thread-safe
+    void Clear() {
+        this->DestroyAll(false);
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+    ~ConcurrentSegmentedVector() {
+        this->DestroyAll(true);
+    }
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator() = default;
+
+        reference operator*() const {
+            return (*vec_)[pos_];
+        }
+
+        pointer operator->() const {
+            return &(*vec_)[pos_];
+        }
+
+        Iterator& operator++() {
+            ++pos_;
+            this->SkipUnpublished();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return this->AtEnd() == other.AtEnd() && (this->AtEnd() || pos_ == other.pos_);
+        }
+
+    private:
+        friend class ConcurrentSegmentedVector;
+
+        Iterator(const ConcurrentSegmentedVector* vec, size_t pos, size_t end) : vec_(vec), pos_(pos), end_(end) {
+            this->SkipUnpublished();
+        }
+
+        bool AtEnd() const noexcept {
+            return pos_ >= end_;
+        }
+
+        void SkipUnpublished() {
+            while (pos_ < end_ && !vec_->IsReady(pos_)) {
+                ++pos_;
+            }
+        }
+
+        const ConcurrentSegmentedVector* vec_ = nullptr;
+        size_t pos_ = 0;
+        size_t end_ = 0;
+    };
+
+private:
+    static constexpr size_t kFirstShift = std::countr_zero(kFirstSegment);
+    static constexpr size_t kSegmentCount = 64 - kFirstShift;
+
+    struct Position {
+        size_t segment;
+        size_t offset;
+    };
+
+    static Position Locate(size_t index) noexcept {
+        size_t biased = index + kFirstSegment;
+        size_t segment = std::bit_width(biased) - 1 - kFirstShift;
+        return {segment, biased - (kFirstSegment << segment)};
+    }
+
+    static size_t SegmentSize(size_t segment) noexcept {
+        return kFirstSegment << segment;
+    }
+
+    static size_t WordCount(size_t segment) noexcept {
+        return (SegmentSize(segment) + 63) / 64;
+    }
+
+    // Both pointers are installed with CAS; a producer that loses the race frees its copy
+    T* EnsureSegment(size_t segment) {
+        if (ready_[segment].load(std::memory_order_acquire) == nullptr) {
+            WordAlloc word_alloc(alloc_);
+            Word* words = WordAllocTraits::allocate(word_alloc, WordCount(segment));
+            for (size_t i = 0; i < WordCount(segment); ++i) {
+                WordAllocTraits::construct(word_alloc, words + i, 0);
+            }
+            Word* expected = nullptr;
+            if (!ready_[segment].compare_exchange_strong(expected, words, std::memory_order_acq_rel)) {
+                WordAllocTraits::deallocate(word_alloc, words, WordCount(segment));
+            }
+        }
+        T* data = segments_[segment].load(std::memory_order_acquire);
+        if (data == nullptr) {
+            T* fresh = AllocTraits::allocate(alloc_, SegmentSize(segment));
+            if (segments_[segment].compare_exchange_strong(data, fresh, std::memory_order_acq_rel)) {
+                data = fresh;
+            } else {
+                AllocTraits::deallocate(alloc_, fresh, SegmentSize(segment));
+            }
+        }
+        return data;
+    }
+
+    void DestroyAll(bool release) {
+        size_t size = size_.load(std::memory_order_acquire);
+        for (size_t pos = 0; pos < size; ++pos) {
+            if (this->IsReady(pos)) {
+                AllocTraits::destroy(alloc_, &(*this)[pos]);
+            }
+        }
+        WordAlloc word_alloc(alloc_);
+        for (size_t segment = 0; segment < kSegmentCount; ++segment) {
+            Word* words = ready_[segment].load(std::memory_order_relaxed);
+            if (words != nullptr) {
+                for (size_t i = 0; i < WordCount(segment); ++i) {
+                    words[i].store(0, std::memory_order_relaxed);
+                }
+                if (release) {
+                    WordAllocTraits::deallocate(word_alloc, words, WordCount(segment));
+                }
+            }
+            T* data = segments_[segment].load(std::memory_order_relaxed);
+            if (release && data != nullptr) {
+                AllocTraits::deallocate(alloc_, data, SegmentSize(segment));
+            }
+        }
+    }
+
+    std::array<std::atomic<T*>, kSegmentCount> segments_{};
+    std::array<std::atomic<Word*>, kSegmentCount> ready_{};
+    std::atomic<size_t> size_ = 0;
+    Alloc alloc_;
+};
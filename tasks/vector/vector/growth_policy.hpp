@@ -0,0 +1,97 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+const size_t DEFAULT_CAPACITY = 10;
+
+// A growth policy tells Vector which capacity to ask for when it runs out of room.
+// NextCapacity(cap, required, elem_size) must return at least `required`.
+// An optional static OnReserve(ptr, bytes) is called for every new buffer.
+
+inline constexpr size_t kCacheLineSize = 64;
+inline constexpr size_t kPageSize = 4096;
+inline constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+inline constexpr size_t RoundUp(size_t value, size_t step) {
+    return (value + step - 1) / step * step;
+}
+
+// Old behaviour: start with DEFAULT_CAPACITY elements and double
+struct DoublingGrowth {
+    static size_t NextCapacity(size_t cap, size_t required, size_t /*elem_size*/) {
+        size_t grown = cap > 0 ? cap * 2 : DEFAULT_CAPACITY;
+        return grown > required ? grown : required;
+    }
+};
+
+// Grows by Num/Den, first buffer is one cache line
+template <size_t Num, size_t Den>
+struct GeometricGrowth {
+    static_assert(Num > Den, "growth factor must be greater than one");
+
+    static size_t NextCapacity(size_t cap, size_t required, size_t elem_size) {
+        size_t grown = cap > 0 ? cap + cap * (Num - Den) / Den : kCacheLineSize / elem_size;
+        return grown > required ? grown : required;
+    }
+};
+
+using OneAndHalfGrowth = GeometricGrowth<3, 2>;
+
+// Doubles and then fills the whole size class the allocator will hand out anyway
+// (four classes per power of two, as in mimalloc and jemalloc)
+struct BucketGrowth {
+    static size_t RoundUpToSizeClass(size_t bytes) {
+        if (bytes <= 16) {
+            return 16;
+        }
+        return RoundUp(bytes, std::bit_floor(bytes - 1) / 4);
+    }
+
+    static size_t NextCapacity(size_t cap, size_t required, size_t elem_size) {
+        size_t grown = cap > 0 ? cap * 2 : kCacheLineSize / elem_size;
+        if (grown < required) {
+            grown = required;
+        }
+        return RoundUpToSizeClass(grown * elem_size) / elem_size;
+    }
+};
+
+// Grows by 1.5x; buffers past Threshold bytes are rounded up to whole pages
+// so large vectors never waste more than half a growth step plus a page
+template <size_t Page, size_t Threshold>
+struct PageRoundedGrowth {
+    static size_t NextCapacity(size_t cap, size_t required, size_t elem_size) {
+        size_t bytes = OneAndHalfGrowth::NextCapacity(cap, required, elem_size) * elem_size;
+        if (bytes >= Threshold) {
+            bytes = RoundUp(bytes, Page);
+        }
+        return bytes / elem_size;
+    }
+};
+
+using PageAlignedGrowth = PageRoundedGrowth<kPageSize, 16 * kPageSize>;
+
+// Rounds large buffers to 2 MiB and asks the kernel to back them with huge pages
+struct HugePageGrowth : PageRoundedGrowth<kHugePageSize, kHugePageSize> {
+    static void OnReserve(void* ptr, size_t bytes) {
+#if defined(MADV_HUGEPAGE)
+        if (bytes < kHugePageSize) {
+            return;
+        }
+        uintptr_t begin = RoundUp(reinterpret_cast<uintptr_t>(ptr), kPageSize);
+        uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + bytes) / kPageSize * kPageSize;
+        if (end > begin) {
+            madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);  // best effort
+        }
+#else
+        (void)ptr;
+        (void)bytes;
+#endif
+    }
+};
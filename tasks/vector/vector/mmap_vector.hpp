@@ -0,0 +1,282 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "growth_policy.hpp"
+
+class MmapVectorException : public std::exception {
+public:
+    explicit MmapVectorException(const std::string& text) : error_message_(text) {
+    }
+
+    const char* what() const noexcept override {
+        return error_message_.data();
+    }
+
+private:
+    std::string error_message_;
+};
+
+enum class MmapMode { kReadOnly, kReadWrite };
+
+// Vector whose storage is a memory-mapped file:
+// | header (64 bytes) | element 0 | element 1 | ... | spare capacity |
+// The size lives in the mapped header, so it persists together with the data.
+// Opening an existing file read-only is zero-copy; Flush() makes changes durable.
+template <typename T>
+class MmapVector {
+    static_assert(std::is_trivially_copyable_v<T>, "MmapVector stores raw bytes, T must be trivially copyable");
+    static_assert(alignof(T) <= 64, "elements are placed right after a 64-byte header");
+
+public:
+    // In kReadWrite mode a missing file is created empty
+    explicit MmapVector(const std::string& path, MmapMode mode = MmapMode::kReadWrite) : mode_(mode) {
+        int flags = mode == MmapMode::kReadOnly ? O_RDONLY : O_RDWR | O_CREAT;
+        fd_ = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            Fail("open " + path);
+        }
+        try {
+            this->MapExisting(path);
+        } catch (...) {
+            this->Close();
+            throw;
+        }
+    }
+
+    MmapVector(const MmapVector&) = delete;
+    MmapVector& operator=(const MmapVector&) = delete;
+
+    MmapVector(MmapVector&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1)),
+          mode_(other.mode_),
+          map_(std::exchange(other.map_, nullptr)),
+          map_bytes_(std::exchange(other.map_bytes_, 0)),
+          cap_(std::exchange(other.cap_, 0)) {
+    }
+
+    MmapVector& operator=(MmapVector&& other) noexcept {
+        if (this != &other) {
+            this->Close();
+            fd_ = std::exchange(other.fd_, -1);
+            mode_ = other.mode_;
+            map_ = std::exchange(other.map_, nullptr);
+            map_bytes_ = std::exchange(other.map_bytes_, 0);
+            cap_ = std::exchange(other.cap_, 0);
+        }
+        return *this;
+    }
+
+    T* Begin() const noexcept {
+        return Data();
+    }
+
+    T* End() const noexcept {
+        return Data() + Size();
+    }
+
+    T& operator[](size_t pos) const {
+        return Data()[pos];
+    }
+
+    T& Front() const noexcept {
+        return Data()[0];
+    }
+
+    T& Back() const noexcept {
+        return Data()[Size() - 1];
+    }
+
+    T* Data() const noexcept {
+        if (map_ == nullptr) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(static_cast<char*>(map_) + kHeaderSize);
+    }
+
+    bool IsEmpty() const noexcept {
+        return Size() == 0;
+    }
+
+    bool IsReadOnly() const noexcept {
+        return mode_ == MmapMode::kReadOnly;
+    }
+
+    size_t Size() const noexcept {
+        return map_ == nullptr ? 0 : GetHeader()->size;
+    }
+
+    size_t Capacity() const noexcept {
+        return cap_;
+    }
+
+    // Extends the file and remaps it; pointers into the old mapping become invalid
+    void Reserve(size_t new_cap) {
+        this->CheckWritable();
+        if (new_cap <= cap_) {
+            return;
+        }
+        size_t new_bytes = kHeaderSize + new_cap * sizeof(T);
+        if (::ftruncate(fd_, static_cast<off_t>(new_bytes)) != 0) {
+            Fail("ftruncate");
+        }
+        this->Remap(new_bytes);
+        cap_ = new_cap;
+    }
+
+    void Resize(size_t count, const T& value = T()) {
+        this->CheckWritable();
+        T copy = value;  // value may point into the mapping that Reserve moves
+        this->Reserve(count);
+        for (size_t i = Size(); i < count; ++i) {
+            Data()[i] = copy;
+        }
+        GetHeader()->size = count;
+    }
+
+    void PushBack(const T& value) {
+        this->EmplaceBack(value);
+    }
+
+    template <class... Args>
+    void EmplaceBack(Args&&... args) {
+        this->CheckWritable();
+        T value(std::forward<Args>(args)...);  // args may point into the mapping that is about to move
+        size_t size = Size();
+        if (size == cap_) {
+            this->Reserve(DoublingGrowth::NextCapacity(cap_, size + 1, sizeof(T)));
+        }
+        Data()[size] = value;
+        GetHeader()->size = size + 1;
+    }
+
+    void PopBack() {
+        this->CheckWritable();
+        if (Size() != 0) {
+            --GetHeader()->size;
+        }
+    }
+
+    void Clear() {
+        this->CheckWritable();
+        GetHeader()->size = 0;
+    }
+
+    // msync: returns once data and size have reached the file
+    void Flush() {
+        this->CheckWritable();
+        if (::msync(map_, map_bytes_, MS_SYNC) != 0) {
+            Fail("msync");
+        }
+    }
+
+    ~MmapVector() {
+        this->Close();
+    }
+
+private:
+    static constexpr uint64_t kMagic = 0x524f54434556564dULL;  // "MVVECTOR"
+    static constexpr size_t kHeaderSize = 64;
+
+    struct Header {
+        uint64_t magic;
+        uint64_t elem_size;
+        uint64_t size;
+    };
+
+    [[noreturn]] static void Fail(const std::string& what) {
+        throw MmapVectorException("MmapVector: " + what + ": " + std::strerror(errno));
+    }
+
+    Header* GetHeader() const noexcept {
+        return static_cast<Header*>(map_);
+    }
+
+    // A moved-from vector reads as empty and rejects every change
+    void CheckWritable() const {
+        if (map_ == nullptr) {
+            throw MmapVectorException("MmapVector: moved from");
+        }
+        if (mode_ == MmapMode::kReadOnly) {
+            throw MmapVectorException("MmapVector: opened read-only");
+        }
+    }
+
+    void MapExisting(const std::string& path) {
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            Fail("fstat " + path);
+        }
+        size_t file_bytes = static_cast<size_t>(st.st_size);
+        bool fresh = file_bytes == 0 && mode_ == MmapMode::kReadWrite;
+        if (fresh) {
+            file_bytes = kHeaderSize;
+            if (::ftruncate(fd_, static_cast<off_t>(file_bytes)) != 0) {
+                Fail("ftruncate " + path);
+            }
+        }
+        if (file_bytes < kHeaderSize) {
+            throw MmapVectorException("MmapVector: " + path + " is too small to hold a header");
+        }
+        this->Remap(file_bytes);
+        cap_ = (file_bytes - kHeaderSize) / sizeof(T);
+        if (fresh) {
+            *GetHeader() = Header{kMagic, sizeof(T), 0};
+        }
+        if (GetHeader()->magic != kMagic || GetHeader()->elem_size != sizeof(T) || GetHeader()->size > cap_) {
+            throw MmapVectorException("MmapVector: " + path + " does not hold a vector of this type");
+        }
+    }
+
+    void Remap(size_t new_bytes) {
+        void* addr = MAP_FAILED;
+#if defined(__linux__)
+        if (map_ != nullptr) {
+            addr = ::mremap(map_, map_bytes_, new_bytes, MREMAP_MAYMOVE);
+            if (addr == MAP_FAILED) {
+                Fail("mremap");
+            }
+        }
+#endif
+        if (addr == MAP_FAILED) {
+            int prot = mode_ == MmapMode::kReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+            addr = ::mmap(nullptr, new_bytes, prot, MAP_SHARED, fd_, 0);
+            if (addr == MAP_FAILED) {
+                Fail("mmap");
+            }
+            if (map_ != nullptr) {
+                ::munmap(map_, map_bytes_);
+            }
+        }
+        map_ = addr;
+        map_bytes_ = new_bytes;
+    }
+
+    void Close() noexcept {
+        if (map_ != nullptr) {
+            ::munmap(map_, map_bytes_);
+            map_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ = -1;
+    MmapMode mode_;
+    void* map_ = nullptr;
+    size_t map_bytes_ = 0;
+    size_t cap_ = 0;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Fixed set of worker threads that run one ParallelFor at a time.
+// The calling thread takes part too, so a pool with N workers runs N + 1 tasks at once.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t workers) : threads_(std::make_unique<std::thread[]>(workers)), workers_(workers) {
+        for (size_t i = 0; i < workers_; ++i) {
+            threads_[i] = std::thread([this] { this->WorkerLoop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // One worker per hardware thread besides the caller
+    static ThreadPool& Default() {
+        static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+
+    size_t Workers() const noexcept {
+        return workers_;
+    }
+
+    // Calls fn(i) for every i in [0, tasks) and returns when all calls are done.
+    // The first exception thrown by fn is rethrown here after the other tasks finished.
+    // Must not be called from inside fn.
+    template <class F>
+    void ParallelFor(size_t tasks, F&& fn) {
+        if (tasks == 0) {
+            return;
+        }
+        std::lock_guard run(run_mutex_);
+        Job job(&fn, &Invoke<std::remove_reference_t<F>>, tasks);
+        {
+            std::lock_guard lock(mutex_);
+            job_ = &job;
+            ++generation_;
+        }
+        wake_.notify_all();
+        this->RunTasks(job);
+        std::unique_lock lock(mutex_);
+        finished_.wait(lock, [&] { return job.done.load() == tasks && active_ == 0; });
+        job_ = nullptr;
+        if (job.error) {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (size_t i = 0; i < workers_; ++i) {
+            threads_[i].join();
+        }
+    }
+
+private:
+    struct Job {
+        Job(void* fn, void (*invoke)(void*, size_t), size_t tasks) : fn(fn), invoke(invoke), tasks(tasks) {
+        }
+
+        void* fn;
+        void (*invoke)(void*, size_t);
+        size_t tasks;
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> done = 0;
+        std::exception_ptr error;
+        std::mutex error_mutex;
+    };
+
+    template <class F>
+    static void Invoke(void* fn, size_t task) {
+        (*static_cast<F*>(fn))(task);
+    }
+
+    void RunTasks(Job& job) {
+        for (size_t task = job.next.fetch_add(1); task < job.tasks; task = job.next.fetch_add(1)) {
+            try {
+                job.invoke(job.fn, task);
+            } catch (...) {
+                std::lock_guard lock(job.error_mutex);
+                if (!job.error) {
+                    job.error = std::current_exception();
+                }
+            }
+            if (job.done.fetch_add(1) + 1 == job.tasks) {
+                std::lock_guard lock(mutex_);
+                finished_.notify_all();
+            }
+        }
+    }
+
+    void WorkerLoop() {
+        size_t seen = 0;
+        while (true) {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || (job_ != nullptr && generation_ != seen); });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            Job* job = job_;
+            ++active_;  // keeps job alive until this worker is out of RunTasks
+            lock.unlock();
+            this->RunTasks(*job);
+            lock.lock();
+            if (--active_ == 0) {
+                finished_.notify_all();
+            }
+        }
+    }
+
+    std::unique_ptr<std::thread[]> threads_;
+    size_t workers_;
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable finished_;
+    Job* job_ = nullptr;
+    size_t generation_ = 0;
+    size_t active_ = 0;
+    bool stop_ = false;
+};
+
+// Selects the overloads of Vector that construct elements on a thread pool, e.g. Vector(kParallel, other).
+// Each thread builds a contiguous chunk, so the pages of a fresh buffer are first touched by the thread
+// (and NUMA node) that filled them.
+struct ParallelTag {
+    ThreadPool* pool = nullptr;  // ThreadPool::Default() when null
+    size_t min_chunk_bytes = 256 * 1024;  // smaller ranges stay on the calling thread
+
+    ThreadPool& GetPool() const {
+        return pool != nullptr ? *pool : ThreadPool::Default();
+    }
+};
+
+inline constexpr ParallelTag kParallel{};
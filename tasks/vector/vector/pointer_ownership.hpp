@@ -0,0 +1,79 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "../allocator/arena_allocator.hpp"
+
+// Ownership policies for Vector<void*, Ownership>. The second template argument says what
+// Clear() and the destructor do with the stored pointers: Release(ptrs, count) is called once
+// for the whole range. std::allocator<void*> keeps the old behaviour and means FreeOwnership.
+
+// Every pointer came from malloc and is freed one by one
+struct FreeOwnership {
+    void Release(void** ptrs, size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            std::free(ptrs[i]);
+        }
+    }
+};
+
+// The vector only stores the pointers
+struct NonOwning {
+    void Release(void** /*ptrs*/, size_t /*count*/) noexcept {
+    }
+};
+
+// Calls deleter(ptr) for every non-null pointer, e.g. to hand blobs back to a pool
+template <typename Deleter>
+class DeleterOwnership {
+public:
+    DeleterOwnership() = default;
+
+    explicit DeleterOwnership(Deleter deleter) : deleter_(std::move(deleter)) {
+    }
+
+    void Release(void** ptrs, size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            if (ptrs[i] != nullptr) {
+                deleter_(ptrs[i]);
+            }
+        }
+    }
+
+private:
+    Deleter deleter_;
+};
+
+// Pointers are carved from an arena owned by the vector; Release drops the whole arena at once
+class ArenaOwnership {
+public:
+    ArenaOwnership() = default;
+
+    explicit ArenaOwnership(size_t first_chunk) : arena_(first_chunk) {
+    }
+
+    void* Allocate(size_t bytes, size_t align) {
+        return arena_.Allocate(bytes, align);
+    }
+
+    void Release(void** /*ptrs*/, size_t /*count*/) noexcept {
+        arena_.Reset();
+    }
+
+    const Arena& GetArena() const noexcept {
+        return arena_;
+    }
+
+private:
+    Arena arena_;
+};
+
+template <typename Ownership>
+concept PointerOwnership = std::same_as<Ownership, std::allocator<void*>> ||
+                           requires(Ownership& owner, void** ptrs, size_t count) { owner.Release(ptrs, count); };
@@ -0,0 +1,823 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VECTOR_SIMD_X86 1
+#endif
+
+#include "vector.hpp"
+
+// Linear scans over arithmetic arrays: Find, Contains, Count, Min, Max, Sum.
+// int32_t, float and uint64_t get SSE2 and AVX2 kernels, chosen at runtime via CPUID,
+// every other arithmetic type goes to the scalar reference loops.
+// Min/Max of an empty range return the identity (max()/lowest()), inputs must not hold NaN.
+// PopCount, FindWord and BitwiseApply work on arrays of 64-bit words for bitmaps.
+namespace simd {
+
+enum class Level { kScalar, kSse2, kAvx2 };
+
+enum class BitOp { kAnd, kOr, kXor };
+
+// int32_t sums do not overflow, wider types wrap (or round) like the scalar loop
+template <typename T>
+using SumType = std::conditional_t<std::is_integral_v<T> && sizeof(T) < sizeof(int64_t),
+                                   std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>, T>;
+
+template <typename T>
+inline constexpr bool kHasKernels =
+    std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, uint64_t>;
+
+inline Level DetectLevel() {
+#if defined(VECTOR_SIMD_X86)
+    static const Level kLevel = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return Level::kAvx2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return Level::kSse2;
+        }
+        return Level::kScalar;
+    }();
+    return kLevel;
+#else
+    return Level::kScalar;
+#endif
+}
+
+namespace scalar {
+
+template <typename T>
+size_t Find(const T* data, size_t n, T value) {
+    for (size_t i = 0; i < n; ++i) {
+        if (data[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+template <typename T>
+size_t Count(const T* data, size_t n, T value) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += data[i] == value;
+    }
+    return count;
+}
+
+template <typename T>
+T Min(const T* data, size_t n) {
+    T result = std::numeric_limits<T>::max();
+    for (size_t i = 0; i < n; ++i) {
+        result = data[i] < result ? data[i] : result;
+    }
+    return result;
+}
+
+template <typename T>
+T Max(const T* data, size_t n) {
+    T result = std::numeric_limits<T>::lowest();
+    for (size_t i = 0; i < n; ++i) {
+        result = data[i] > result ? data[i] : result;
+    }
+    return result;
+}
+
+template <typename T>
+SumType<T> Sum(const T* data, size_t n) {
+    SumType<T> sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+inline size_t PopCount(const uint64_t* words, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += std::popcount(words[i]);
+    }
+    return count;
+}
+
+// Index of the first word that differs from skip, or n
+inline size_t FindWord(const uint64_t* words, size_t n, uint64_t skip) {
+    for (size_t i = 0; i < n; ++i) {
+        if (words[i] != skip) {
+            return i;
+        }
+    }
+    return n;
+}
+
+inline void BitwiseApply(uint64_t* dst, const uint64_t* src, size_t n, BitOp op) {
+    switch (op) {
+        case BitOp::kAnd:
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] &= src[i];
+            }
+            break;
+        case BitOp::kOr:
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] |= src[i];
+            }
+            break;
+        case BitOp::kXor:
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] ^= src[i];
+            }
+            break;
+    }
+}
+
+}  // namespace scalar
+
+#if defined(VECTOR_SIMD_X86)
+
+// Ops<T> wraps the intrinsics for one register type:
+// Load/Set1/Store, EqMask (one bit per lane), Min/Max and a widening Accumulate for Sum.
+// Reductions keep kUnroll independent accumulators to hide the instruction latency.
+
+inline constexpr size_t kUnroll = 4;
+
+namespace sse2 {
+
+template <typename T>
+struct Ops;
+
+template <>
+struct Ops<int32_t> {
+    using Reg = __m128i;
+    using Acc = __m128i;  // two int64 lanes
+    static constexpr size_t kLanes = 4;
+    static constexpr bool kHasMinMax = true;
+
+    static Reg Load(const int32_t* ptr) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    }
+    static Reg Set1(int32_t value) {
+        return _mm_set1_epi32(value);
+    }
+    static void Store(int32_t* ptr, Reg reg) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), reg);
+    }
+    static unsigned EqMask(Reg a, Reg b) {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+    }
+    static Reg Min(Reg a, Reg b) {  // no pminsd before SSE4.1
+        Reg greater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+    }
+    static Reg Max(Reg a, Reg b) {
+        Reg greater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+    }
+    static Acc Zero() {
+        return _mm_setzero_si128();
+    }
+    static Acc Accumulate(Acc acc, Reg reg) {
+        Reg sign = _mm_srai_epi32(reg, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(reg, sign));
+        return _mm_add_epi64(acc, _mm_unpackhi_epi32(reg, sign));
+    }
+    static int64_t ReduceSum(Acc acc) {
+        int64_t lanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        return lanes[0] + lanes[1];
+    }
+};
+
+template <>
+struct Ops<float> {
+    using Reg = __m128;
+    using Acc = __m128;
+    static constexpr size_t kLanes = 4;
+    static constexpr bool kHasMinMax = true;
+
+    static Reg Load(const float* ptr) {
+        return _mm_loadu_ps(ptr);
+    }
+    static Reg Set1(float value) {
+        return _mm_set1_ps(value);
+    }
+    static void Store(float* ptr, Reg reg) {
+        _mm_storeu_ps(ptr, reg);
+    }
+    static unsigned EqMask(Reg a, Reg b) {
+        return _mm_movemask_ps(_mm_cmpeq_ps(a, b));
+    }
+    static Reg Min(Reg a, Reg b) {
+        return _mm_min_ps(a, b);
+    }
+    static Reg Max(Reg a, Reg b) {
+        return _mm_max_ps(a, b);
+    }
+    static Acc Zero() {
+        return _mm_setzero_ps();
+    }
+    static Acc Accumulate(Acc acc, Reg reg) {
+        return _mm_add_ps(acc, reg);
+    }
+    static float ReduceSum(Acc acc) {
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+};
+
+template <>
+struct Ops<uint64_t> {
+    using Reg = __m128i;
+    using Acc = __m128i;
+    static constexpr size_t kLanes = 2;
+    static constexpr bool kHasMinMax = false;  // unsigned 64-bit compares need AVX-512
+
+    static Reg Load(const uint64_t* ptr) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    }
+    static Reg Set1(uint64_t value) {
+        return _mm_set1_epi64x(static_cast<int64_t>(value));
+    }
+    static unsigned EqMask(Reg a, Reg b) {  // no pcmpeqq before SSE4.1: both halves must match
+        Reg eq32 = _mm_cmpeq_epi32(a, b);
+        Reg eq64 = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_movemask_pd(_mm_castsi128_pd(eq64));
+    }
+    static Acc Zero() {
+        return _mm_setzero_si128();
+    }
+    static Acc Accumulate(Acc acc, Reg reg) {
+        return _mm_add_epi64(acc, reg);
+    }
+    static uint64_t ReduceSum(Acc acc) {
+        uint64_t lanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        return lanes[0] + lanes[1];
+    }
+};
+
+template <typename T>
+size_t Find(const T* data, size_t n, T value) {
+    using O = Ops<T>;
+    auto needle = O::Set1(value);
+    size_t i = 0;
+    for (; i + O::kLanes <= n; i += O::kLanes) {
+        unsigned mask = O::EqMask(O::Load(data + i), needle);
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + scalar::Find(data + i, n - i, value);
+}
+
+template <typename T>
+size_t Count(const T* data, size_t n, T value) {
+    using O = Ops<T>;
+    // popcnt is not part of SSE2, and a 4-bit mask fits a table anyway
+    constexpr uint8_t kBits[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+    auto needle = O::Set1(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + O::kLanes <= n; i += O::kLanes) {
+        count += kBits[O::EqMask(O::Load(data + i), needle)];
+    }
+    return count + scalar::Count(data + i, n - i, value);
+}
+
+template <typename T>
+T Min(const T* data, size_t n) {
+    using O = Ops<T>;
+    constexpr size_t kStep = kUnroll * O::kLanes;
+    if (n < kStep) {
+        return scalar::Min(data, n);
+    }
+    typename O::Reg acc[kUnroll];
+    for (size_t k = 0; k < kUnroll; ++k) {
+        acc[k] = O::Load(data + k * O::kLanes);
+    }
+    size_t i = kStep;
+    for (; i + kStep <= n; i += kStep) {
+        for (size_t k = 0; k < kUnroll; ++k) {
+            acc[k] = O::Min(acc[k], O::Load(data + i + k * O::kLanes));
+        }
+    }
+    T lanes[O::kLanes];
+    O::Store(lanes, O::Min(O::Min(acc[0], acc[1]), O::Min(acc[2], acc[3])));
+    return std::min(scalar::Min(lanes, O::kLanes), scalar::Min(data + i, n - i));
+}
+
+template <typename T>
+T Max(const T* data, size_t n) {
+    using O = Ops<T>;
+    constexpr size_t kStep = kUnroll * O::kLanes;
+    if (n < kStep) {
+        return scalar::Max(data, n);
+    }
+    typename O::Reg acc[kUnroll];
+    for (size_t k = 0; k < kUnroll; ++k) {
+        acc[k] = O::Load(data + k * O::kLanes);
+    }
+    size_t i = kStep;
+    for (; i + kStep <= n; i += kStep) {
+        for (size_t k = 0; k < kUnroll; ++k) {
+            acc[k] = O::Max(acc[k], O::Load(data + i + k * O::kLanes));
+        }
+    }
+    T lanes[O::kLanes];
+    O::Store(lanes, O::Max(O::Max(acc[0], acc[1]), O::Max(acc[2], acc[3])));
+    return std::max(scalar::Max(lanes, O::kLanes), scalar::Max(data + i, n - i));
+}
+
+template <typename T>
+SumType<T> Sum(const T* data, size_t n) {
+    using O = Ops<T>;
+    constexpr size_t kStep = kUnroll * O::kLanes;
+    typename O::Acc acc[kUnroll];
+    for (size_t k = 0; k < kUnroll; ++k) {
+        acc[k] = O::Zero();
+    }
+    size_t i = 0;
+    for (; i + kStep <= n; i += kStep) {
+        for (size_t k = 0; k < kUnroll; ++k) {
+            acc[k] = O::Accumulate(acc[k], O::Load(data + i + k * O::kLanes));
+        }
+    }
+    SumType<T> sum = 0;
+    for (size_t k = 0; k < kUnroll; ++k) {
+        sum += O::ReduceSum(acc[k]);
+    }
+    return sum + scalar::Sum(data + i, n - i);
+}
+
+}  // namespace sse2
+
+// Everything below is compiled for AVX2 only and must be reached through DetectLevel()
+namespace avx2 {
+
+#define VECTOR_SIMD_AVX2 [[gnu::target("avx2,popcnt")]]
+
+template <typename T>
+struct Ops;
+
+template <>
+struct Ops<int32_t> {
+    using Reg = __m256i;
+    using Acc = __m256i;  // four int64 lanes
+    static constexpr size_t kLanes = 8;
+
+    VECTOR_SIMD_AVX2 static Reg Load(const int32_t* ptr) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+    }
+    VECTOR_SIMD_AVX2 static Reg Set1(int32_t value) {
+        return _mm256_set1_epi32(value);
+    }
+    VECTOR_SIMD_AVX2 static void Store(int32_t* ptr, Reg reg) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), reg);
+    }
+    VECTOR_SIMD_AVX2 static unsigned EqMask(Reg a, Reg b) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+    }
+    VECTOR_SIMD_AVX2 static Reg Min(Reg a, Reg b) {
+        return _mm256_min_epi32(a, b);
+    }
+    VECTOR_SIMD_AVX2 static Reg Max(Reg a, Reg b) {
+        return _mm256_max_epi32(a, b);
+    }
+    VECTOR_SIMD_AVX2 static Acc Zero() {
+        return _mm256_setzero_si256();
+    }
+    VECTOR_SIMD_AVX2 static Acc Accumulate(Acc acc, Reg reg) {
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(reg)));
+        return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(reg, 1)));
+    }
+    VECTOR_SIMD_AVX2 static int64_t ReduceSum(Acc acc) {
+        int64_t lanes[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+};
+
+template <>
+struct Ops<float> {
+    using Reg = __m256;
+    using Acc = __m256;
+    static constexpr size_t kLanes = 8;
+
+    VECTOR_SIMD_AVX2 static Reg Load(const float* ptr) {
+        return _mm256_loadu_ps(ptr);
+    }
+    VECTOR_SIMD_AVX2 static Reg Set1(float value) {
+        return _mm256_set1_ps(value);
+    }
+    VECTOR_SIMD_AVX2 static void Store(float* ptr, Reg reg) {
+        _mm256_storeu_ps(ptr, reg);
+    }
+    VECTOR_SIMD_AVX2 static unsigned EqMask(Reg a, Reg b) {
+        return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ));
+    }
+    VECTOR_SIMD_AVX2 static Reg Min(Reg a, Reg b) {
+        return _mm256_min_ps(a, b);
+    }
+    VECTOR_SIMD_AVX2 static Reg Max(Reg a, Reg b) {
+        return _mm256_max_ps(a, b);
+    }
+    VECTOR_SIMD_AVX2 static Acc Zero() {
+        return _mm256_setzero_ps();
+    }
+    VECTOR_SIMD_AVX2 static Acc Accumulate(Acc acc, Reg reg) {
+        return _mm256_add_ps(acc, reg);
+    }
+    VECTOR_SIMD_AVX2 static float ReduceSum(Acc acc) {
+        float lanes[8];
+        _mm256_storeu_ps(lanes, acc);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+};
+
+template <>
+struct Ops<uint64_t> {
+    using Reg = __m256i;
+    using Acc = __m256i;
+    static constexpr size_t kLanes = 4;
+
+    VECTOR_SIMD_AVX2 static Reg Load(const uint64_t* ptr) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+    }
+    VECTOR_SIMD_AVX2 static Reg Set1(uint64_t value) {
+        return _mm256_set1_epi64x(static_cast<int64_t>(value));
+    }
+    VECTOR_SIMD_AVX2 static void Store(uint64_t* ptr, Reg reg) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), reg);
+    }
+    VECTOR_SIMD_AVX2 static unsigned EqMask(Reg a, Reg b) {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)));
+    }
+    // only signed 64-bit compares exist: flip the sign bits first
+    VECTOR_SIMD_AVX2 static Reg Greater(Reg a, Reg b) {
+        Reg bias = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+        return _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+    }
+    VECTOR_SIMD_AVX2 static Reg Min(Reg a, Reg b) {
+        return _mm256_blendv_epi8(a, b, Greater(a, b));
+    }
+    VECTOR_SIMD_AVX2 static Reg Max(Reg a, Reg b) {
+        return _mm256_blendv_epi8(b, a, Greater(a, b));
+    }
+    VECTOR_SIMD_AVX2 static Acc Zero() {
+        return _mm256_setzero_si256();
+    }
+    VECTOR_SIMD_AVX2 static Acc Accumulate(Acc acc, Reg reg) {
+        return _mm256_add_epi64(acc, reg);
+    }
+    VECTOR_SIMD_AVX2 static uint64_t ReduceSum(Acc acc) {
+        uint64_t lanes[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+};
+
+// Same loops as in sse2, they have to be repeated to be compiled with the AVX2 target
+
+template <typename T>
+VECTOR_SIMD_AVX2 size_t Find(const T* data, size_t n, T value) {
+    using O = Ops<T>;
+    auto needle = O::Set1(value);
+    size_t i = 0;
+    for (; i + O::kLanes <= n; i += O::kLanes) {
+        unsigned mask = O::EqMask(O::Load(data + i), needle);
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + scalar::Find(data + i, n - i, value);
+}
+
+template <typename T>
+VECTOR_SIMD_AVX2 size_t Count(const T* data, size_t n, T value) {
+    using O = Ops<T>;
+    auto needle = O::Set1(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + O::kLanes <= n; i += O::kLanes) {
+        count += std::popcount(O::EqMask(O::Load(data + i), needle));
+    }
+    return count + scalar::Count(data + i, n - i, value);
+}
+
+template <typename T>
+VECTOR_SIMD_AVX2 T Min(const T* data, size_t n) {
+    using O = Ops<T>;
+    constexpr size_t kStep = kUnroll * O::kLanes;
+    if (n < kStep) {
+        return scalar::Min(data, n);
+    }
+    typename O::Reg acc[kUnroll];
+    for (size_t k = 0; k < kUnroll; ++k) {
+        acc[k] = O::Load(data + k * O::kLanes);
+    }
+    size_t i = kStep;
+    for (; i + kStep <= n; i += kStep) {
+        for (size_t k = 0; k < kUnroll; ++k) {
+            acc[k] = O::Min(acc[k], O::Load(data + i + k * O::kLanes));
+        }
+    }
+    T lanes[O::kLanes];
+    O::Store(lanes, O::Min(O::Min(acc[0], acc[1]), O::Min(acc[2], acc[3])));
+    return std::min(scalar::Min(lanes, O::kLanes), scalar::Min(data + i, n - i));
+}
+
+template <typename T>
+VECTOR_SIMD_AVX2 T Max(const T* data, size_t n) {
+    using O = Ops<T>;
+    constexpr size_t kStep = kUnroll * O::kLanes;
+    if (n < kStep) {
+        return scalar::Max(data, n);
+    }
+    typename O::Reg acc[kUnroll];
+    for (size_t k = 0; k < kUnroll; ++k) {
+        acc[k] = O::Load(data + k * O::kLanes);
+    }
+    size_t i = kStep;
+    for (; i + kStep <= n; i += kStep) {
+        for (size_t k = 0; k < kUnroll; ++k) {
+            acc[k] = O::Max(acc[k], O::Load(data + i + k * O::kLanes));
+        }
+    }
+    T lanes[O::kLanes];
+    O::Store(lanes, O::Max(O::Max(acc[0], acc[1]), O::Max(acc[2], acc[3])));
+    return std::max(scalar::Max(lanes, O::kLanes), scalar::Max(data + i, n - i));
+}
+
+template <typename T>
+VECTOR_SIMD_AVX2 SumType<T> Sum(const T* data, size_t n) {
+    using O = Ops<T>;
+    constexpr size_t kStep = kUnroll * O::kLanes;
+    typename O::Acc acc[kUnroll];
+    for (size_t k = 0; k < kUnroll; ++k) {
+        acc[k] = O::Zero();
+    }
+    size_t i = 0;
+    for (; i + kStep <= n; i += kStep) {
+        for (size_t k = 0; k < kUnroll; ++k) {
+            acc[k] = O::Accumulate(acc[k], O::Load(data + i + k * O::kLanes));
+        }
+    }
+    SumType<T> sum = 0;
+    for (size_t k = 0; k < kUnroll; ++k) {
+        sum += O::ReduceSum(acc[k]);
+    }
+    return sum + scalar::Sum(data + i, n - i);
+}
+
+// Nibble lookup with pshufb, byte counts summed by psadbw (Mula et al.)
+VECTOR_SIMD_AVX2 inline __m256i PopCountBytes(__m256i reg) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,  //
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(reg, low_mask));
+    __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(reg, 4), low_mask));
+    return _mm256_add_epi8(low, high);
+}
+
+VECTOR_SIMD_AVX2 inline size_t PopCount(const uint64_t* words, size_t n) {
+    constexpr size_t kLanes = 4;
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + kUnroll * kLanes <= n; i += kUnroll * kLanes) {
+        // byte counts of four registers add up to at most 32, no overflow before psadbw
+        __m256i bytes = PopCountBytes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i)));
+        for (size_t k = 1; k < kUnroll; ++k) {
+            bytes = _mm256_add_epi8(
+                bytes, PopCountBytes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i + k * kLanes))));
+        }
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    size_t count = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i) {
+        count += std::popcount(words[i]);
+    }
+    return count;
+}
+
+VECTOR_SIMD_AVX2 inline size_t FindWord(const uint64_t* words, size_t n, uint64_t skip) {
+    using O = Ops<uint64_t>;
+    auto needle = O::Set1(skip);
+    size_t i = 0;
+    for (; i + O::kLanes <= n; i += O::kLanes) {
+        unsigned mask = O::EqMask(O::Load(words + i), needle) ^ 0xfu;
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + scalar::FindWord(words + i, n - i, skip);
+}
+
+// Returns how many words were done, the tail is left to the scalar loop
+template <BitOp kOp>
+VECTOR_SIMD_AVX2 size_t BitwiseLoop(uint64_t* dst, const uint64_t* src, size_t n) {
+    using O = Ops<uint64_t>;
+    size_t i = 0;
+    for (; i + O::kLanes <= n; i += O::kLanes) {
+        __m256i a = O::Load(dst + i);
+        __m256i b = O::Load(src + i);
+        if constexpr (kOp == BitOp::kAnd) {
+            a = _mm256_and_si256(a, b);
+        } else if constexpr (kOp == BitOp::kOr) {
+            a = _mm256_or_si256(a, b);
+        } else {
+            a = _mm256_xor_si256(a, b);
+        }
+        O::Store(dst + i, a);
+    }
+    return i;
+}
+
+VECTOR_SIMD_AVX2 inline void BitwiseApply(uint64_t* dst, const uint64_t* src, size_t n, BitOp op) {
+    size_t done = 0;
+    switch (op) {
+        case BitOp::kAnd:
+            done = BitwiseLoop<BitOp::kAnd>(dst, src, n);
+            break;
+        case BitOp::kOr:
+            done = BitwiseLoop<BitOp::kOr>(dst, src, n);
+            break;
+        case BitOp::kXor:
+            done = BitwiseLoop<BitOp::kXor>(dst, src, n);
+            break;
+    }
+    scalar::BitwiseApply(dst + done, src + done, n - done, op);
+}
+
+#undef VECTOR_SIMD_AVX2
+
+}  // namespace avx2
+
+#endif  // VECTOR_SIMD_X86
+
+// Dispatch. A level above DetectLevel() is clamped, so it is always safe to pass one.
+
+template <typename T>
+size_t Find(const T* data, size_t n, std::type_identity_t<T> value, Level level = DetectLevel()) {
+    level = std::min(level, DetectLevel());
+#if defined(VECTOR_SIMD_X86)
+    if constexpr (kHasKernels<T>) {
+        if (level == Level::kAvx2) {
+            return avx2::Find(data, n, value);
+        }
+        if (level == Level::kSse2) {
+            return sse2::Find(data, n, value);
+        }
+    }
+#endif
+    return scalar::Find(data, n, value);
+}
+
+template <typename T>
+bool Contains(const T* data, size_t n, std::type_identity_t<T> value, Level level = DetectLevel()) {
+    return Find(data, n, value, level) != n;
+}
+
+template <typename T>
+size_t Count(const T* data, size_t n, std::type_identity_t<T> value, Level level = DetectLevel()) {
+    level = std::min(level, DetectLevel());
+#if defined(VECTOR_SIMD_X86)
+    if constexpr (kHasKernels<T>) {
+        if (level == Level::kAvx2) {
+            return avx2::Count(data, n, value);
+        }
+        if (level == Level::kSse2) {
+            return sse2::Count(data, n, value);
+        }
+    }
+#endif
+    return scalar::Count(data, n, value);
+}
+
+template <typename T>
+T Min(const T* data, size_t n, Level level = DetectLevel()) {
+    level = std::min(level, DetectLevel());
+#if defined(VECTOR_SIMD_X86)
+    if constexpr (kHasKernels<T>) {
+        if (level == Level::kAvx2) {
+            return avx2::Min(data, n);
+        }
+        if constexpr (sse2::Ops<T>::kHasMinMax) {
+            if (level == Level::kSse2) {
+                return sse2::Min(data, n);
+            }
+        }
+    }
+#endif
+    return scalar::Min(data, n);
+}
+
+template <typename T>
+T Max(const T* data, size_t n, Level level = DetectLevel()) {
+    level = std::min(level, DetectLevel());
+#if defined(VECTOR_SIMD_X86)
+    if constexpr (kHasKernels<T>) {
+        if (level == Level::kAvx2) {
+            return avx2::Max(data, n);
+        }
+        if constexpr (sse2::Ops<T>::kHasMinMax) {
+            if (level == Level::kSse2) {
+                return sse2::Max(data, n);
+            }
+        }
+    }
+#endif
+    return scalar::Max(data, n);
+}
+
+template <typename T>
+SumType<T> Sum(const T* data, size_t n, Level level = DetectLevel()) {
+    level = std::min(level, DetectLevel());
+#if defined(VECTOR_SIMD_X86)
+    if constexpr (kHasKernels<T>) {
+        if (level == Level::kAvx2) {
+            return avx2::Sum(data, n);
+        }
+        if (level == Level::kSse2) {
+            return sse2::Sum(data, n);
+        }
+    }
+#endif
+    return scalar::Sum(data, n);
+}
+
+// Bitmap kernels: SSE2 has no pshufb or popcnt, so only AVX2 machines leave the scalar loops
+
+inline size_t PopCount(const uint64_t* words, size_t n, Level level = DetectLevel()) {
+#if defined(VECTOR_SIMD_X86)
+    if (std::min(level, DetectLevel()) == Level::kAvx2) {
+        return avx2::PopCount(words, n);
+    }
+#endif
+    (void)level;
+    return scalar::PopCount(words, n);
+}
+
+inline size_t FindWord(const uint64_t* words, size_t n, uint64_t skip, Level level = DetectLevel()) {
+#if defined(VECTOR_SIMD_X86)
+    if (std::min(level, DetectLevel()) == Level::kAvx2) {
+        return avx2::FindWord(words, n, skip);
+    }
+#endif
+    (void)level;
+    return scalar::FindWord(words, n, skip);
+}
+
+inline void BitwiseApply(uint64_t* dst, const uint64_t* src, size_t n, BitOp op, Level level = DetectLevel()) {
+#if defined(VECTOR_SIMD_X86)
+    if (std::min(level, DetectLevel()) == Level::kAvx2) {
+        avx2::BitwiseApply(dst, src, n, op);
+        return;
+    }
+#endif
+    (void)level;
+    scalar::BitwiseApply(dst, src, n, op);
+}
+
+// Vector overloads
+
+template <typename T, typename Alloc, typename Growth>
+size_t Find(const Vector<T, Alloc, Growth>& vec, std::type_identity_t<T> value) {
+    return Find(vec.Data(), vec.Size(), value);
+}
+
+template <typename T, typename Alloc, typename Growth>
+bool Contains(const Vector<T, Alloc, Growth>& vec, std::type_identity_t<T> value) {
+    return Contains(vec.Data(), vec.Size(), value);
+}
+
+template <typename T, typename Alloc, typename Growth>
+size_t Count(const Vector<T, Alloc, Growth>& vec, std::type_identity_t<T> value) {
+    return Count(vec.Data(), vec.Size(), value);
+}
+
+template <typename T, typename Alloc, typename Growth>
+T Min(const Vector<T, Alloc, Growth>& vec) {
+    return Min(vec.Data(), vec.Size());
+}
+
+template <typename T, typename Alloc, typename Growth>
+T Max(const Vector<T, Alloc, Growth>& vec) {
+    return Max(vec.Data(), vec.Size());
+}
+
+template <typename T, typename Alloc, typename Growth>
+SumType<T> Sum(const Vector<T, Alloc, Growth>& vec) {
+    return Sum(vec.Data(), vec.Size());
+}
+
+}  // namespace simd
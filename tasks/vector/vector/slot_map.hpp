@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "vector.hpp"
+
+// Stable handle into a SlotMap. A handle whose element was erased never becomes valid again
+// (until the 32-bit generation of its slot wraps around).
+struct SlotHandle {
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+
+    bool operator==(const SlotHandle&) const = default;
+};
+
+// Values are kept dense and contiguous; erase moves the last value into the hole.
+// Handles go through a sparse slot table: slot -> dense position + generation.
+// Free slots form an intrusive list through their index field.
+template <typename T, typename Alloc = std::allocator<T>>
+class SlotMap {
+public:
+    SlotMap() = default;
+
+    // If the value's constructor throws, the slot simply stays on the freelist
+    template <class... Args>
+    SlotHandle Emplace(Args&&... args) {
+        if (free_head_ == kNone) {
+            slots_.PushBack(Slot{});
+            free_head_ = static_cast<uint32_t>(slots_.Size() - 1);
+        }
+        uint32_t slot = free_head_;
+        dense_to_slot_.PushBack(slot);
+        try {
+            values_.EmplaceBack(std::forward<Args>(args)...);
+        } catch (...) {
+            dense_to_slot_.PopBack();
+            throw;
+        }
+        free_head_ = slots_[slot].index;
+        slots_[slot].index = static_cast<uint32_t>(values_.Size() - 1);
+        return {slot, slots_[slot].generation};
+    }
+
+    SlotHandle Insert(const T& value) {
+        return this->Emplace(value);
+    }
+
+    SlotHandle Insert(T&& value) {
+        return this->Emplace(std::move(value));
+    }
+
+    // O(1): the last value takes the place of the erased one. False for a stale handle.
+    bool Erase(SlotHandle handle) {
+        if (!this->Contains(handle)) {
+            return false;
+        }
+        Slot& slot = slots_[handle.index];
+        size_t pos = slot.index;
+        size_t last = values_.Size() - 1;
+        if (pos != last) {
+            values_[pos] = std::move(values_[last]);
+            dense_to_slot_[pos] = dense_to_slot_[last];
+            slots_[dense_to_slot_[pos]].index = static_cast<uint32_t>(pos);
+        }
+        values_.PopBack();
+        dense_to_slot_.PopBack();
+        ++slot.generation;
+        slot.index = free_head_;
+        free_head_ = handle.index;
+        return true;
+    }
+
+    bool Contains(SlotHandle handle) const noexcept {
+        return handle.index < slots_.Size() && slots_.Data()[handle.index].generation == handle.generation;
+    }
+
+    // nullptr for a stale handle
+    T* Find(SlotHandle handle) noexcept {
+        return this->Contains(handle) ? values_.Data() + slots_[handle.index].index : nullptr;
+    }
+
+    const T* Find(SlotHandle handle) const noexcept {
+        return this->Contains(handle) ? values_.Data() + slots_.Data()[handle.index].index : nullptr;
+    }
+
+    // handle must be valid
+    T& operator[](SlotHandle handle) noexcept {
+        return values_[slots_[handle.index].index];
+    }
+
+    // Handle of the value at dense position pos, e.g. while iterating
+    SlotHandle HandleAt(size_t pos) const noexcept {
+        uint32_t slot = dense_to_slot_.Data()[pos];
+        return {slot, slots_.Data()[slot].generation};
+    }
+
+    void Reserve(size_t count) {
+        values_.Reserve(count);
+        dense_to_slot_.Reserve(count);
+        slots_.Reserve(count);
+    }
+
+    // Invalidates every handle but keeps the slot table, so old handles stay stale
+    void Clear() {
+        for (size_t pos = 0; pos < dense_to_slot_.Size(); ++pos) {
+            uint32_t slot = dense_to_slot_[pos];
+            ++slots_[slot].generation;
+            slots_[slot].index = free_head_;
+            free_head_ = slot;
+        }
+        values_.Clear();
+        dense_to_slot_.Clear();
+    }
+
+    // Live values in dense order; erase reorders them
+    T* Begin() const noexcept {
+        return values_.Data();
+    }
+
+    T* End() const noexcept {
+        return values_.Data() + values_.Size();
+    }
+
+    T* begin() const noexcept {
+        return Begin();
+    }
+
+    T* end() const noexcept {
+        return End();
+    }
+
+    T* Data() const noexcept {
+        return values_.Data();
+    }
+
+    size_t Size() const noexcept {
+        return values_.Size();
+    }
+
+    bool IsEmpty() const noexcept {
+        return values_.IsEmpty();
+    }
+
+private:
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        uint32_t index = kNone;  // dense position, or the next free slot
+        uint32_t generation = 0;
+    };
+
+    template <typename U>
+    using Rebind = typename std::allocator_traits<Alloc>::template rebind_alloc<U>;
+
+    Vector<T, Alloc> values_;
+    Vector<uint32_t, Rebind<uint32_t>> dense_to_slot_;
+    Vector<Slot, Rebind<Slot>> slots_;
+    uint32_t free_head_ = kNone;
+};
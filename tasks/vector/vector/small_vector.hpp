@@ -0,0 +1,307 @@
+#pragma once
+
+#include "vector.hpp"
+
+// Vector with room for N elements inside the object itself.
+// The allocator is touched only when the size grows past N.
+template <typename T, size_t N, typename Alloc = std::allocator<T>>
+class SmallVector {
+    static_assert(N > 0, "use Vector when no inline storage is needed");
+
+public:
+    SmallVector(){};
+
+    explicit SmallVector(const Alloc& alloc) : alloc_(alloc) {
+    }
+
+    // Delegate to SmallVector() so that the destructor cleans up if an element constructor throws
+    explicit SmallVector(size_t count) : SmallVector() {
+        this->Resize(count);
+    }
+
+    SmallVector(size_t count, const T& value) : SmallVector() {
+        this->Resize(count, value);
+    }
+
+    SmallVector(std::initializer_list<T> init) : SmallVector() {
+        this->Reserve(init.size());
+        for (auto&& elem : init) {
+            this->PushBack(elem);
+        }
+    }
+
+    SmallVector(const SmallVector& other)
+        : SmallVector(AllocTraits::select_on_container_copy_construction(other.alloc_)) {
+        this->CopyFrom(other);
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : alloc_(std::move(other.alloc_)) {
+        this->StealFrom(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this == &other) {
+            return *this;
+        }
+        this->Clear();
+        if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+            if (alloc_ != other.alloc_) {
+                this->ReleaseHeap();
+            }
+            alloc_ = other.alloc_;
+        }
+        this->CopyFrom(other);
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) {
+        if (this == &other) {
+            return *this;
+        }
+        this->Clear();
+        this->ReleaseHeap();
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            alloc_ = std::move(other.alloc_);
+        }
+        this->StealFrom(other);
+        return *this;
+    }
+
+    void Swap(SmallVector& other) {
+        if (this == &other) {
+            return;
+        }
+        if (!IsInline() && !other.IsInline() && alloc_ == other.alloc_) {
+            std::swap(arr_, other.arr_);
+            std::swap(size_, other.size_);
+            std::swap(cap_, other.cap_);
+            return;
+        }
+        SmallVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    T* Begin() noexcept {
+        return arr_;
+    }
+
+    T* End() noexcept {
+        return arr_ + size_;
+    }
+
+    T& operator[](size_t pos) {
+        return arr_[pos];
+    }
+
+    const T& operator[](size_t pos) const {
+        return arr_[pos];
+    }
+
+    T& Front() const noexcept {
+        return arr_[0];
+    }
+
+    T& Back() const noexcept {
+        return arr_[size_ - 1];
+    }
+
+    T* Data() const noexcept {
+        return arr_;
+    }
+
+    bool IsEmpty() const noexcept {
+        return size_ == 0;
+    }
+
+    bool IsInline() const noexcept {
+        return arr_ == InlineData();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return cap_;
+    }
+
+    void Reserve(size_t new_cap) {
+        if (new_cap <= cap_) {
+            return;
+        }
+        T* new_arr = AllocTraits::allocate(alloc_, new_cap);
+        try {
+            Relocate(arr_, size_, new_arr);
+        } catch (...) {
+            AllocTraits::deallocate(alloc_, new_arr, new_cap);
+            throw;
+        }
+        this->ReleaseHeap();
+        arr_ = new_arr;
+        cap_ = new_cap;
+    }
+
+    void Clear() noexcept {
+        for (size_t i = 0; i < size_; ++i) {
+            AllocTraits::destroy(alloc_, arr_ + i);
+        }
+        size_ = 0;
+    }
+
+    void Insert(size_t pos, T value) {  // insert before pos
+        if (pos > size_) {
+            return;
+        }
+        if (pos == size_) {
+            this->EmplaceBack(std::move(value));
+            return;
+        }
+        this->GrowIfFull();
+        AllocTraits::construct(alloc_, arr_ + size_, std::move(arr_[size_ - 1]));
+        for (size_t i = size_ - 1; i > pos; --i) {
+            arr_[i] = std::move(arr_[i - 1]);
+        }
+        arr_[pos] = std::move(value);
+        ++size_;
+    }
+
+    void Erase(size_t begin_pos, size_t end_pos) {
+        if (begin_pos >= end_pos || end_pos > size_) {
+            return;
+        }
+        size_t num_to_erase = end_pos - begin_pos;
+        for (size_t i = begin_pos; i + num_to_erase < size_; ++i) {
+            arr_[i] = std::move(arr_[i + num_to_erase]);
+        }
+        for (size_t i = size_ - num_to_erase; i < size_; ++i) {
+            AllocTraits::destroy(alloc_, arr_ + i);
+        }
+        size_ -= num_to_erase;
+    }
+
+    void PushBack(const T& value) {
+        this->EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        this->EmplaceBack(std::move(value));
+    }
+
+    template <class... Args>
+    void EmplaceBack(Args&&... args) {
+        if (size_ == cap_) {
+            // args may alias an element, so build the new one before relocating
+            T tmp(std::forward<Args>(args)...);
+            this->GrowIfFull();
+            AllocTraits::construct(alloc_, arr_ + size_, std::move(tmp));
+        } else {
+            AllocTraits::construct(alloc_, arr_ + size_, std::forward<Args>(args)...);
+        }
+        ++size_;
+    }
+
+    void PopBack() {
+        if (size_ != 0) {
+            AllocTraits::destroy(alloc_, arr_ + (--size_));
+        }
+    }
+
+    void Resize(size_t count, const T& value = T()) {
+        if (count < size_) {
+            for (size_t i = count; i < size_; ++i) {
+                AllocTraits::destroy(alloc_, arr_ + i);
+            }
+            size_ = count;
+            return;
+        }
+        T copy(value);  // value may point into the buffer that Reserve releases
+        this->Reserve(count);
+        for (; size_ < count; ++size_) {
+            AllocTraits::construct(alloc_, arr_ + size_, copy);
+        }
+    }
+
+    ~SmallVector() {
+        this->Clear();
+        this->ReleaseHeap();
+    }
+
+private:
+    using AllocTraits = std::allocator_traits<Alloc>;
+
+    T* InlineData() const noexcept {
+        return std::launder(reinterpret_cast<T*>(const_cast<std::byte*>(inline_)));
+    }
+
+    void GrowIfFull() {
+        if (size_ == cap_) {
+            this->Reserve(cap_ * 2);
+        }
+    }
+
+    // Moves count elements to uninitialized dst and destroys the sources
+    void Relocate(T* src, size_t count, T* dst) {
+        if constexpr (kIsTriviallyRelocatable<T>) {
+            if (count > 0) {
+                std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+            }
+        } else {
+            size_t i = 0;
+            try {
+                for (; i < count; ++i) {
+                    AllocTraits::construct(alloc_, dst + i, std::move_if_noexcept(src[i]));
+                }
+            } catch (...) {
+                for (size_t j = 0; j < i; ++j) {
+                    AllocTraits::destroy(alloc_, dst + j);
+                }
+                throw;
+            }
+            for (size_t j = 0; j < count; ++j) {
+                AllocTraits::destroy(alloc_, src + j);
+            }
+        }
+    }
+
+    void ReleaseHeap() noexcept {
+        if (!IsInline()) {
+            AllocTraits::deallocate(alloc_, arr_, cap_);
+            arr_ = InlineData();
+            cap_ = N;
+        }
+    }
+
+    void CopyFrom(const SmallVector& other) {
+        this->Reserve(other.size_);
+        for (; size_ < other.size_; ++size_) {
+            AllocTraits::construct(alloc_, arr_ + size_, other.arr_[size_]);
+        }
+    }
+
+    // Expects *this empty and inline
+    void StealFrom(SmallVector& other) {
+        if (!other.IsInline() && alloc_ == other.alloc_) {
+            arr_ = other.arr_;
+            cap_ = other.cap_;
+            size_ = other.size_;
+            other.arr_ = other.InlineData();
+            other.cap_ = N;
+            other.size_ = 0;
+            return;
+        }
+        this->Reserve(other.size_);
+        for (; size_ < other.size_; ++size_) {
+            AllocTraits::construct(alloc_, arr_ + size_, std::move(other.arr_[size_]));
+        }
+        other.Clear();
+        other.ReleaseHeap();
+    }
+
+    alignas(T) std::byte inline_[N * sizeof(T)];
+    T* arr_ = InlineData();
+    size_t size_ = 0;
+    size_t cap_ = N;
+    Alloc alloc_;
+};
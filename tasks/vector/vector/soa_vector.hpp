@@ -0,0 +1,516 @@
+#pragma once
+
+#include <span>
+#include <tuple>
+
+#include "vector.hpp"
+
+// Structure of arrays: one contiguous column per field with a shared size and capacity.
+// Loops that touch one field stream through one column instead of whole records.
+// Columns grow together through GrowthPolicy and relocate like Vector does;
+// each column allocates through Alloc rebound to its element type.
+template <typename Alloc, typename GrowthPolicy, typename... Ts>
+class BasicSoAVector {
+    static_assert(sizeof...(Ts) > 0, "SoAVector needs at least one column");
+
+    template <typename T>
+    using ColumnAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+    template <typename T>
+    using AllocTraits = std::allocator_traits<ColumnAlloc<T>>;
+
+    using Columns = std::tuple<Ts*...>;
+    using Allocators = std::tuple<ColumnAlloc<Ts>...>;
+    using Indices = std::index_sequence_for<Ts...>;
+
+    static constexpr size_t kRowBytes = (sizeof(Ts) + ...);
+
+    static constexpr bool kPropagateOnCopy = std::allocator_traits<Alloc>::propagate_on_container_copy_assignment::value;
+    static constexpr bool kPropagateOnMove = std::allocator_traits<Alloc>::propagate_on_container_move_assignment::value;
+    static constexpr bool kAlwaysEqual = std::allocator_traits<Alloc>::is_always_equal::value;
+
+public:
+    using Value = std::tuple<Ts...>;
+    using Reference = std::tuple<Ts&...>;
+    using ConstReference = std::tuple<const Ts&...>;
+
+    template <size_t I>
+    using ColumnType = std::tuple_element_t<I, Value>;
+
+    template <bool Const>
+    class ZipIterator;
+
+    using Iterator = ZipIterator<false>;
+    using ConstIterator = ZipIterator<true>;
+
+    BasicSoAVector() = default;
+
+    // For stateful allocators, e.g. ArenaAllocator<std::byte>(arena); every column rebinds it
+    explicit BasicSoAVector(const Alloc& alloc) : allocs_(ColumnAlloc<Ts>(alloc)...) {
+    }
+
+    explicit BasicSoAVector(size_t count) : BasicSoAVector() {
+        this->Resize(count);
+    }
+
+    BasicSoAVector(std::initializer_list<Value> init) : BasicSoAVector() {
+        this->Reserve(this->NextCapacity(init.size()));
+        for (const auto& row : init) {
+            this->PushBack(row);
+        }
+    }
+
+    BasicSoAVector(const BasicSoAVector& other) : BasicSoAVector(SelectOnCopy(other.allocs_)) {
+        this->AppendRows(other);
+    }
+
+    // The buffers move together with the allocators that own them
+    BasicSoAVector(BasicSoAVector&& other) noexcept
+        : columns_(std::exchange(other.columns_, Columns{})),
+          size_(std::exchange(other.size_, 0)),
+          cap_(std::exchange(other.cap_, 0)),
+          allocs_(std::move(other.allocs_)) {
+    }
+
+    BasicSoAVector& operator=(const BasicSoAVector& other) {
+        if (this != &other) {
+            BasicSoAVector tmp(kPropagateOnCopy ? other.allocs_ : allocs_);
+            tmp.AppendRows(other);
+            this->Swap(tmp);
+        }
+        return *this;
+    }
+
+    // With allocators that neither propagate nor compare equal the rows are moved one by one
+    BasicSoAVector& operator=(BasicSoAVector&& other) noexcept(kPropagateOnMove || kAlwaysEqual) {
+        if (this == &other) {
+            return *this;
+        }
+        if (kPropagateOnMove || allocs_ == other.allocs_) {
+            BasicSoAVector tmp(std::move(other));
+            this->Swap(tmp);
+        } else {
+            BasicSoAVector tmp(allocs_);
+            tmp.AppendRows(std::move(other));
+            other.Clear();
+            this->Swap(tmp);
+        }
+        return *this;
+    }
+
+    // Swaps the allocators along with the buffers
+    void Swap(BasicSoAVector& other) noexcept {
+        std::swap(columns_, other.columns_);
+        std::swap(size_, other.size_);
+        std::swap(cap_, other.cap_);
+        std::swap(allocs_, other.allocs_);
+    }
+
+    void PushBack(const Value& row) {
+        this->EmplaceRow(row, Indices{});
+    }
+
+    void PushBack(Value&& row) {
+        this->EmplaceRow(std::move(row), Indices{});
+    }
+
+    // One constructor argument per column
+    template <class... Args>
+    void EmplaceBack(Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Ts), "EmplaceBack takes one value per column");
+        this->EmplaceRow(std::forward_as_tuple(std::forward<Args>(args)...), Indices{});
+    }
+
+    void PopBack() {
+        if (size_ != 0) {
+            this->DestroyRow(columns_, --size_, Indices{});
+        }
+    }
+
+    void Reserve(size_t new_cap) {
+        if (new_cap <= cap_) {
+            return;
+        }
+        Columns fresh = this->AllocateColumns(new_cap, Indices{});
+        try {
+            this->Relocate(fresh, Indices{});
+        } catch (...) {
+            this->Deallocate(fresh, new_cap, Indices{});
+            throw;
+        }
+        this->Deallocate(columns_, cap_, Indices{});
+        columns_ = fresh;
+        cap_ = new_cap;
+    }
+
+    void Resize(size_t count) {
+        this->Resize(count, Value{});
+    }
+
+    void Resize(size_t count, const Value& value) {
+        while (size_ > count) {
+            this->PopBack();
+        }
+        if (count > cap_) {
+            this->Reserve(this->NextCapacity(count));
+        }
+        while (size_ < count) {
+            this->EmplaceRow(value, Indices{});
+        }
+    }
+
+    void Clear() noexcept {
+        while (size_ > 0) {
+            this->PopBack();
+        }
+    }
+
+    // Contiguous view of field I, e.g. for SIMD reductions
+    template <size_t I>
+    std::span<ColumnType<I>> Column() noexcept {
+        return {std::get<I>(columns_), size_};
+    }
+
+    template <size_t I>
+    std::span<const ColumnType<I>> Column() const noexcept {
+        return {std::get<I>(columns_), size_};
+    }
+
+    Reference operator[](size_t pos) noexcept {
+        return this->Row(pos, Indices{});
+    }
+
+    ConstReference operator[](size_t pos) const noexcept {
+        return this->Row(pos, Indices{});
+    }
+
+    Reference Front() noexcept {
+        return (*this)[0];
+    }
+
+    Reference Back() noexcept {
+        return (*this)[size_ - 1];
+    }
+
+    Iterator Begin() noexcept {
+        return Iterator(columns_, 0);
+    }
+
+    Iterator End() noexcept {
+        return Iterator(columns_, size_);
+    }
+
+    ConstIterator Begin() const noexcept {
+        return ConstIterator(columns_, 0);
+    }
+
+    ConstIterator End() const noexcept {
+        return ConstIterator(columns_, size_);
+    }
+
+    Iterator begin() noexcept {
+        return Begin();
+    }
+
+    Iterator end() noexcept {
+        return End();
+    }
+
+    ConstIterator begin() const noexcept {
+        return Begin();
+    }
+
+    ConstIterator end() const noexcept {
+        return End();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return cap_;
+    }
+
+    bool IsEmpty() const noexcept {
+        return size_ == 0;
+    }
+
+    ~BasicSoAVector() {
+        this->Clear();
+        this->Deallocate(columns_, cap_, Indices{});
+    }
+
+    // Random access iterator whose reference is a tuple of references into every column
+    template <bool Const>
+    class ZipIterator {
+    public:
+        // NOLINTNEXTLINE
+        using value_type = Value;
+        // NOLINTNEXTLINE
+        using reference = std::conditional_t<Const, ConstReference, Reference>;
+        // NOLINTNEXTLINE
+        using difference_type = std::ptrdiff_t;
+        // NOLINTNEXTLINE
+        using iterator_category = std::random_access_iterator_tag;
+
+        ZipIterator() = default;
+
+        reference operator*() const noexcept {
+            return std::apply([this](auto*... column) { return reference(column[pos_]...); }, columns_);
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return *(*this + offset);
+        }
+
+        ZipIterator& operator++() noexcept {
+            ++pos_;
+            return *this;
+        }
+
+        ZipIterator operator++(int) noexcept {
+            ZipIterator copy = *this;
+            ++pos_;
+            return copy;
+        }
+
+        ZipIterator& operator--() noexcept {
+            --pos_;
+            return *this;
+        }
+
+        ZipIterator operator--(int) noexcept {
+            ZipIterator copy = *this;
+            --pos_;
+            return copy;
+        }
+
+        ZipIterator& operator+=(difference_type offset) noexcept {
+            pos_ += offset;
+            return *this;
+        }
+
+        ZipIterator& operator-=(difference_type offset) noexcept {
+            pos_ -= offset;
+            return *this;
+        }
+
+        ZipIterator operator+(difference_type offset) const noexcept {
+            return ZipIterator(columns_, pos_ + offset);
+        }
+
+        friend ZipIterator operator+(difference_type offset, const ZipIterator& it) noexcept {
+            return it + offset;
+        }
+
+        ZipIterator operator-(difference_type offset) const noexcept {
+            return ZipIterator(columns_, pos_ - offset);
+        }
+
+        difference_type operator-(const ZipIterator& other) const noexcept {
+            return static_cast<difference_type>(pos_) - static_cast<difference_type>(other.pos_);
+        }
+
+        bool operator==(const ZipIterator& other) const noexcept {
+            return pos_ == other.pos_;
+        }
+
+        auto operator<=>(const ZipIterator& other) const noexcept {
+            return pos_ <=> other.pos_;
+        }
+
+    private:
+        friend BasicSoAVector;
+
+        ZipIterator(const Columns& columns, size_t pos) : columns_(columns), pos_(pos) {
+        }
+
+        Columns columns_{};
+        size_t pos_ = 0;
+    };
+
+private:
+    explicit BasicSoAVector(const Allocators& allocs) : allocs_(allocs) {
+    }
+
+    template <size_t... I>
+    Reference Row(size_t pos, std::index_sequence<I...>) noexcept {
+        return Reference(std::get<I>(columns_)[pos]...);
+    }
+
+    template <size_t... I>
+    ConstReference Row(size_t pos, std::index_sequence<I...>) const noexcept {
+        return ConstReference(std::get<I>(columns_)[pos]...);
+    }
+
+    template <size_t... I>
+    std::tuple<Ts&&...> MoveRow(size_t pos, std::index_sequence<I...>) noexcept {
+        return std::tuple<Ts&&...>(std::move(std::get<I>(columns_)[pos])...);
+    }
+
+    static Allocators SelectOnCopy(const Allocators& allocs) {
+        return std::apply(
+            [](const auto&... alloc) {
+                return Allocators(
+                    std::allocator_traits<std::remove_cvref_t<decltype(alloc)>>::select_on_container_copy_construction(
+                        alloc)...);
+            },
+            allocs);
+    }
+
+    // The rows of a vector whose buffers this one may not take over
+    template <class Source>
+    void AppendRows(Source&& other) {
+        if (size_ + other.size_ > cap_) {
+            this->Reserve(this->NextCapacity(size_ + other.size_));
+        }
+        for (size_t i = 0; i < other.size_; ++i) {
+            if constexpr (std::is_lvalue_reference_v<Source>) {
+                this->EmplaceRow(other.Row(i, Indices{}), Indices{});
+            } else {
+                this->EmplaceRow(other.MoveRow(i, Indices{}), Indices{});
+            }
+        }
+    }
+
+    size_t NextCapacity(size_t required) const noexcept {
+        return GrowthPolicy::NextCapacity(cap_, required, kRowBytes);
+    }
+
+    // Builds the new row in the new buffers before moving the old rows, so the source may live in this vector
+    template <class Tuple, size_t... I>
+    void EmplaceRow(Tuple&& row, std::index_sequence<I...>) {
+        if (size_ < cap_) {
+            this->ConstructRow(columns_, size_, Indices{}, std::get<I>(std::forward<Tuple>(row))...);
+            ++size_;
+            return;
+        }
+        size_t new_cap = this->NextCapacity(size_ + 1);
+        Columns fresh = this->AllocateColumns(new_cap, Indices{});
+        try {
+            this->ConstructRow(fresh, size_, Indices{}, std::get<I>(std::forward<Tuple>(row))...);
+        } catch (...) {
+            this->Deallocate(fresh, new_cap, Indices{});
+            throw;
+        }
+        try {
+            this->Relocate(fresh, Indices{});
+        } catch (...) {
+            this->DestroyRow(fresh, size_, Indices{});
+            this->Deallocate(fresh, new_cap, Indices{});
+            throw;
+        }
+        this->Deallocate(columns_, cap_, Indices{});
+        columns_ = fresh;
+        cap_ = new_cap;
+        ++size_;
+    }
+
+    // Constructs column by column; destroys the finished columns if a constructor throws
+    template <size_t... I, class... Args>
+    void ConstructRow(const Columns& columns, size_t pos, std::index_sequence<I...>, Args&&... args) {
+        size_t done = 0;
+        try {
+            ((AllocTraits<Ts>::construct(std::get<I>(allocs_), std::get<I>(columns) + pos, std::forward<Args>(args)),
+              ++done),
+             ...);
+        } catch (...) {
+            ((I < done ? AllocTraits<Ts>::destroy(std::get<I>(allocs_), std::get<I>(columns) + pos) : void()), ...);
+            throw;
+        }
+    }
+
+    template <size_t... I>
+    void DestroyRow(const Columns& columns, size_t pos, std::index_sequence<I...>) noexcept {
+        (AllocTraits<Ts>::destroy(std::get<I>(allocs_), std::get<I>(columns) + pos), ...);
+    }
+
+    template <size_t... I>
+    Columns AllocateColumns(size_t count, std::index_sequence<I...>) {
+        Columns columns{};
+        try {
+            ((std::get<I>(columns) = AllocTraits<Ts>::allocate(std::get<I>(allocs_), count)), ...);
+        } catch (...) {
+            this->Deallocate(columns, count, Indices{});
+            throw;
+        }
+        return columns;
+    }
+
+    template <size_t... I>
+    void Deallocate(const Columns& columns, size_t cap, std::index_sequence<I...>) noexcept {
+        ((std::get<I>(columns) != nullptr ? AllocTraits<Ts>::deallocate(std::get<I>(allocs_), std::get<I>(columns), cap)
+                                          : void()),
+         ...);
+    }
+
+    // Moves the rows into target and destroys the originals. If a column throws, the columns
+    // relocated before it are restored, so the old rows are intact; as in Vector, the guarantee
+    // is lost only for a column that can neither be copied nor moved without throwing.
+    template <size_t... I>
+    void Relocate(const Columns& target, std::index_sequence<I...>) {
+        size_t moved = 0;
+        try {
+            ((RelocateColumn(std::get<I>(allocs_), std::get<I>(columns_), std::get<I>(target), size_), ++moved), ...);
+        } catch (...) {
+            ((I < moved ? RestoreColumn(std::get<I>(allocs_), std::get<I>(columns_), std::get<I>(target), size_)
+                        : void()),
+             ...);
+            throw;
+        }
+        (DestroyColumn(std::get<I>(allocs_), std::get<I>(columns_), size_), ...);
+    }
+
+    template <typename T>
+    static void RelocateColumn(ColumnAlloc<T>& alloc, T* from, T* to, size_t count) {
+        if constexpr (kIsTriviallyRelocatable<T>) {
+            if (count > 0) {
+                std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+            }
+        } else {
+            size_t i = 0;
+            try {
+                for (; i < count; ++i) {
+                    AllocTraits<T>::construct(alloc, to + i, std::move_if_noexcept(from[i]));
+                }
+            } catch (...) {
+                DestroyColumn(alloc, to, i);
+                throw;
+            }
+        }
+    }
+
+    // Undoes RelocateColumn: memcpy'd originals are untouched, moved-from ones get their values back
+    template <typename T>
+    static void RestoreColumn(ColumnAlloc<T>& alloc, T* from, T* to, size_t count) noexcept {
+        if constexpr (kIsTriviallyRelocatable<T>) {
+            return;
+        } else if constexpr (std::is_nothrow_move_constructible_v<T>) {
+            for (size_t i = 0; i < count; ++i) {
+                AllocTraits<T>::destroy(alloc, from + i);
+                AllocTraits<T>::construct(alloc, from + i, std::move(to[i]));
+                AllocTraits<T>::destroy(alloc, to + i);
+            }
+        } else {
+            DestroyColumn(alloc, to, count);
+        }
+    }
+
+    template <typename T>
+    static void DestroyColumn(ColumnAlloc<T>& alloc, T* column, size_t count) noexcept {
+        if constexpr (!kIsTriviallyRelocatable<T>) {
+            for (size_t i = 0; i < count; ++i) {
+                AllocTraits<T>::destroy(alloc, column + i);
+            }
+        }
+    }
+
+    Columns columns_{};
+    size_t size_ = 0;
+    size_t cap_ = 0;
+    Allocators allocs_;
+};
+
+template <typename... Ts>
+using SoAVector = BasicSoAVector<std::allocator<std::byte>, DoublingGrowth, Ts...>;
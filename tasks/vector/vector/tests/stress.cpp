@@ -1,6 +1,23 @@
 #include "../vector.hpp"
 #include "../vector.cpp"
+#include "../small_vector.hpp"
+#include "../simd_algorithms.hpp"
+#include "../mmap_vector.hpp"
+#include "../concurrent_segmented_vector.hpp"
+#include "../soa_vector.hpp"
+#include "../bit_vector.hpp"
+#include "../slot_map.hpp"
+#include "../../allocator/tracking_allocator.hpp"
 
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
 #include <random>
 #include <vector>
 #include <string>
@@ -8,7 +25,8 @@
 #include <benchmark/benchmark.h>
 #include <fmt/core.h>
 
-void ConstructRandomVector(Vector<int>& vec, int sz) {
+template <typename Alloc, typename Policy>
+void ConstructRandomVector(Vector<int, Alloc, Policy>& vec, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -20,7 +38,8 @@ void ConstructRandomVector(Vector<int>& vec, int sz) {
   }
 }
 
-void ConstructRandomVector(std::vector<int>& vec, int sz) {
+template <typename Alloc>
+void ConstructRandomVector(std::vector<int, Alloc>& vec, int sz) {
   std::random_device rd;
   std::mt19937 mt(rd());
   std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -33,24 +52,87 @@ void ConstructRandomVector(std::vector<int>& vec, int sz) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// The Vector and std::vector benchmarks are registered twice: with the plain allocator, so timings
+// stay comparable with earlier runs, and with a tracked container that reports allocs/iter and
+// bytes/iter. The counters cover the whole iteration, paused setup included.
+static size_t regrowth_count = 0;
+
+// Vector calls OnReserve for every buffer it moves to, so this also counts in-place reallocs
+struct CountingGrowth : DoublingGrowth {
+  static void OnReserve(void* /*ptr*/, size_t /*bytes*/) {
+    ++regrowth_count;
+  }
+};
+
+// Both count into AllocationTag::Untagged(); TrackedVector also reports regrowths/iter
+template <typename T>
+using TrackedVector = Vector<T, TrackingAllocator<T>, CountingGrowth>;
+
+template <typename T>
+using TrackedStdVector = std::vector<T, TrackingAllocator<T>>;
+
+template <typename Container>
+constexpr bool kTracked = false;
+
+template <typename T>
+constexpr bool kTracked<TrackedVector<T>> = true;
+
+template <typename T>
+constexpr bool kTracked<TrackedStdVector<T>> = true;
+
+template <typename Container>
+constexpr bool kCountsRegrowths = false;
+
+template <typename T>
+constexpr bool kCountsRegrowths<TrackedVector<T>> = true;
+
+struct AllocationSnapshot {
+  AllocationStats stats = AllocationTag::Untagged().Snapshot();
+  size_t regrowths = regrowth_count;
+};
+
+// Leaves the counters out for untracked containers
+template <typename Container>
+void ReportAllocations(benchmark::State& state, const AllocationSnapshot& before) {
+  if constexpr (kTracked<Container>) {
+    AllocationSnapshot after;
+    state.counters["allocs/iter"] = benchmark::Counter(
+        static_cast<double>(after.stats.allocations - before.stats.allocations), benchmark::Counter::kAvgIterations);
+    state.counters["bytes/iter"] = benchmark::Counter(
+        static_cast<double>(after.stats.bytes_allocated - before.stats.bytes_allocated), benchmark::Counter::kAvgIterations);
+    if constexpr (kCountsRegrowths<Container>) {
+      state.counters["regrowths/iter"] = benchmark::Counter(static_cast<double>(after.regrowths - before.regrowths),
+                                                            benchmark::Counter::kAvgIterations);
+    }
+  }
+}
+
+template <typename VectorType>
 void BM_CustomVectorPushBack(benchmark::State& state) {
-  Vector<int> vec;
+  AllocationSnapshot before;
+  VectorType vec;
   for (auto _ : state) {
     ConstructRandomVector(vec, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<VectorType>(state, before);
 }
 
+template <typename VectorType>
 void BM_StdVectorPushBack(benchmark::State& state) {
-  std::vector<int> vec;
+  AllocationSnapshot before;
+  VectorType vec;
   for (auto _ : state) {
     ConstructRandomVector(vec, state.range(0));
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<VectorType>(state, before);
 }
 
+template <typename VectorType>
 void BM_CustomVectorMiddleInsert(benchmark::State& state) {
-  Vector<int> vec;
+  AllocationSnapshot before;
+  VectorType vec;
   ConstructRandomVector(vec, 100);
   for (auto _ : state) {
     for (int i = 0; i < state.range(0); ++i){
@@ -58,10 +140,13 @@ void BM_CustomVectorMiddleInsert(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<VectorType>(state, before);
 }
 
+template <typename VectorType>
 void BM_StdVectorMiddleInsert(benchmark::State& state) {
-  std::vector<int> vec;
+  AllocationSnapshot before;
+  VectorType vec;
   ConstructRandomVector(vec, 100);
   auto it = vec.begin();
   for (auto _ : state) {
@@ -72,12 +157,846 @@ void BM_StdVectorMiddleInsert(benchmark::State& state) {
     }
   }
   state.SetComplexityN(state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+struct Pod {
+  int64_t a = 0;
+  int64_t b = 0;
+  int64_t c = 0;
+  int64_t d = 0;
+};
+
+// Same layout as Pod, but the user-provided copy makes Vector relocate element by element
+struct NonTrivialPod {
+  int64_t a = 0;
+  int64_t b = 0;
+  int64_t c = 0;
+  int64_t d = 0;
+
+  NonTrivialPod() = default;
+  NonTrivialPod(const NonTrivialPod& other) : a(other.a), b(other.b), c(other.c), d(other.d) {}
+};
+
+template <typename T, typename VectorType = Vector<T>>
+void BM_VectorReserve(benchmark::State& state) {
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    state.PauseTiming();
+    VectorType vec;
+    vec.Resize(state.range(0));
+    state.ResumeTiming();
+    vec.Reserve(2 * state.range(0));
+    benchmark::DoNotOptimize(vec.Data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+  ReportAllocations<VectorType>(state, before);
+}
+
+template <typename T, typename VectorType = Vector<T>>
+void BM_VectorGrowingPushBack(benchmark::State& state) {
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    VectorType vec;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      vec.PushBack(T());
+    }
+    benchmark::DoNotOptimize(vec.Data());
+  }
+  state.SetComplexityN(state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+template <typename T, typename VectorType = Vector<T>>
+void BM_VectorGrowingResize(benchmark::State& state) {
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    VectorType vec;
+    for (int64_t sz = 1; sz <= state.range(0); sz *= 2) {
+      vec.Resize(sz);
+    }
+    benchmark::DoNotOptimize(vec.Data());
+  }
+  state.SetComplexityN(state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+static size_t allocation_count = 0;
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    ++allocation_count;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* ptr, size_t n) {
+    std::allocator<T>().deallocate(ptr, n);
+  }
+
+  bool operator==(const CountingAllocator&) const = default;
+};
+
+const int kBatches = 16;
+
+template <typename VectorType>
+void BM_CustomVectorAppendRange(benchmark::State& state) {
+  std::vector<int> batch;
+  ConstructRandomVector(batch, state.range(0));
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    VectorType vec;
+    for (int i = 0; i < kBatches; ++i) {
+      vec.Append(batch.begin(), batch.end());
+    }
+    benchmark::DoNotOptimize(vec.Data());
+  }
+  state.SetItemsProcessed(state.iterations() * kBatches * state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+template <typename VectorType>
+void BM_StdVectorAppendRange(benchmark::State& state) {
+  std::vector<int> batch;
+  ConstructRandomVector(batch, state.range(0));
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    VectorType vec;
+    for (int i = 0; i < kBatches; ++i) {
+      vec.insert(vec.end(), batch.begin(), batch.end());
+    }
+    benchmark::DoNotOptimize(vec.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kBatches * state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+template <typename VectorType>
+void BM_CustomVectorInsertRangeFront(benchmark::State& state) {
+  std::vector<int> batch;
+  ConstructRandomVector(batch, state.range(0));
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    VectorType vec;
+    for (int i = 0; i < kBatches; ++i) {
+      vec.Insert(0, batch.begin(), batch.end());
+    }
+    benchmark::DoNotOptimize(vec.Data());
+  }
+  state.SetItemsProcessed(state.iterations() * kBatches * state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+template <typename VectorType>
+void BM_StdVectorInsertRangeFront(benchmark::State& state) {
+  std::vector<int> batch;
+  ConstructRandomVector(batch, state.range(0));
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    VectorType vec;
+    for (int i = 0; i < kBatches; ++i) {
+      vec.insert(vec.begin(), batch.begin(), batch.end());
+    }
+    benchmark::DoNotOptimize(vec.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kBatches * state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+template <typename VectorType>
+void BM_CustomVectorEraseIf(benchmark::State& state) {
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    state.PauseTiming();
+    VectorType vec;
+    ConstructRandomVector(vec, state.range(0));
+    state.ResumeTiming();
+    vec.EraseIf([](int x) { return x % 2 == 0; });
+    benchmark::DoNotOptimize(vec.Data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+template <typename VectorType>
+void BM_StdVectorEraseIf(benchmark::State& state) {
+  AllocationSnapshot before;
+  for (auto _ : state) {
+    state.PauseTiming();
+    VectorType vec;
+    ConstructRandomVector(vec, state.range(0));
+    state.ResumeTiming();
+    std::erase_if(vec, [](int x) { return x % 2 == 0; });
+    benchmark::DoNotOptimize(vec.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ReportAllocations<VectorType>(state, before);
+}
+
+// Linux only: "5" resets the VmHWM high-water mark so each run sees its own peak
+void ResetPeakRss() {
+  std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+size_t PeakRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0) {
+      return std::stoul(line.substr(6));
+    }
+  }
+  return 0;
+}
+
+template <typename Policy>
+void BM_GrowthPolicyPushBack(benchmark::State& state) {
+  size_t reallocs = 0;
+  size_t peak_kb = 0;
+  size_t slack = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    ResetPeakRss();
+    state.ResumeTiming();
+    Vector<int, std::allocator<int>, Policy> vec;
+    size_t cap = 0;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      vec.PushBack(static_cast<int>(i));
+      if (vec.Capacity() != cap) {
+        cap = vec.Capacity();
+        ++reallocs;
+      }
+    }
+    state.PauseTiming();
+    peak_kb = std::max(peak_kb, PeakRssKb());
+    slack = vec.Capacity() - vec.Size();
+    state.ResumeTiming();
+  }
+  double iterations = static_cast<double>(state.iterations());
+  state.counters["reallocs"] = benchmark::Counter(static_cast<double>(reallocs) / iterations);
+  state.counters["peak_rss_mb"] = benchmark::Counter(static_cast<double>(peak_kb) / 1024);
+  state.counters["slack_pct"] = benchmark::Counter(100.0 * static_cast<double>(slack) / static_cast<double>(state.range(0)));
+}
+
+// memset stands in for read(fd, data, size) filling a receive buffer
+void BM_VectorFillValueInit(benchmark::State& state) {
+  for (auto _ : state) {
+    Vector<uint8_t> buffer;
+    buffer.Resize(state.range(0));
+    std::memset(buffer.Data(), 0xAB, buffer.Size());
+    benchmark::DoNotOptimize(buffer.Data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_VectorFillUninitialized(benchmark::State& state) {
+  for (auto _ : state) {
+    Vector<uint8_t> buffer;
+    buffer.ResizeUninitialized(state.range(0));
+    std::memset(buffer.Data(), 0xAB, buffer.Size());
+    benchmark::DoNotOptimize(buffer.Data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_VectorFillAppendUninitialized(benchmark::State& state) {
+  const int64_t chunk = 1 << 16;
+  for (auto _ : state) {
+    Vector<uint8_t> buffer;
+    for (int64_t filled = 0; filled < state.range(0); filled += chunk) {
+      std::memset(buffer.AppendUninitialized(chunk), 0xAB, chunk);
+    }
+    benchmark::DoNotOptimize(buffer.Data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+template <typename T>
+Vector<T> MakeScanInput(int64_t size) {
+  Vector<T> vec(size, kDefaultInit);
+  for (int64_t i = 0; i < size; ++i) {
+    vec[i] = static_cast<T>(i % 1000);
+  }
+  return vec;
+}
+
+// The needle is absent, so Find and Contains scan the whole array
+template <typename T, simd::Level L>
+void BM_SimdFind(benchmark::State& state) {
+  auto vec = MakeScanInput<T>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(simd::Find(vec.Data(), vec.Size(), static_cast<T>(5000), L));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+template <typename T, simd::Level L>
+void BM_SimdCount(benchmark::State& state) {
+  auto vec = MakeScanInput<T>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(simd::Count(vec.Data(), vec.Size(), static_cast<T>(7), L));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+template <typename T, simd::Level L>
+void BM_SimdMin(benchmark::State& state) {
+  auto vec = MakeScanInput<T>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(simd::Min(vec.Data(), vec.Size(), L));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+template <typename T, simd::Level L>
+void BM_SimdSum(benchmark::State& state) {
+  auto vec = MakeScanInput<T>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(simd::Sum(vec.Data(), vec.Size(), L));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+#define SIMD_BENCHMARKS(BM, T)                                                                  \
+  BENCHMARK_TEMPLATE(BM, T, simd::Level::kScalar)->RangeMultiplier(8)->Range(1<<10, 1<<26);    \
+  BENCHMARK_TEMPLATE(BM, T, simd::Level::kSse2)->RangeMultiplier(8)->Range(1<<10, 1<<26);      \
+  BENCHMARK_TEMPLATE(BM, T, simd::Level::kAvx2)->RangeMultiplier(8)->Range(1<<10, 1<<26)
+
+// The same uint64_t array as an MmapVector file and as a raw dump that is read back into a Vector
+struct PersistedArray {
+  std::string mmap_path;
+  std::string raw_path;
+};
+
+const PersistedArray& GetPersistedArray(int64_t size) {
+  static std::map<int64_t, PersistedArray> files;
+  auto it = files.find(size);
+  if (it != files.end()) {
+    return it->second;
+  }
+  auto dir = std::filesystem::temp_directory_path();
+  PersistedArray array{(dir / fmt::format("mmap_vector_{}.bin", size)).string(),
+                       (dir / fmt::format("raw_vector_{}.bin", size)).string()};
+  std::filesystem::remove(array.mmap_path);
+  MmapVector<uint64_t> mapped(array.mmap_path);
+  mapped.Reserve(size);
+  for (int64_t i = 0; i < size; ++i) {
+    mapped.PushBack(static_cast<uint64_t>(i));
+  }
+  mapped.Flush();
+  std::ofstream(array.raw_path, std::ios::binary)
+      .write(reinterpret_cast<const char*>(mapped.Data()), size * sizeof(uint64_t));
+  return files.emplace(size, array).first->second;
+}
+
+// Drops the file from the page cache so the next open has to go to disk
+void EvictFromPageCache(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  ::fdatasync(fd);
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(fd);
+}
+
+// Arg 0: array size, arg 1: evict the file before every iteration (cold start)
+void BM_MmapVectorOpenAndSum(benchmark::State& state) {
+  const auto& array = GetPersistedArray(state.range(0));
+  for (auto _ : state) {
+    if (state.range(1)) {
+      state.PauseTiming();
+      EvictFromPageCache(array.mmap_path);
+      state.ResumeTiming();
+    }
+    MmapVector<uint64_t> vec(array.mmap_path, MmapMode::kReadOnly);
+    benchmark::DoNotOptimize(simd::Sum(vec.Data(), vec.Size()));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(uint64_t));
+}
+
+void BM_VectorDeserializeAndSum(benchmark::State& state) {
+  const auto& array = GetPersistedArray(state.range(0));
+  for (auto _ : state) {
+    if (state.range(1)) {
+      state.PauseTiming();
+      EvictFromPageCache(array.raw_path);
+      state.ResumeTiming();
+    }
+    std::FILE* file = std::fopen(array.raw_path.c_str(), "rb");
+    Vector<uint64_t> vec;
+    vec.ResizeUninitialized(state.range(0));
+    size_t read = std::fread(vec.Data(), sizeof(uint64_t), vec.Size(), file);
+    std::fclose(file);
+    benchmark::DoNotOptimize(simd::Sum(vec.Data(), read));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(uint64_t));
+}
+
+// Time to first element: an mmap open does not depend on the file size
+void BM_MmapVectorOpenOnly(benchmark::State& state) {
+  const auto& array = GetPersistedArray(state.range(0));
+  for (auto _ : state) {
+    MmapVector<uint64_t> vec(array.mmap_path, MmapMode::kReadOnly);
+    benchmark::DoNotOptimize(vec.Back());
+  }
+}
+
+// Shared by all benchmark threads; thread 0 builds it before the start barrier and drops it after the end one
+template <typename Container>
+struct LockedContainer {
+  std::mutex mutex;
+  Container container;
+
+  void PushBack(int64_t value) {
+    std::lock_guard lock(mutex);
+    if constexpr (requires { container.PushBack(value); }) {
+      container.PushBack(value);
+    } else {
+      container.push_back(value);
+    }
+  }
+};
+
+template <typename Shared>
+void BM_ConcurrentPushBack(benchmark::State& state) {
+  static Shared* shared = nullptr;
+  if (state.thread_index() == 0) {
+    shared = new Shared();
+  }
+  int64_t value = 0;
+  for (auto _ : state) {
+    shared->PushBack(value++);
+  }
+  if (state.thread_index() == 0) {
+    delete shared;
+    shared = nullptr;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// A typical 48-byte record where the hot loop reads only the price
+struct Order {
+  int64_t id;
+  double price;
+  int32_t quantity;
+  int32_t flags;
+  char symbol[24];
+};
+
+void BM_AoSFieldSum(benchmark::State& state) {
+  Vector<Order> orders;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    orders.PushBack(Order{i, static_cast<double>(i % 100), 1, 0, {}});
+  }
+  for (auto _ : state) {
+    double total = 0;
+    for (size_t i = 0; i < orders.Size(); ++i) {
+      total += orders[i].price;
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SoAFieldSum(benchmark::State& state) {
+  SoAVector<int64_t, double, int32_t, int32_t, std::array<char, 24>> orders;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    orders.EmplaceBack(i, static_cast<double>(i % 100), 1, 0, std::array<char, 24>{});
+  }
+  for (auto _ : state) {
+    double total = 0;
+    for (double price : orders.Column<1>()) {
+      total += price;
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Bitmaps: every third flag set. bytes_per_flag reports the memory footprint.
+template <typename Bits>
+Bits MakeBitmap(size_t size) {
+  Bits bits(size);
+  for (size_t i = 0; i < size; i += 3) {
+    bits[i] = true;
+  }
+  return bits;
+}
+
+template <size_t N>
+std::unique_ptr<std::bitset<N>> MakeBitset() {
+  auto bits = std::make_unique<std::bitset<N>>();
+  for (size_t i = 0; i < N; i += 3) {
+    bits->set(i);
+  }
+  return bits;
+}
+
+template <simd::Level L>
+void BM_BitVectorCount(benchmark::State& state) {
+  auto bits = MakeBitmap<Vector<bool>>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(simd::PopCount(bits.Data(), bits.WordCount(), L));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes_per_flag"] = static_cast<double>(bits.Capacity() / 8) / static_cast<double>(state.range(0));
+}
+
+void BM_StdVectorBoolCount(benchmark::State& state) {
+  auto bits = MakeBitmap<std::vector<bool>>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::count(bits.begin(), bits.end(), true));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes_per_flag"] = static_cast<double>(bits.capacity() / 8) / static_cast<double>(state.range(0));
+}
+
+template <size_t N>
+void BM_BitsetCount(benchmark::State& state) {
+  auto bits = MakeBitset<N>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bits->count());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+  state.counters["bytes_per_flag"] = static_cast<double>(sizeof(*bits)) / static_cast<double>(N);
+}
+
+void BM_BitVectorAnd(benchmark::State& state) {
+  auto bits = MakeBitmap<Vector<bool>>(state.range(0));
+  auto mask = MakeBitmap<Vector<bool>>(state.range(0));
+  for (auto _ : state) {
+    bits &= mask;
+    benchmark::DoNotOptimize(bits.Data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_StdVectorBoolAnd(benchmark::State& state) {
+  auto bits = MakeBitmap<std::vector<bool>>(state.range(0));
+  auto mask = MakeBitmap<std::vector<bool>>(state.range(0));
+  for (auto _ : state) {
+    for (size_t i = 0; i < bits.size(); ++i) {
+      bits[i] = bits[i] && mask[i];
+    }
+    benchmark::DoNotOptimize(&bits);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <size_t N>
+void BM_BitsetAnd(benchmark::State& state) {
+  auto bits = MakeBitset<N>();
+  auto mask = MakeBitset<N>();
+  for (auto _ : state) {
+    *bits &= *mask;
+    benchmark::DoNotOptimize(bits.get());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+
+// Only the last flag is set: a full scan of a sparse "visited" map
+void BM_BitVectorFindFirstSet(benchmark::State& state) {
+  Vector<bool> bits(state.range(0));
+  bits.Set(state.range(0) - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bits.FindFirstSet());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
 }
 
+void BM_StdVectorBoolFindFirstSet(benchmark::State& state) {
+  std::vector<bool> bits(state.range(0));
+  bits.back() = true;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::find(bits.begin(), bits.end(), true));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Bits>
+void BM_BitmapPushBack(benchmark::State& state) {
+  for (auto _ : state) {
+    Bits bits;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      if constexpr (requires { bits.PushBack(true); }) {
+        bits.PushBack(i % 3 == 0);
+      } else {
+        bits.push_back(i % 3 == 0);
+      }
+    }
+    benchmark::DoNotOptimize(&bits);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Request teardown: 16-64 byte blobs, only Clear() is timed
+void BM_PointerVectorTeardownFree(benchmark::State& state) {
+  Vector<void*> blobs;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      blobs.PushBack(std::malloc(16 + i % 4 * 16));
+    }
+    state.ResumeTiming();
+    blobs.Clear();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_PointerVectorTeardownArena(benchmark::State& state) {
+  Vector<void*, ArenaOwnership> blobs;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      blobs.AllocateBack(16 + i % 4 * 16);
+    }
+    state.ResumeTiming();
+    blobs.Clear();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Arg 0: elements, arg 1: threads (pool workers + the caller)
+ParallelTag ParallelWithThreads(int64_t threads) {
+  static std::map<int64_t, std::unique_ptr<ThreadPool>> pools;
+  auto& pool = pools[threads];
+  if (!pool) {
+    pool = std::make_unique<ThreadPool>(threads - 1);
+  }
+  return ParallelTag{pool.get()};
+}
+
+void BM_ParallelCopy(benchmark::State& state) {
+  ParallelTag par = ParallelWithThreads(state.range(1));
+  Vector<uint64_t> source(state.range(0), uint64_t{1});
+  for (auto _ : state) {
+    Vector<uint64_t> copy(par, source);
+    benchmark::DoNotOptimize(copy.Data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(uint64_t));
+}
+
+void BM_ParallelResizeFill(benchmark::State& state) {
+  ParallelTag par = ParallelWithThreads(state.range(1));
+  for (auto _ : state) {
+    Vector<uint64_t> vec;
+    vec.Resize(par, state.range(0), 42);
+    benchmark::DoNotOptimize(vec.Data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(uint64_t));
+}
+
+struct Entity {
+  float position[3];
+  float velocity[3];
+};
+
+// Entities addressed through Vector indices: erase leaves a tombstone, freed indices are reused
+class TombstoneVector {
+public:
+  size_t Insert(const Entity& entity) {
+    if (!free_.IsEmpty()) {
+      size_t index = free_.Back();
+      free_.PopBack();
+      entities_[index] = entity;
+      alive_[index] = 1;
+      return index;
+    }
+    entities_.PushBack(entity);
+    alive_.PushBack(1);
+    return entities_.Size() - 1;
+  }
+
+  void Erase(size_t index) {
+    alive_[index] = 0;
+    free_.PushBack(index);
+  }
+
+  template <class F>
+  void ForEach(F&& fn) {
+    for (size_t i = 0; i < entities_.Size(); ++i) {
+      if (alive_[i]) {
+        fn(entities_[i]);
+      }
+    }
+  }
+
+private:
+  Vector<Entity> entities_;
+  Vector<uint8_t> alive_;
+  Vector<size_t> free_;
+};
+
+// Arg 0: live entities, arg 1: percent of them replaced per frame (random erase + insert) before an update pass
+template <typename Container>
+void BM_EntityFrame(benchmark::State& state) {
+  constexpr bool kSlotMap = std::is_same_v<Container, SlotMap<Entity>>;
+  using Handle = std::conditional_t<kSlotMap, SlotHandle, size_t>;
+  const size_t count = state.range(0);
+  const size_t churn = count * state.range(1) / 100;
+  Container entities;
+  Vector<Handle> handles;
+  for (size_t i = 0; i < count; ++i) {
+    handles.PushBack(entities.Insert(Entity{{1, 2, 3}, {0.5f, 0.5f, 0.5f}}));
+  }
+  std::mt19937 gen(42);
+  for (auto _ : state) {
+    for (size_t i = 0; i < churn; ++i) {
+      size_t victim = gen() % count;
+      entities.Erase(handles[victim]);
+      handles[victim] = entities.Insert(Entity{{1, 2, 3}, {0.5f, 0.5f, 0.5f}});
+    }
+    auto update = [](Entity& entity) {
+      for (int axis = 0; axis < 3; ++axis) {
+        entity.position[axis] += entity.velocity[axis];
+      }
+    };
+    if constexpr (kSlotMap) {
+      for (Entity& entity : entities) {
+        update(entity);
+      }
+    } else {
+      entities.ForEach(update);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// Same population, but half of the entities are erased up front and never come back
+template <typename Container>
+void BM_EntityIterateSparse(benchmark::State& state) {
+  constexpr bool kSlotMap = std::is_same_v<Container, SlotMap<Entity>>;
+  const size_t count = state.range(0);
+  Container entities;
+  for (size_t i = 0; i < count; ++i) {
+    auto handle = entities.Insert(Entity{{1, 2, 3}, {0.5f, 0.5f, 0.5f}});
+    if (i % 2 == 0) {
+      entities.Erase(handle);
+    }
+  }
+  for (auto _ : state) {
+    float sum = 0;
+    if constexpr (kSlotMap) {
+      for (const Entity& entity : entities) {
+        sum += entity.position[0];
+      }
+    } else {
+      entities.ForEach([&](const Entity& entity) { sum += entity.position[0]; });
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename Container>
+void BM_SmallSizePushBack(benchmark::State& state) {
+  allocation_count = 0;
+  for (auto _ : state) {
+    Container vec;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      vec.PushBack(static_cast<int>(i));
+    }
+    benchmark::DoNotOptimize(vec.Data());
+  }
+  state.counters["allocs_per_iter"] =
+      benchmark::Counter(static_cast<double>(allocation_count) / static_cast<double>(state.iterations()));
+}
+
+BENCHMARK_TEMPLATE(BM_CustomVectorPushBack, Vector<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorPushBack, TrackedVector<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdVectorPushBack, std::vector<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdVectorPushBack, TrackedStdVector<int>)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorMiddleInsert, Vector<int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorMiddleInsert, TrackedVector<int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdVectorMiddleInsert, std::vector<int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StdVectorMiddleInsert, TrackedStdVector<int>)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorReserve, int)->Range(1<<10, 1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_VectorReserve, int, TrackedVector<int>)->Range(1<<10, 1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_VectorReserve, Pod)->Range(1<<10, 1<<22)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_VectorReserve, Pod, TrackedVector<Pod>)->Range(1<<10, 1<<22)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_VectorReserve, NonTrivialPod)->Range(1<<10, 1<<22)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_VectorReserve, NonTrivialPod, TrackedVector<NonTrivialPod>)->Range(1<<10, 1<<22)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_VectorGrowingPushBack, Pod)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorGrowingPushBack, Pod, TrackedVector<Pod>)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorGrowingPushBack, NonTrivialPod)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorGrowingPushBack, NonTrivialPod, TrackedVector<NonTrivialPod>)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorGrowingResize, Pod)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorGrowingResize, Pod, TrackedVector<Pod>)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorGrowingResize, NonTrivialPod)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorGrowingResize, NonTrivialPod, TrackedVector<NonTrivialPod>)->Range(1<<10, 1<<22)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorAppendRange, Vector<int>)->Range(1<<6, 1<<16)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorAppendRange, TrackedVector<int>)->Range(1<<6, 1<<16)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_StdVectorAppendRange, std::vector<int>)->Range(1<<6, 1<<16)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_StdVectorAppendRange, TrackedStdVector<int>)->Range(1<<6, 1<<16)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorInsertRangeFront, Vector<int>)->Range(1<<6, 1<<14)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorInsertRangeFront, TrackedVector<int>)->Range(1<<6, 1<<14)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_StdVectorInsertRangeFront, std::vector<int>)->Range(1<<6, 1<<14)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_StdVectorInsertRangeFront, TrackedStdVector<int>)->Range(1<<6, 1<<14)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorEraseIf, Vector<int>)->Range(1<<10, 1<<20)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CustomVectorEraseIf, TrackedVector<int>)->Range(1<<10, 1<<20)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_StdVectorEraseIf, std::vector<int>)->Range(1<<10, 1<<20)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_StdVectorEraseIf, TrackedStdVector<int>)->Range(1<<10, 1<<20)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_SmallSizePushBack, Vector<int, CountingAllocator<int>>)->DenseRange(2, 32, 6);
+BENCHMARK_TEMPLATE(BM_SmallSizePushBack, SmallVector<int, 16, CountingAllocator<int>>)->DenseRange(2, 32, 6);
+BENCHMARK(BM_VectorFillValueInit)->Arg(1<<20)->Arg(1<<30)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_VectorFillUninitialized)->Arg(1<<20)->Arg(1<<30)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_VectorFillAppendUninitialized)->Arg(1<<20)->Arg(1<<30)->Unit(benchmark::kMillisecond);
+SIMD_BENCHMARKS(BM_SimdFind, int32_t);
+SIMD_BENCHMARKS(BM_SimdFind, float);
+SIMD_BENCHMARKS(BM_SimdFind, uint64_t);
+SIMD_BENCHMARKS(BM_SimdCount, int32_t);
+SIMD_BENCHMARKS(BM_SimdCount, float);
+SIMD_BENCHMARKS(BM_SimdCount, uint64_t);
+SIMD_BENCHMARKS(BM_SimdMin, int32_t);
+SIMD_BENCHMARKS(BM_SimdMin, float);
+SIMD_BENCHMARKS(BM_SimdMin, uint64_t);
+SIMD_BENCHMARKS(BM_SimdSum, int32_t);
+SIMD_BENCHMARKS(BM_SimdSum, float);
+SIMD_BENCHMARKS(BM_SimdSum, uint64_t);
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, DoublingGrowth)->Arg(1000)->Arg(3<<20)->Arg(50'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, OneAndHalfGrowth)->Arg(1000)->Arg(3<<20)->Arg(50'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, BucketGrowth)->Arg(1000)->Arg(3<<20)->Arg(50'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, PageAlignedGrowth)->Arg(1000)->Arg(3<<20)->Arg(50'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, HugePageGrowth)->Arg(1000)->Arg(3<<20)->Arg(50'000'000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_MmapVectorOpenAndSum)->ArgsProduct({{1<<20, 1<<25}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_VectorDeserializeAndSum)->ArgsProduct({{1<<20, 1<<25}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MmapVectorOpenOnly)->Arg(1<<20)->Arg(1<<25)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_TEMPLATE(BM_ConcurrentPushBack, ConcurrentSegmentedVector<int64_t>)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentPushBack, LockedContainer<Vector<int64_t>>)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentPushBack, LockedContainer<std::vector<int64_t>>)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK(BM_AoSFieldSum)->Range(1<<10, 1<<22)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SoAFieldSum)->Range(1<<10, 1<<22)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_TEMPLATE(BM_BitVectorCount, simd::Level::kScalar)->Arg(1<<16)->Arg(1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_BitVectorCount, simd::Level::kAvx2)->Arg(1<<16)->Arg(1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StdVectorBoolCount)->Arg(1<<16)->Arg(1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_BitsetCount, 1<<16)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_BitsetCount, 1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BitVectorAnd)->Arg(1<<16)->Arg(1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StdVectorBoolAnd)->Arg(1<<16)->Arg(1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_BitsetAnd, 1<<16)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_BitsetAnd, 1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BitVectorFindFirstSet)->Arg(1<<16)->Arg(1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StdVectorBoolFindFirstSet)->Arg(1<<16)->Arg(1<<24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_BitmapPushBack, Vector<bool>)->Arg(1<<16)->Arg(1<<22)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_BitmapPushBack, std::vector<bool>)->Arg(1<<16)->Arg(1<<22)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_PointerVectorTeardownFree)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PointerVectorTeardownArena)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ParallelCopy)->ArgsProduct({{1<<25}, {1, 2, 4, 8, 16, 32}})->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParallelResizeFill)->ArgsProduct({{1<<25}, {1, 2, 4, 8, 16, 32}})->UseRealTime()->Unit(benchmark::kMillisecond);
 
-BENCHMARK(BM_CustomVectorPushBack)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdVectorPushBack)->Range(1<<10, 1<<20)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_CustomVectorMiddleInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_StdVectorMiddleInsert)->Range(1<<10, 1<<15)->Complexity()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_EntityFrame, SlotMap<Entity>)->ArgsProduct({{1<<12, 1<<20}, {1, 10}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_EntityFrame, TombstoneVector)->ArgsProduct({{1<<12, 1<<20}, {1, 10}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_EntityIterateSparse, SlotMap<Entity>)->Arg(1<<12)->Arg(1<<20)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_EntityIterateSparse, TombstoneVector)->Arg(1<<12)->Arg(1<<20)->Unit(benchmark::kMicrosecond);
 
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -1,16 +1,29 @@
 #include "../vector.hpp"
 #include "../vector.cpp"
+#include "../small_vector.hpp"
+#include "../simd_algorithms.hpp"
+#include "../mmap_vector.hpp"
+#include "../concurrent_segmented_vector.hpp"
+#include "../soa_vector.hpp"
+#include "../bit_vector.hpp"
+#include "../slot_map.hpp"
 
 #include <fmt/core.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <chrono>
+#include <filesystem>
 #include <future>
 #include <iostream>
 #include <string>
 #include <thread>
 #include <vector>
 #include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 
 class Singleton {
 private:
@@ -88,6 +101,47 @@ struct President {
     President& operator=(const President& other) = default;
 };
 
+struct RelocatableHandle {
+    std::unique_ptr<int> value;
+
+    explicit RelocatableHandle(int v) : value(std::make_unique<int>(v)) {
+    }
+};
+
+template <>
+struct IsTriviallyRelocatable<RelocatableHandle> : std::true_type {};
+
+struct CopyBomb {
+    static inline int copies_left = 0;
+
+    explicit CopyBomb(int v) : value(v) {
+    }
+    CopyBomb(const CopyBomb& other) : value(other.value) {
+        if (copies_left-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+    }
+
+    int value;
+};
+
+struct LiveCounter {
+    static inline int live = 0;
+
+    LiveCounter() {
+        ++live;
+    }
+    LiveCounter(const LiveCounter&) {
+        ++live;
+    }
+    LiveCounter(LiveCounter&&) noexcept {
+        ++live;
+    }
+    ~LiveCounter() {
+        --live;
+    }
+};
+
 class VectorTest : public testing::Test {
 protected:
     void SetUp() override {
@@ -252,6 +306,98 @@ TEST(EmptyVectorTest, VoidAsTemplate) {
     vec.PushBack(malloc(1));
 }
 
+TEST(PointerVectorTest, MoveAssignmentReleasesOldPointers) {
+    Vector<void*> first;
+    first.PushBack(malloc(8));
+    Vector<void*> second;
+    second.PushBack(malloc(8));
+    second.PushBack(malloc(8));
+    first = std::move(second);
+    ASSERT_EQ(first.Size(), 2);
+    ASSERT_TRUE(second.IsEmpty());
+}
+
+TEST(PointerVectorTest, ArenaOwnership) {
+    Vector<void*, ArenaOwnership> blobs(ArenaOwnership(1024));
+    for (int i = 0; i < 10000; ++i) {
+        auto* blob = static_cast<int*>(blobs.AllocateBack(sizeof(int) * (1 + i % 8), alignof(int)));
+        *blob = i;
+    }
+    ASSERT_EQ(blobs.Size(), 10000);
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_EQ(*static_cast<int*>(blobs[i]), i);
+    }
+    auto* aligned = blobs.AllocateBack(3, 64);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+    ASSERT_GT(blobs.GetOwnership().GetArena().ChunkCount(), 1);
+
+    blobs.Clear();
+    ASSERT_TRUE(blobs.IsEmpty());
+    ASSERT_EQ(blobs.GetOwnership().GetArena().ChunkCount(), 1) << "The chunks are merged for reuse";
+    blobs.AllocateBack(16);
+    ASSERT_EQ(blobs.GetOwnership().GetArena().ChunkCount(), 1);
+}
+
+TEST(PointerVectorTest, NonOwningAndDeleter) {
+    int values[3] = {1, 2, 3};
+    Vector<void*, NonOwning> view;
+    for (int& value : values) {
+        view.PushBack(&value);
+    }
+    Vector<void*, NonOwning> copy = view;
+    view.Clear();
+    ASSERT_EQ(copy.Size(), 3);
+    ASSERT_EQ(*static_cast<int*>(copy.Back()), 3);
+
+    int deleted = 0;
+    auto deleter = [&deleted](void* ptr) {
+        ++deleted;
+        delete static_cast<std::string*>(ptr);
+    };
+    {
+        Vector<void*, DeleterOwnership<decltype(deleter)>> strings(DeleterOwnership<decltype(deleter)>{deleter});
+        strings.PushBack(new std::string("a"));
+        strings.PushBack(nullptr);
+        strings.PushBack(new std::string("b"));
+    }
+    ASSERT_EQ(deleted, 2);
+}
+
+TEST(EmptyVectorTest, ReserveRelocatesTrivialTypes) {
+    Vector<int> vec;
+    for (int i = 0; i < 100000; ++i) {
+        vec.PushBack(i);
+    }
+    vec.Reserve(1 << 20);
+    ASSERT_EQ(vec.Capacity(), 1 << 20);
+    for (int i = 0; i < 100000; ++i) {
+        ASSERT_EQ(vec[i], i);
+    }
+}
+
+TEST(EmptyVectorTest, ReserveRelocatesOptedInTypes) {
+    Vector<RelocatableHandle> vec;
+    for (int i = 0; i < 1000; ++i) {
+        vec.EmplaceBack(i);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(*vec[i].value, i);
+    }  // moved-from handles are not destroyed, ASAN would report a double free
+}
+
+TEST(EmptyVectorTest, ReserveDestroysMovedFromElements) {
+    {
+        Vector<LiveCounter> vec;
+        for (int i = 0; i < 100; ++i) {
+            vec.EmplaceBack();
+        }
+        ASSERT_EQ(LiveCounter::live, 100);
+        vec.Reserve(1000);
+        ASSERT_EQ(LiveCounter::live, 100);
+    }
+    ASSERT_EQ(LiveCounter::live, 0);
+}
+
 
 TEST_F(VectorTest, CopyConstructor) {
     Vector<int> vec1 = vec;
@@ -427,7 +573,987 @@ TEST_F(VectorTest, VectorResizeLessThenCurrent) {
         ASSERT_EQ(vec[i], i + 1);
     }
 }
+TEST(EmptyVectorTest, InsertIntoEmpty) {
+    Vector<int> vec;
+    vec.Insert(0, 42);
+    ASSERT_EQ(vec.Size(), 1);
+    ASSERT_EQ(vec[0], 42);
+}
+
+TEST_F(VectorTest, AppendRange) {
+    std::vector<int> tail(1000);
+    for (size_t i = 0; i < tail.size(); ++i) {
+        tail[i] = sz + 1 + i;
+    }
+    vec.Append(tail.begin(), tail.end());
+    ASSERT_EQ(vec.Size(), sz + tail.size());
+    for (size_t i = 0; i < vec.Size(); ++i) {
+        ASSERT_EQ(vec[i], i + 1);
+    }
+}
+
+TEST_F(VectorTest, AppendInputIterators) {
+    std::istringstream in("8 9 10");
+    vec.Append(std::istream_iterator<int>(in), std::istream_iterator<int>());
+    ASSERT_EQ(vec.Size(), sz + 3);
+    ASSERT_EQ(vec.Back(), 10);
+}
+
+TEST_F(VectorTest, InsertRangeMid) {
+    std::vector<int> mid = {-1, -2, -3};
+    vec.Insert(2, mid.begin(), mid.end());
+    std::vector<int> expected = {1, 2, -1, -2, -3, 3, 4, 5, 6, 7};
+    ASSERT_EQ(vec.Size(), expected.size());
+    for (size_t i = 0; i < vec.Size(); ++i) {
+        ASSERT_EQ(vec[i], expected[i]);
+    }
+}
+
+TEST_F(VectorTest, InsertCountOfOwnElement) {
+    vec.Insert(0, 20, vec[sz - 1]);
+    ASSERT_EQ(vec.Size(), sz + 20);
+    for (size_t i = 0; i < 20; ++i) {
+        ASSERT_EQ(vec[i], 7);
+    }
+    for (size_t i = 20; i < vec.Size(); ++i) {
+        ASSERT_EQ(vec[i], i - 19);
+    }
+}
+
+TEST_F(VectorTest, EraseIf) {
+    size_t removed = vec.EraseIf([](int x) { return x % 2 == 0; });
+    ASSERT_EQ(removed, 3);
+    ASSERT_EQ(vec.Size(), sz - 3);
+    for (size_t i = 0; i < vec.Size(); ++i) {
+        ASSERT_EQ(vec[i], 2 * i + 1);
+    }
+}
+
+TEST(EmptyVectorTest, BulkOperationsOnStrings) {
+    Vector<std::string> vec;
+    vec.Reserve(20);
+    std::vector<std::string> words = {"a", "b", "c"};
+    vec.Append(words.begin(), words.end());
+    vec.Insert(1, 2, std::string("x"));  // fits into capacity
+    vec.Insert(0, 30, std::string("y"));  // reallocates
+    ASSERT_EQ(vec.Size(), 35);
+    ASSERT_EQ(vec[30], "a");
+    ASSERT_EQ(vec[31], "x");
+    ASSERT_EQ(vec[33], "b");
+    ASSERT_EQ(vec.EraseIf([](const std::string& s) { return s == "y"; }), 30);
+    vec.Erase(1, 3);
+    ASSERT_EQ(vec.Size(), 3);
+    ASSERT_EQ(vec[0], "a");
+    ASSERT_EQ(vec[1], "b");
+    ASSERT_EQ(vec[2], "c");
+}
+TEST(EmptyVectorTest, CountConstructorBuildsElements) {
+    Vector<std::string> vec(3);
+    ASSERT_EQ(vec.Size(), 3);
+    vec[1] += "abc";
+    ASSERT_EQ(vec[1], "abc");
+
+    Vector<int> zeros(5);
+    for (size_t i = 0; i < zeros.Size(); ++i) {
+        ASSERT_EQ(zeros[i], 0);
+    }
+}
+
+TEST(EmptyVectorTest, DefaultInitConstructor) {
+    Vector<std::string> strings(4, kDefaultInit);
+    ASSERT_EQ(strings.Size(), 4);
+    ASSERT_TRUE(strings[3].empty());
+
+    Vector<uint8_t> bytes(1000, kDefaultInit);
+    ASSERT_EQ(bytes.Size(), 1000);
+    bytes[999] = 7;
+    ASSERT_EQ(bytes.Back(), 7);
+}
+
+TEST_F(VectorTest, ResizeDefaultInitAndUninitialized) {
+    vec.ResizeDefaultInit(sz + 3);
+    ASSERT_EQ(vec.Size(), sz + 3);
+    vec.ResizeUninitialized(100);
+    ASSERT_EQ(vec.Size(), 100);
+    for (size_t i = 0; i < sz; ++i) {
+        ASSERT_EQ(vec[i], i + 1);
+    }
+    vec.ResizeUninitialized(2);
+    ASSERT_EQ(vec.Size(), 2);
+    ASSERT_EQ(vec.Back(), 2);
+}
+
+TEST_F(VectorTest, AppendUninitialized) {
+    int* tail = vec.AppendUninitialized(1000);
+    ASSERT_EQ(vec.Size(), sz + 1000);
+    ASSERT_EQ(tail, vec.Data() + sz);
+    for (int i = 0; i < 1000; ++i) {
+        tail[i] = i;
+    }
+    ASSERT_EQ(vec[sz - 1], sz);
+    ASSERT_EQ(vec.Back(), 999);
+}
+
+TEST(EmptyVectorTest, ResizeDestroysOnShrink) {
+    {
+        Vector<LiveCounter> vec;
+        vec.Resize(10);
+        vec.ResizeDefaultInit(20);
+        ASSERT_EQ(LiveCounter::live, 20);
+        vec.Resize(5);
+        ASSERT_EQ(LiveCounter::live, 5);
+    }
+    ASSERT_EQ(LiveCounter::live, 0);
+}
+
+TEST(EmptyVectorTest, ResizeWithOwnElement) {
+    Vector<std::string> strings;
+    strings.PushBack(std::string(50, 's'));
+    strings.Resize(1000, strings[0]);
+    ASSERT_EQ(std::count(strings.Data(), strings.Data() + strings.Size(), std::string(50, 's')), 1000);
+
+    Vector<int> ints;
+    ints.PushBack(42);
+    for (size_t count = 10; count <= 1000000; count *= 10) {
+        ints.Resize(count, ints[0]);
+    }
+    ASSERT_EQ(std::count(ints.Data(), ints.Data() + ints.Size(), 42), 1000000);
+}
+
+template <typename Policy>
+void CheckGrowthPolicy() {
+    Vector<int, std::allocator<int>, Policy> vec;
+    size_t prev_cap = 0;
+    for (int i = 0; i < 100000; ++i) {
+        vec.PushBack(i);
+        ASSERT_GE(vec.Capacity(), vec.Size());
+        ASSERT_GE(vec.Capacity(), prev_cap);
+        prev_cap = vec.Capacity();
+    }
+    for (int i = 0; i < 100000; ++i) {
+        ASSERT_EQ(vec[i], i);
+    }
+}
+
+TEST(GrowthPolicyTest, AllPoliciesKeepElements) {
+    CheckGrowthPolicy<DoublingGrowth>();
+    CheckGrowthPolicy<OneAndHalfGrowth>();
+    CheckGrowthPolicy<BucketGrowth>();
+    CheckGrowthPolicy<PageAlignedGrowth>();
+    CheckGrowthPolicy<HugePageGrowth>();
+}
+
+TEST(GrowthPolicyTest, Capacities) {
+    ASSERT_EQ(DoublingGrowth::NextCapacity(0, 1, sizeof(int)), DEFAULT_CAPACITY);
+    ASSERT_EQ(DoublingGrowth::NextCapacity(10, 11, sizeof(int)), 20);
+    ASSERT_EQ(OneAndHalfGrowth::NextCapacity(0, 1, sizeof(int)), kCacheLineSize / sizeof(int));
+    ASSERT_EQ(OneAndHalfGrowth::NextCapacity(100, 101, sizeof(int)), 150);
+    ASSERT_EQ(OneAndHalfGrowth::NextCapacity(1, 2, sizeof(int)), 2);
+    ASSERT_EQ(BucketGrowth::RoundUpToSizeClass(100), 112);
+    ASSERT_EQ(BucketGrowth::NextCapacity(20, 21, 4), 40);
+    ASSERT_EQ(BucketGrowth::NextCapacity(25, 26, 4), 56);
+    size_t cap = PageAlignedGrowth::NextCapacity(1 << 20, (1 << 20) + 1, 12);
+    ASSERT_EQ(cap * 12 / kPageSize, (cap * 12 + 11) / kPageSize);
+    ASSERT_EQ(HugePageGrowth::NextCapacity(1 << 20, (1 << 20) + 1, 4) * 4 % kHugePageSize, 0);
+}
+// Every kernel available on this machine must agree with the scalar reference
+template <typename T>
+void CheckSimdAgainstScalar() {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> value_dist(0, 20);
+    std::uniform_int_distribution<size_t> size_dist(0, 300);
+    for (int round = 0; round < 200; ++round) {
+        Vector<T> vec;
+        size_t size = size_dist(gen);
+        for (size_t i = 0; i < size; ++i) {
+            vec.PushBack(static_cast<T>(value_dist(gen)));
+        }
+        T needle = static_cast<T>(value_dist(gen));
+        for (auto level : {simd::Level::kScalar, simd::Level::kSse2, simd::Level::kAvx2}) {
+            ASSERT_EQ(simd::Find(vec.Data(), size, needle, level), simd::scalar::Find(vec.Data(), size, needle));
+            ASSERT_EQ(simd::Count(vec.Data(), size, needle, level), simd::scalar::Count(vec.Data(), size, needle));
+            ASSERT_EQ(simd::Min(vec.Data(), size, level), simd::scalar::Min(vec.Data(), size));
+            ASSERT_EQ(simd::Max(vec.Data(), size, level), simd::scalar::Max(vec.Data(), size));
+            ASSERT_EQ(simd::Sum(vec.Data(), size, level), simd::scalar::Sum(vec.Data(), size));
+        }
+    }
+}
+
+TEST(SimdTest, Int32MatchesScalar) {
+    CheckSimdAgainstScalar<int32_t>();
+}
+
+TEST(SimdTest, FloatMatchesScalar) {
+    CheckSimdAgainstScalar<float>();  // small integers keep float sums exact in any order
+}
+
+TEST(SimdTest, Uint64MatchesScalar) {
+    CheckSimdAgainstScalar<uint64_t>();
+}
+
+TEST(SimdTest, ExtremeValues) {
+    Vector<int32_t> ints = {5, -7, std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min(), 0,
+                            1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    ASSERT_EQ(simd::Min(ints), std::numeric_limits<int32_t>::min());
+    ASSERT_EQ(simd::Max(ints), std::numeric_limits<int32_t>::max());
+    ASSERT_EQ(simd::Sum(ints), simd::scalar::Sum(ints.Data(), ints.Size()));
+    ASSERT_EQ(simd::Find(ints, 0), 4);
+    ASSERT_TRUE(simd::Contains(ints, 12));
+    ASSERT_FALSE(simd::Contains(ints, 13));
+
+    Vector<uint64_t> big = {1, std::numeric_limits<uint64_t>::max(), 3, 1ull << 63, 7, 0, 9, 10, 11};
+    ASSERT_EQ(simd::Max(big), std::numeric_limits<uint64_t>::max());
+    ASSERT_EQ(simd::Min(big), 0);
+    ASSERT_EQ(simd::Count(big, 1ull << 63), 1);
+
+    Vector<float> floats(1000, 0.5f);
+    ASSERT_FLOAT_EQ(simd::Sum(floats), 500.0f);
+
+    Vector<int32_t> empty;
+    ASSERT_EQ(simd::Find(empty, 1), 0);
+    ASSERT_EQ(simd::Min(empty), std::numeric_limits<int32_t>::max());
+    ASSERT_EQ(simd::Sum(empty), 0);
+}
+
+TEST(SmallVectorTest, StaysInlineUpToN) {
+    SmallVector<int, 8> vec;
+    for (int i = 0; i < 8; ++i) {
+        vec.PushBack(i);
+    }
+    ASSERT_TRUE(vec.IsInline());
+    ASSERT_EQ(vec.Capacity(), 8);
+    vec.PushBack(8);
+    ASSERT_FALSE(vec.IsInline());
+    ASSERT_EQ(vec.Size(), 9);
+    for (int i = 0; i < 9; ++i) {
+        ASSERT_EQ(vec[i], i);
+    }
+}
+
+TEST(SmallVectorTest, InsertEraseResize) {
+    SmallVector<std::string, 4> vec;
+    vec.Insert(0, "b");
+    vec.Insert(0, "a");
+    vec.Insert(2, "d");
+    vec.Insert(2, "c");
+    vec.Insert(4, "e");
+    ASSERT_EQ(vec.Size(), 5);
+    std::string joined;
+    for (auto it = vec.Begin(); it != vec.End(); ++it) {
+        joined += *it;
+    }
+    ASSERT_EQ(joined, "abcde");
+
+    vec.Erase(1, 3);
+    ASSERT_EQ(vec.Size(), 3);
+    ASSERT_EQ(vec[1], "d");
+    vec.Resize(6, "x");
+    ASSERT_EQ(vec.Back(), "x");
+    vec.Resize(1);
+    ASSERT_EQ(vec.Size(), 1);
+    ASSERT_EQ(vec.Front(), "a");
+}
+
+TEST(SmallVectorTest, EmplaceBackOwnElementOnGrowth) {
+    SmallVector<std::string, 2> vec;
+    vec.PushBack("first");
+    vec.PushBack("second");
+    vec.PushBack(vec[0]);
+    ASSERT_EQ(vec[2], "first");
+}
+
+TEST(SmallVectorTest, ResizeWithOwnElement) {
+    SmallVector<std::string, 2> vec = {"a long string that does not fit in SSO"};
+    vec.Resize(2, vec[0]);
+    vec.Resize(10, vec[1]);
+    ASSERT_EQ(vec.Size(), 10);
+    ASSERT_FALSE(vec.IsInline());
+    ASSERT_EQ(std::count(vec.Begin(), vec.End(), vec[0]), 10);
+    vec.Resize(100, vec[9]);
+    ASSERT_EQ(vec.Back(), "a long string that does not fit in SSO");
+}
+
+TEST(SmallVectorTest, MoveInlineAndHeap) {
+    SmallVector<std::string, 4> small = {"a", "b"};
+    SmallVector<std::string, 4> moved = std::move(small);
+    ASSERT_TRUE(moved.IsInline());
+    ASSERT_EQ(moved.Size(), 2);
+    ASSERT_EQ(small.Size(), 0);
+
+    SmallVector<std::string, 4> big = {"a", "b", "c", "d", "e"};
+    const std::string* data = big.Data();
+    moved = std::move(big);
+    ASSERT_EQ(moved.Data(), data) << "Heap buffer must be stolen, not copied";
+    ASSERT_EQ(moved.Size(), 5);
+    ASSERT_TRUE(big.IsInline());
+    ASSERT_EQ(big.Size(), 0);
+}
+
+TEST(SmallVectorTest, CopyAndSwapMixedModes) {
+    SmallVector<int, 4> small = {1, 2};
+    SmallVector<int, 4> big = {1, 2, 3, 4, 5, 6};
+    SmallVector<int, 4> copy = big;
+    ASSERT_EQ(copy.Size(), 6);
+    ASSERT_NE(copy.Data(), big.Data());
+
+    small.Swap(big);
+    ASSERT_EQ(small.Size(), 6);
+    ASSERT_EQ(big.Size(), 2);
+    ASSERT_TRUE(big.IsInline());
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_EQ(small[i], i + 1);
+    }
+
+    copy = big;
+    ASSERT_EQ(copy.Size(), 2);
+    ASSERT_EQ(copy[1], 2);
+}
+
+TEST(SmallVectorTest, DestroysEveryElement) {
+    {
+        SmallVector<LiveCounter, 4> vec;
+        for (int i = 0; i < 10; ++i) {
+            vec.EmplaceBack();
+        }
+        SmallVector<LiveCounter, 4> other(3);
+        vec.Swap(other);
+        ASSERT_EQ(LiveCounter::live, 13);
+    }
+    ASSERT_EQ(LiveCounter::live, 0);
+}
+
+TEST(SmallVectorTest, CopyThrowsWithoutLeaking) {
+    CopyBomb::copies_left = 1000;
+    using BombVector = SmallVector<std::pair<std::string, CopyBomb>, 2>;
+    BombVector vec;
+    for (int i = 0; i < 10; ++i) {
+        vec.EmplaceBack(std::string(50, 'a' + i), CopyBomb(i));
+    }
+    CopyBomb::copies_left = 5;
+    ASSERT_THROW(BombVector copy(vec), std::runtime_error);
+    CopyBomb::copies_left = 4;  // three for the initializer list, the second PushBack throws
+    ASSERT_THROW((BombVector{vec[0], vec[1], vec[2]}), std::runtime_error);
+    CopyBomb::copies_left = 1000;
+    ASSERT_EQ(vec.Size(), 10);
+}
 
+std::string TempPath(const std::string& name) {
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove(path);
+    return path;
+}
+
+TEST(MmapVectorTest, PersistsAcrossReopen) {
+    std::string path = TempPath("mmap_vector_persist.bin");
+    {
+        MmapVector<int64_t> vec(path);
+        ASSERT_TRUE(vec.IsEmpty());
+        for (int64_t i = 0; i < 10000; ++i) {
+            vec.PushBack(i * 3);
+        }
+        ASSERT_GE(vec.Capacity(), 10000);
+        vec.Flush();
+    }
+    MmapVector<int64_t> vec(path, MmapMode::kReadOnly);
+    ASSERT_TRUE(vec.IsReadOnly());
+    ASSERT_EQ(vec.Size(), 10000);
+    for (int64_t i = 0; i < 10000; ++i) {
+        ASSERT_EQ(vec[i], i * 3);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(MmapVectorTest, ReserveAndResize) {
+    std::string path = TempPath("mmap_vector_resize.bin");
+    MmapVector<int> vec(path);
+    vec.Reserve(100);
+    ASSERT_EQ(vec.Capacity(), 100);
+    ASSERT_EQ(vec.Size(), 0);
+    ASSERT_EQ(std::filesystem::file_size(path), 64 + 100 * sizeof(int));
+
+    vec.Resize(5, 7);
+    vec.Resize(300, 1);
+    ASSERT_EQ(vec.Size(), 300);
+    ASSERT_EQ(vec[4], 7);
+    ASSERT_EQ(vec[5], 1);
+    ASSERT_EQ(vec.Back(), 1);
+
+    vec.Resize(2);
+    vec.PopBack();
+    ASSERT_EQ(vec.Size(), 1);
+    ASSERT_EQ(std::accumulate(vec.Begin(), vec.End(), 0), 7);
+    vec.Clear();
+    ASSERT_TRUE(vec.IsEmpty());
+    std::filesystem::remove(path);
+}
+
+TEST(MmapVectorTest, PushBackOwnElement) {
+    std::string path = TempPath("mmap_vector_self.bin");
+    MmapVector<int> vec(path);
+    vec.PushBack(42);
+    for (int i = 0; i < 100; ++i) {
+        vec.PushBack(vec.Front());
+    }
+    ASSERT_EQ(std::count(vec.Begin(), vec.End(), 42), 101);
+    vec.Resize(100000, vec[0]);
+    ASSERT_EQ(std::count(vec.Begin(), vec.End(), 42), 100000);
+    std::filesystem::remove(path);
+}
+
+TEST(MmapVectorTest, Errors) {
+    std::string path = TempPath("mmap_vector_errors.bin");
+    ASSERT_THROW(MmapVector<int>(path, MmapMode::kReadOnly), MmapVectorException);
+    {
+        MmapVector<int> vec(path);
+        vec.PushBack(1);
+    }
+    {
+        MmapVector<int> vec(path, MmapMode::kReadOnly);
+        ASSERT_THROW(vec.PushBack(2), MmapVectorException);
+        ASSERT_THROW(vec.Reserve(100), MmapVectorException);
+        ASSERT_EQ(vec.Size(), 1);
+    }
+    ASSERT_THROW(MmapVector<int64_t>{path}, MmapVectorException) << "Element size is stored in the header";
+    std::filesystem::remove(path);
+}
+
+TEST(MmapVectorTest, Move) {
+    std::string path = TempPath("mmap_vector_move.bin");
+    MmapVector<int> vec(path);
+    vec.Resize(10, 5);
+    MmapVector<int> moved = std::move(vec);
+    ASSERT_EQ(moved.Size(), 10);
+    moved.PushBack(6);
+    ASSERT_EQ(moved.Back(), 6);
+
+    ASSERT_EQ(vec.Size(), 0);
+    ASSERT_TRUE(vec.IsEmpty());
+    ASSERT_EQ(vec.Begin(), vec.End());
+    ASSERT_THROW(vec.PushBack(1), MmapVectorException);
+    ASSERT_THROW(vec.PopBack(), MmapVectorException);
+    ASSERT_THROW(vec.Clear(), MmapVectorException);
+    ASSERT_THROW(vec.Reserve(100), MmapVectorException);
+    ASSERT_THROW(vec.Flush(), MmapVectorException);
+
+    vec = std::move(moved);
+    ASSERT_EQ(vec.Size(), 11);
+    ASSERT_EQ(moved.Size(), 0);
+    std::filesystem::remove(path);
+}
+
+TEST(ConcurrentSegmentedVectorTest, ReferencesStayValid) {
+    ConcurrentSegmentedVector<int> vec;
+    ASSERT_TRUE(vec.IsEmpty());
+    ASSERT_EQ(vec.PushBack(0), 0);
+    int* first = &vec[0];
+    for (int i = 1; i < 100000; ++i) {
+        ASSERT_EQ(vec.EmplaceBack(i), static_cast<size_t>(i));
+    }
+    ASSERT_EQ(first, &vec[0]) << "Segments must never move";
+    ASSERT_EQ(vec.Size(), 100000);
+    for (int i = 0; i < 100000; ++i) {
+        ASSERT_EQ(vec[i], i);
+    }
+    ASSERT_EQ(std::accumulate(vec.begin(), vec.end(), int64_t{0}), int64_t{99999} * 100000 / 2);
+}
+
+TEST(ConcurrentSegmentedVectorTest, SegmentBoundaries) {
+    constexpr size_t kFirst = ConcurrentSegmentedVector<int64_t>::kFirstSegment;
+    ConcurrentSegmentedVector<int64_t> vec;
+    vec.Reserve(kFirst * 7);
+    for (size_t i = 0; i < kFirst * 7; ++i) {
+        vec.PushBack(static_cast<int64_t>(i));
+    }
+    for (size_t pos : {kFirst - 1, kFirst, 3 * kFirst - 1, 3 * kFirst, 7 * kFirst - 1}) {
+        ASSERT_EQ(vec[pos], static_cast<int64_t>(pos));
+        ASSERT_TRUE(vec.IsReady(pos));
+    }
+    ASSERT_FALSE(vec.IsReady(kFirst * 7));
+}
+
+TEST(ConcurrentSegmentedVectorTest, PushBetweenBeginAndEnd) {
+    struct Throwing {
+        explicit Throwing(int v) : value(v) {
+            if (v < 0) {
+                throw std::runtime_error("unpublished");
+            }
+        }
+        int value;
+    };
+    ConcurrentSegmentedVector<Throwing> vec;
+    for (int i = 0; i < 3; ++i) {
+        vec.EmplaceBack(i);
+    }
+    auto it = vec.begin();
+    ASSERT_THROW(vec.EmplaceBack(-1), std::runtime_error);
+    for (int i = 0; i < 1000; ++i) {
+        vec.EmplaceBack(i);
+    }
+    auto end = vec.end();
+    int visited = 0;
+    for (; it != end; ++it) {
+        ASSERT_EQ(it->value, visited);
+        ++visited;
+    }
+    ASSERT_EQ(visited, 3) << "Only the elements seen by begin() are visited";
+    ASSERT_EQ(std::distance(vec.begin(), vec.end()), 1003) << "The unpublished slot is skipped";
+}
+
+TEST(ConcurrentSegmentedVectorTest, ConcurrentProducersAndReader) {
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 50000;
+    ConcurrentSegmentedVector<int64_t> vec;
+    std::atomic<bool> done = false;
+    std::thread reader([&] {
+        while (!done.load()) {
+            for (int64_t value : vec) {
+                ASSERT_GE(value, 0);
+                ASSERT_LT(value, kThreads * kPerThread);
+            }
+        }
+    });
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([&vec, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                size_t index = vec.PushBack(int64_t{t} * kPerThread + i);
+                ASSERT_EQ(vec[index], int64_t{t} * kPerThread + i);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    done = true;
+    reader.join();
+
+    ASSERT_EQ(vec.Size(), kThreads * kPerThread);
+    std::vector<bool> seen(kThreads * kPerThread);
+    for (int64_t value : vec) {
+        ASSERT_FALSE(seen[value]);
+        seen[value] = true;
+    }
+    ASSERT_EQ(std::count(seen.begin(), seen.end(), true), kThreads * kPerThread);
+}
+
+TEST(ConcurrentSegmentedVectorTest, DestroysEveryElement) {
+    {
+        ConcurrentSegmentedVector<LiveCounter> vec;
+        for (int i = 0; i < 1000; ++i) {
+            vec.EmplaceBack();
+        }
+        ASSERT_EQ(LiveCounter::live, 1000);
+        vec.Clear();
+        ASSERT_EQ(LiveCounter::live, 0);
+        ASSERT_TRUE(vec.IsEmpty());
+        vec.EmplaceBack();
+        ASSERT_EQ(std::distance(vec.begin(), vec.end()), 1);
+    }
+    ASSERT_EQ(LiveCounter::live, 0);
+}
+
+TEST(SoAVectorTest, ColumnsShareSize) {
+    SoAVector<int, double, std::string> vec;
+    ASSERT_TRUE(vec.IsEmpty());
+    for (int i = 0; i < 100; ++i) {
+        vec.EmplaceBack(i, i * 0.5, std::to_string(i));
+    }
+    vec.PushBack({100, 50.0, "100"});
+    ASSERT_EQ(vec.Size(), 101);
+    ASSERT_GE(vec.Capacity(), 101);
+
+    auto ids = vec.Column<0>();
+    auto prices = vec.Column<1>();
+    ASSERT_EQ(ids.size(), 101);
+    ASSERT_EQ(std::accumulate(ids.begin(), ids.end(), 0), 5050);
+    ASSERT_EQ(std::accumulate(prices.begin(), prices.end(), 0.0), 2525.0);
+    ASSERT_EQ(std::get<2>(vec[42]), "42");
+
+    auto [id, price, name] = vec.Back();
+    id = -1;
+    name += "!";
+    ASSERT_EQ(vec.Column<0>().back(), -1);
+    ASSERT_EQ(std::get<2>(vec[100]), "100!");
+    ASSERT_EQ(price, 50.0);
+
+    vec.PopBack();
+    ASSERT_EQ(vec.Size(), 100);
+}
+
+TEST(SoAVectorTest, PopBackEmpty) {
+    SoAVector<int, std::string> vec;
+    vec.PopBack();
+    ASSERT_TRUE(vec.IsEmpty());
+    vec.EmplaceBack(1, "one");
+    vec.PopBack();
+    vec.PopBack();
+    ASSERT_EQ(vec.Size(), 0);
+    vec.EmplaceBack(2, "two");
+    ASSERT_EQ(vec.Size(), 1);
+    ASSERT_EQ(std::get<1>(vec[0]), "two");
+}
+
+TEST(SoAVectorTest, ZipIterator) {
+    SoAVector<int, char> vec = {{3, 'c'}, {1, 'a'}, {2, 'b'}};
+    int count = 0;
+    for (auto [number, letter] : vec) {
+        ASSERT_EQ(letter - 'a' + 1, number);
+        letter = 'z';
+        ++count;
+    }
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(vec.End() - vec.Begin(), 3);
+    ASSERT_EQ(std::get<1>(vec.Begin()[2]), 'z');
+    static_assert(std::random_access_iterator<SoAVector<int, char>::Iterator>);
+
+    const auto& cref = vec;
+    auto it = std::find_if(cref.begin(), cref.end(), [](auto row) { return std::get<0>(row) == 1; });
+    ASSERT_EQ(it - cref.begin(), 1);
+}
+
+TEST(SoAVectorTest, ReserveResizeAndCopy) {
+    SoAVector<int64_t, std::string> vec;
+    vec.Reserve(50);
+    ASSERT_EQ(vec.Capacity(), 50);
+    vec.Resize(10, {7, "seven"});
+    vec.Resize(20);
+    ASSERT_EQ(vec.Size(), 20);
+    ASSERT_EQ(std::get<1>(vec[9]), "seven");
+    ASSERT_EQ(std::get<1>(vec[10]), "");
+    ASSERT_EQ(vec.Capacity(), 50);
+
+    SoAVector<int64_t, std::string> copy = vec;
+    vec.Resize(5);
+    ASSERT_EQ(copy.Size(), 20);
+    ASSERT_EQ(std::get<0>(copy[0]), 7);
+
+    SoAVector<int64_t, std::string> moved = std::move(copy);
+    ASSERT_EQ(moved.Size(), 20);
+    ASSERT_EQ(copy.Size(), 0);
+    copy = moved;
+    ASSERT_EQ(copy.Size(), 20);
+    moved.Clear();
+    ASSERT_TRUE(moved.IsEmpty());
+}
+
+TEST(SoAVectorTest, PushBackOwnRowWhileGrowing) {
+    SoAVector<std::string, int> vec;
+    vec.EmplaceBack(std::string(100, 'x'), 1);
+    for (int i = 0; i < 40; ++i) {
+        vec.EmplaceBack(std::get<0>(vec[0]), std::get<1>(vec[0]));
+    }
+    ASSERT_EQ(std::get<0>(vec[40]), std::string(100, 'x'));
+    ASSERT_EQ(std::accumulate(vec.Column<1>().begin(), vec.Column<1>().end(), 0), 41);
+}
+
+// Copy constructor that fails after a set number of copies; without a noexcept move it is
+// what move_if_noexcept picks
+TEST(SoAVectorTest, FailedGrowthKeepsEveryColumn) {
+    SoAVector<RelocatableHandle, std::string, CopyBomb> vec;
+    CopyBomb::copies_left = 1000;
+    for (int i = 0; i < 10; ++i) {
+        vec.EmplaceBack(RelocatableHandle(i), std::string(50, 'a' + i), CopyBomb(i));
+    }
+    auto check = [&vec] {
+        ASSERT_EQ(vec.Size(), 10);
+        for (int i = 0; i < 10; ++i) {
+            auto [handle, name, bomb] = vec[i];
+            ASSERT_EQ(*handle.value, i);
+            ASSERT_EQ(name, std::string(50, 'a' + i));
+            ASSERT_EQ(bomb.value, i);
+        }
+    };
+    CopyBomb::copies_left = 5;
+    ASSERT_THROW(vec.Reserve(100), std::runtime_error);
+    check();
+    ASSERT_EQ(vec.Capacity(), 10);
+
+    CopyBomb::copies_left = 5;
+    ASSERT_THROW(vec.EmplaceBack(RelocatableHandle(10), "new", CopyBomb(10)), std::runtime_error);
+    check();
+
+    CopyBomb::copies_left = 1000;
+    vec.Reserve(100);
+    check();
+}
+
+TEST(SoAVectorTest, DestroysEveryElement) {
+    {
+        SoAVector<LiveCounter, int, LiveCounter> vec;
+        for (int i = 0; i < 100; ++i) {
+            vec.EmplaceBack(LiveCounter(), i, LiveCounter());
+        }
+        ASSERT_EQ(LiveCounter::live, 200);
+        vec.Resize(10);
+        ASSERT_EQ(LiveCounter::live, 20);
+    }
+    ASSERT_EQ(LiveCounter::live, 0);
+}
+
+TEST(BitVectorTest, PackedStorage) {
+    Vector<bool> bits;
+    ASSERT_TRUE(bits.IsEmpty());
+    for (int i = 0; i < 1000; ++i) {
+        bits.PushBack(i % 3 == 0);
+    }
+    ASSERT_EQ(bits.Size(), 1000);
+    ASSERT_EQ(bits.WordCount(), 16);
+    ASSERT_EQ(bits.Capacity() % 64, 0);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(bits[i], i % 3 == 0);
+    }
+    ASSERT_EQ(bits.Count(), 334);
+
+    bits[1] = true;
+    bits.Flip(0);
+    bits.Set(2);
+    bits.Reset(3);
+    ASSERT_FALSE(bits.Front());
+    ASSERT_TRUE(bits[1] && bits[2] && !bits[3]);
+    bits[4] = bits[2];
+    ASSERT_TRUE(bits.Test(4));
+
+    bits.PopBack();
+    ASSERT_FALSE(bits.Back());
+    bits.Resize(64);
+    ASSERT_EQ(bits.Count(), static_cast<size_t>(std::count(bits.begin(), bits.end(), true)));
+}
+
+TEST(BitVectorTest, PopBackEmpty) {
+    Vector<bool> bits;
+    bits.PopBack();
+    ASSERT_TRUE(bits.IsEmpty());
+    bits.PushBack(true);
+    bits.PopBack();
+    bits.PopBack();
+    ASSERT_EQ(bits.Size(), 0);
+    bits.PushBack(false);
+    ASSERT_EQ(bits.Count(), 0);
+}
+
+TEST(BitVectorTest, FindFirst) {
+    Vector<bool> bits(1000);
+    ASSERT_EQ(bits.FindFirstSet(), 1000);
+    ASSERT_EQ(bits.FindFirstUnset(), 0);
+    bits.Set(700);
+    bits.Set(999);
+    ASSERT_EQ(bits.FindFirstSet(), 700);
+    ASSERT_EQ(bits.FindFirstSet(700), 700);
+    ASSERT_EQ(bits.FindFirstSet(701), 999);
+    ASSERT_EQ(bits.FindFirstSet(1000), 1000);
+
+    Vector<bool> full(1000, true);
+    ASSERT_EQ(full.Count(), 1000);
+    ASSERT_EQ(full.FindFirstUnset(), 1000) << "Padding past Size() must not be reported";
+    full.Reset(130);
+    ASSERT_EQ(full.FindFirstUnset(), 130);
+    ASSERT_EQ(full.FindFirstUnset(131), 1000);
+}
+
+TEST(BitVectorTest, Ranges) {
+    for (size_t first : {0, 5, 63, 64, 100}) {
+        for (size_t last : {first, first + 1, size_t{64}, size_t{128}, size_t{199}, size_t{300}}) {
+            if (last < first) {
+                continue;
+            }
+            Vector<bool> bits(300);
+            bits.SetRange(first, last);
+            ASSERT_EQ(bits.Count(), last - first);
+            ASSERT_EQ(bits.FindFirstSet(), last > first ? first : 300);
+            bits.ClearRange(first + (last - first) / 2, last);
+            ASSERT_EQ(bits.Count(), (last - first) / 2);
+        }
+    }
+    Vector<bool> bits(200, true);
+    bits.Resize(70);
+    bits.Resize(200);
+    ASSERT_EQ(bits.Count(), 70) << "Shrinking must clear the dropped bits";
+    bits.Resize(300, true);
+    ASSERT_EQ(bits.Count(), 170);
+}
+
+TEST(BitVectorTest, BitwiseOps) {
+    Vector<bool> a(1000);
+    Vector<bool> b(1000);
+    for (int i = 0; i < 1000; ++i) {
+        a[i] = i % 2 == 0;
+        b[i] = i % 3 == 0;
+    }
+    ASSERT_EQ((a & b).Count(), 167);
+    ASSERT_EQ((a | b).Count(), 667);
+    ASSERT_EQ((a ^ b).Count(), 500);
+    Vector<bool> c = a;
+    ASSERT_TRUE(c == a);
+    c ^= a;
+    ASSERT_EQ(c.Count(), 0);
+    ASSERT_TRUE(c == Vector<bool>(1000));
+    ASSERT_FALSE(c == Vector<bool>(999));
+
+    for (auto level : {simd::Level::kScalar, simd::Level::kAvx2}) {
+        ASSERT_EQ(simd::PopCount(a.Data(), a.WordCount(), level), 500);
+        ASSERT_EQ(simd::FindWord(a.Data(), a.WordCount(), a.Data()[0], level), 15) << "Last word is partial";
+        Vector<bool> d = a;
+        simd::BitwiseApply(d.Data(), b.Data(), d.WordCount(), simd::BitOp::kOr, level);
+        ASSERT_TRUE(d == (a | b));
+    }
+}
+
+struct ThrowOnCopy {
+    static inline std::atomic<int> live = 0;
+    static inline std::atomic<int> copies_left = 1 << 30;
+
+    explicit ThrowOnCopy(int v) : value(v) {
+        ++live;
+    }
+    ThrowOnCopy(const ThrowOnCopy& other) : value(other.value) {
+        if (--copies_left < 0) {
+            throw std::runtime_error("copy failed");
+        }
+        ++live;
+    }
+    ~ThrowOnCopy() {
+        --live;
+    }
+
+    int value;
+};
+
+TEST(ParallelVectorTest, CopyResizeAssign) {
+    ThreadPool pool(3);
+    ParallelTag par{&pool, 64};
+
+    Vector<int64_t> source;
+    for (int64_t i = 0; i < 100003; ++i) {
+        source.PushBack(i * 7);
+    }
+    Vector<int64_t> copy(par, source);
+    ASSERT_EQ(copy.Size(), source.Size());
+    ASSERT_TRUE(std::equal(source.Data(), source.Data() + source.Size(), copy.Data()));
+
+    copy.Resize(par, 200000, -1);
+    ASSERT_EQ(copy.Size(), 200000);
+    ASSERT_EQ(copy[100002], 100002 * 7);
+    ASSERT_EQ(std::count(copy.Data(), copy.Data() + copy.Size(), -1), 200000 - 100003);
+    copy.Resize(par, 10, 5);
+    ASSERT_EQ(copy.Size(), 10);
+
+    std::vector<int64_t> values(54321);
+    std::iota(values.begin(), values.end(), 0);
+    copy.Assign(par, values.begin(), values.end());
+    ASSERT_EQ(copy.Size(), values.size());
+    ASSERT_TRUE(std::equal(values.begin(), values.end(), copy.Data()));
+
+    Vector<std::string> strings(1000, std::string(40, 's'));
+    Vector<std::string> strings_copy(kParallel, strings);
+    ASSERT_EQ(strings_copy.Size(), 1000);
+    ASSERT_EQ(strings_copy[999], std::string(40, 's'));
+
+    strings_copy.Resize(par, 100000, strings_copy[0]);
+    ASSERT_EQ(std::count(strings_copy.Data(), strings_copy.Data() + strings_copy.Size(), std::string(40, 's')),
+              100000);
+    copy.Resize(par, 1000000, copy[1]);
+    ASSERT_EQ(std::count(copy.Data() + values.size(), copy.Data() + copy.Size(), 1), 1000000 - values.size());
+}
+
+TEST(ParallelVectorTest, RollsBackOnFailure) {
+    ThreadPool pool(3);
+    ParallelTag par{&pool, 64};
+    {
+        Vector<ThrowOnCopy> source;
+        source.Reserve(10000);
+        for (int i = 0; i < 10000; ++i) {
+            source.EmplaceBack(i);
+        }
+        ThrowOnCopy::copies_left = 7000;
+        ASSERT_THROW(Vector<ThrowOnCopy>(par, source), std::runtime_error);
+        ASSERT_EQ(ThrowOnCopy::live, 10000);
+
+        ThrowOnCopy::copies_left = 7000;
+        ASSERT_THROW(source.Resize(par, 20000, ThrowOnCopy(1)), std::runtime_error);
+        ASSERT_EQ(source.Size(), 10000);
+        ASSERT_EQ(ThrowOnCopy::live, 10000);
+
+        ThrowOnCopy::copies_left = 1 << 30;
+        source.Resize(par, 20000, ThrowOnCopy(1));
+        ASSERT_EQ(ThrowOnCopy::live, 20000);
+    }
+    ASSERT_EQ(ThrowOnCopy::live, 0);
+}
+
+TEST(SlotMapTest, HandlesSurviveErase) {
+    SlotMap<std::string> map;
+    ASSERT_TRUE(map.IsEmpty());
+    std::vector<SlotHandle> handles;
+    for (int i = 0; i < 100; ++i) {
+        handles.push_back(map.Insert(std::to_string(i)));
+    }
+    for (int i = 0; i < 100; i += 3) {
+        ASSERT_TRUE(map.Erase(handles[i]));
+        ASSERT_FALSE(map.Erase(handles[i])) << "Second erase of the same handle";
+    }
+    ASSERT_EQ(map.Size(), 66);
+    for (int i = 0; i < 100; ++i) {
+        if (i % 3 == 0) {
+            ASSERT_FALSE(map.Contains(handles[i]));
+            ASSERT_EQ(map.Find(handles[i]), nullptr);
+        } else {
+            ASSERT_EQ(map[handles[i]], std::to_string(i));
+        }
+    }
+    ASSERT_FALSE(map.Contains(SlotHandle{}));
+}
+
+TEST(SlotMapTest, ReusedSlotsGetNewGeneration) {
+    SlotMap<int> map;
+    SlotHandle first = map.Insert(1);
+    map.Erase(first);
+    SlotHandle second = map.Insert(2);
+    ASSERT_EQ(first.index, second.index) << "Freed slot is reused";
+    ASSERT_NE(first, second);
+    ASSERT_FALSE(map.Contains(first));
+    ASSERT_EQ(*map.Find(second), 2);
+
+    map.Clear();
+    ASSERT_FALSE(map.Contains(second));
+    SlotHandle third = map.Emplace(3);
+    ASSERT_EQ(third.index, second.index);
+    ASSERT_EQ(map.Size(), 1);
+}
+
+TEST(SlotMapTest, DenseIteration) {
+    SlotMap<int> map;
+    std::vector<SlotHandle> handles;
+    for (int i = 0; i < 1000; ++i) {
+        handles.push_back(map.Insert(i));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        map.Erase(handles[i]);
+    }
+    ASSERT_EQ(map.End() - map.Begin(), 500);
+    int64_t sum = 0;
+    for (int value : map) {
+        ASSERT_EQ(value % 2, 1);
+        sum += value;
+    }
+    ASSERT_EQ(sum, 250000);
+    for (size_t pos = 0; pos < map.Size(); ++pos) {
+        ASSERT_EQ(map.Find(map.HandleAt(pos)), map.Data() + pos);
+    }
+}
+
+TEST(SlotMapTest, ThrowingInsertKeepsMapIntact) {
+    SlotMap<ThrowOnCopy> map;
+    ThrowOnCopy value(5);
+    SlotHandle kept = map.Insert(value);
+    ThrowOnCopy::copies_left = 0;
+    ASSERT_THROW(map.Insert(value), std::runtime_error);
+    ThrowOnCopy::copies_left = 1 << 30;
+    ASSERT_EQ(map.Size(), 1);
+    SlotHandle next = map.Insert(value);
+    ASSERT_EQ(map.Find(next)->value, 5);
+    ASSERT_EQ(map.Find(kept)->value, 5);
+    ASSERT_EQ(map.Size(), 2);
+}
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -1,13 +1,37 @@
 #pragma once
 
+#include <algorithm>
 #include <compare>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <initializer_list>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
-const size_t DEFAULT_CAPACITY = 10;
+#include "growth_policy.hpp"
+#include "parallel.hpp"
+#include "pointer_ownership.hpp"
 
-template <typename T, typename Alloc = std::allocator<T>>
+// T can be moved to a new address with memcpy, and the old bytes need no destructor call.
+// Specialize for own types (e.g. ones holding a unique_ptr) to get the bulk relocation path.
+template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool kIsTriviallyRelocatable = IsTriviallyRelocatable<T>::value;
+
+// Selects the constructor that default-initializes elements (trivial types stay uninitialized)
+struct DefaultInitTag {
+    explicit DefaultInitTag() = default;
+};
+
+inline constexpr DefaultInitTag kDefaultInit{};
+
+template <typename T, typename Alloc = std::allocator<T>, typename GrowthPolicy = DoublingGrowth>
 class Vector {
 private:
     friend class VectorIterator;
@@ -89,31 +113,55 @@ private:
 
 public:
     Vector(){};
-    explicit Vector(size_t count) {
-        this->Reserve(count > DEFAULT_CAPACITY ? count : DEFAULT_CAPACITY);
-        size_ = count;
+
+    // For stateful allocators, e.g. ArenaAllocator<T>(arena)
+    explicit Vector(const Alloc& alloc) : alloc_(alloc) {
     }
 
-    Vector(size_t count, const T& value) : Vector(count) {
-        for (size_t i = 0; i < count; ++i) {
-            AllocTraits::construct(alloc_, arr_ + i, value);
+    // Delegate to Vector() so that the destructor cleans up if an element constructor throws
+    explicit Vector(size_t count) : Vector() {
+        this->Reserve(GrowthPolicy::NextCapacity(0, count, sizeof(T)));
+        for (; size_ < count; ++size_) {
+            AllocTraits::construct(alloc_, arr_ + size_);
         }
     }
 
-    Vector(const Vector& other) : Vector(other.size_) {
+    Vector(size_t count, DefaultInitTag) : Vector() {
+        this->Reserve(GrowthPolicy::NextCapacity(0, count, sizeof(T)));
+        this->DefaultConstructTail(count);
+    }
+
+    Vector(size_t count, const T& value) : Vector() {
+        this->Reserve(GrowthPolicy::NextCapacity(0, count, sizeof(T)));
+        for (; size_ < count; ++size_) {
+            AllocTraits::construct(alloc_, arr_ + size_, value);
+        }
+    }
+
+    Vector(const Vector& other) : Vector() {
         alloc_ = AllocTraits::select_on_container_copy_construction(other.alloc_);
-        for (size_t i = 0; i < other.size_; ++i) {
-            AllocTraits::construct(alloc_, arr_ + i, other.arr_[i]);
+        this->Reserve(GrowthPolicy::NextCapacity(0, other.size_, sizeof(T)));
+        for (; size_ < other.size_; ++size_) {
+            AllocTraits::construct(alloc_, arr_ + size_, other.arr_[size_]);
         }
     }
 
+    // Copies chunks of other on par's thread pool
+    Vector(const ParallelTag& par, const Vector& other) : Vector() {
+        alloc_ = AllocTraits::select_on_container_copy_construction(other.alloc_);
+        this->Reserve(GrowthPolicy::NextCapacity(0, other.size_, sizeof(T)));
+        this->ParallelConstructTail(par, other.size_,
+                                    [this, &other](size_t i) { AllocTraits::construct(alloc_, arr_ + i, other.arr_[i]); });
+    }
+
     Vector& operator=(const Vector& other) {
         if (this == &other) {
             return *this;
         }
         Alloc new_alloc = AllocTraits::propagate_on_container_copy_assignment::value ? other.alloc_ : alloc_;
         size_t i = 0;
-        T* new_arr = AllocTraits::allocate(new_alloc, other.cap_ > DEFAULT_CAPACITY ? other.cap_ : DEFAULT_CAPACITY);
+        size_t new_cap = AssignCapacity(other);
+        T* new_arr = new_cap > 0 ? AllocateBuffer(new_alloc, new_cap) : nullptr;
         try {
             for (; i < other.size_; ++i) {
                 AllocTraits::construct(new_alloc, new_arr + i, other.arr_[i]);
@@ -122,25 +170,25 @@ public:
             for (size_t j = 0; j < i; ++j) {
                 AllocTraits::destroy(new_alloc, new_arr + j);
             }
-            AllocTraits::deallocate(new_alloc, new_arr, other.cap_ > DEFAULT_CAPACITY ? other.cap_ : DEFAULT_CAPACITY);
+            DeallocateBuffer(new_alloc, new_arr, new_cap);
             throw;
         }
         for (size_t i = 0; i < size_; ++i) {
             AllocTraits::destroy(alloc_, arr_ + i);
         }
-        AllocTraits::deallocate(alloc_, arr_, cap_);
+        DeallocateBuffer(alloc_, arr_, cap_);
 
         arr_ = new_arr;
         size_ = other.size_;
-        cap_ = other.cap_;
+        cap_ = new_cap;
         alloc_ = new_alloc;  // no throw
 
         return *this;
     }
 
-    Vector(Vector&& other) noexcept {
+    // The buffer moves together with the allocator that owns it
+    Vector(Vector&& other) noexcept : alloc_(std::move(other.alloc_)) {
         this->Clear();
-        alloc_ = AllocTraits::select_on_container_copy_construction(other.alloc_);
         std::swap(arr_, other.arr_);
         std::swap(cap_, other.cap_);
         std::swap(size_, other.size_);
@@ -153,7 +201,8 @@ public:
             return *this;
         }
         Alloc new_alloc = AllocTraits::propagate_on_container_move_assignment::value ? other.alloc_ : alloc_;
-        T* new_arr = AllocTraits::allocate(new_alloc, other.cap_ > DEFAULT_CAPACITY ? other.cap_ : DEFAULT_CAPACITY);
+        size_t new_cap = AssignCapacity(other);
+        T* new_arr = new_cap > 0 ? AllocateBuffer(new_alloc, new_cap) : nullptr;
         size_t i = 0;
         try {
             for (; i < other.size_; ++i) {
@@ -163,22 +212,23 @@ public:
             for (size_t j = 0; j < i; ++j) {
                 AllocTraits::destroy(new_alloc, new_arr + j);
             }
-            AllocTraits::deallocate(new_alloc, new_arr, other.cap_ > DEFAULT_CAPACITY ? other.cap_ : DEFAULT_CAPACITY);
+            DeallocateBuffer(new_alloc, new_arr, new_cap);
             throw;
         }
         for (size_t i = 0; i < size_; ++i) {
             AllocTraits::destroy(alloc_, arr_ + i);
         }
-        AllocTraits::deallocate(alloc_, arr_, cap_);
+        DeallocateBuffer(alloc_, arr_, cap_);
         arr_ = new_arr;
-        cap_ = other.cap_;
+        cap_ = new_cap;
         size_ = other.size_;
+        alloc_ = new_alloc;  // no throw
         other.Clear();
         return *this;
     }
 
     Vector(std::initializer_list<T> init) {
-        this->Reserve(init.size() > DEFAULT_CAPACITY ? init.size() : DEFAULT_CAPACITY);
+        this->Reserve(GrowthPolicy::NextCapacity(0, init.size(), sizeof(T)));
         for (auto&& elem : init) {
             this->PushBack(elem);
         }
@@ -224,25 +274,45 @@ public:
         if (new_cap <= cap_) {
             return;
         }
-        T* new_arr = AllocTraits::allocate(alloc_, new_cap);
-
-        size_t i = 0;
+        if constexpr (kUseRealloc) {
+            // big blocks are remapped in place by the C allocator, nothing is copied
+            T* new_arr = static_cast<T*>(std::realloc(static_cast<void*>(arr_), new_cap * sizeof(T)));
+            if (new_arr == nullptr) {
+                throw std::bad_alloc();
+            }
+            arr_ = new_arr;
+            cap_ = new_cap;
+            this->OnNewBuffer();
+            return;
+        }
+        T* new_arr = AllocateBuffer(alloc_, new_cap);
 
-        try {
-            for (; i < size_; ++i) {
-                // new (newarr + i) T(arr[i]);+++
-                AllocTraits::construct(alloc_, new_arr + i, std::move_if_noexcept(arr_[i]));
+        if constexpr (kIsTriviallyRelocatable<T>) {
+            if (size_ > 0) {
+                std::memcpy(static_cast<void*>(new_arr), static_cast<const void*>(arr_), size_ * sizeof(T));
             }
-        } catch (...) {
-            for (size_t j = 0; j < i; ++j) {
-                AllocTraits::destroy(alloc_, new_arr + j);
+        } else {
+            size_t i = 0;
+
+            try {
+                for (; i < size_; ++i) {
+                    AllocTraits::construct(alloc_, new_arr + i, std::move_if_noexcept(arr_[i]));
+                }
+            } catch (...) {
+                for (size_t j = 0; j < i; ++j) {
+                    AllocTraits::destroy(alloc_, new_arr + j);
+                }
+                DeallocateBuffer(alloc_, new_arr, new_cap);
+                throw;
+            }
+            for (size_t j = 0; j < size_; ++j) {
+                AllocTraits::destroy(alloc_, arr_ + j);
             }
-            AllocTraits::deallocate(alloc_, new_arr, new_cap);
-            throw;
         }
-        AllocTraits::deallocate(alloc_, arr_, cap_);
+        DeallocateBuffer(alloc_, arr_, cap_);
         arr_ = new_arr;
         cap_ = new_cap;
+        this->OnNewBuffer();
     }
 
     void Clear() noexcept {
@@ -256,36 +326,90 @@ public:
     }
 
     void Insert(size_t pos, T value) {  // insert before pos
-        if (pos > size_ + 1) {
+        if (pos > size_) {
             return;
         }
-        if (pos < 0) {
+        this->InsertWith(pos, 1, [&](T* dst) { AllocTraits::construct(alloc_, dst, std::move(value)); });
+    }
+
+    void Insert(size_t pos, size_t count, const T& value) {
+        if (pos > size_ || count == 0) {
             return;
         }
-        if (size_ + 1 > cap_) {
-            this->Reserve(size_ * 2);
+        T copy(value);  // value may point into the shifted tail
+        this->InsertWith(pos, count, [&](T* dst) { AllocTraits::construct(alloc_, dst, copy); });
+    }
+
+    template <std::input_iterator InputIt>
+    void Insert(size_t pos, InputIt first, InputIt last) {
+        if (pos > size_) {
+            return;
         }
-        for (size_t i = size_; i > pos; --i) {
-            arr_[i] = arr_[i - 1];
+        if constexpr (std::forward_iterator<InputIt>) {
+            size_t count = std::distance(first, last);
+            this->InsertWith(pos, count, [&](T* dst) {
+                AllocTraits::construct(alloc_, dst, *first);
+                ++first;
+            });
+        } else {
+            size_t old_size = size_;
+            this->Append(first, last);
+            std::rotate(arr_ + pos, arr_ + old_size, arr_ + size_);
+        }
+    }
+
+    template <std::input_iterator InputIt>
+    void Append(InputIt first, InputIt last) {
+        if constexpr (std::forward_iterator<InputIt>) {
+            this->Insert(size_, first, last);
+        } else {
+            for (; first != last; ++first) {
+                this->EmplaceBack(*first);
+            }
         }
-        ++size_;
-        arr_[pos] = value;
     }
 
     void Erase(size_t begin_pos, size_t end_pos) {
-        size_t num_to_erase = end_pos - begin_pos;
-        if (num_to_erase <= 0) {
+        if (begin_pos >= end_pos || end_pos > size_) {
             return;
         }
-        if (begin_pos > size_ || end_pos > size_) {
-            return;
-        }
-        for (size_t i = begin_pos; i < size_ - num_to_erase; ++i) {
-            arr_[i] = arr_[i + num_to_erase];
+        size_t num_to_erase = end_pos - begin_pos;
+        if constexpr (kIsTriviallyRelocatable<T>) {
+            for (size_t i = begin_pos; i < end_pos; ++i) {
+                AllocTraits::destroy(alloc_, arr_ + i);
+            }
+            std::memmove(static_cast<void*>(arr_ + begin_pos), static_cast<const void*>(arr_ + end_pos),
+                         (size_ - end_pos) * sizeof(T));
+        } else {
+            std::move(arr_ + end_pos, arr_ + size_, arr_ + begin_pos);
+            for (size_t i = size_ - num_to_erase; i < size_; ++i) {
+                AllocTraits::destroy(alloc_, arr_ + i);
+            }
         }
         size_ -= num_to_erase;
     }
 
+    // Removes every element matching pred in one compaction pass, returns the number removed
+    template <class Pred>
+    size_t EraseIf(Pred pred) {
+        size_t kept = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            if (pred(arr_[i])) {
+                continue;
+            }
+            if (kept != i) {
+                arr_[kept] = std::move(arr_[i]);
+            }
+            ++kept;
+        }
+        size_t removed = size_ - kept;
+        for (size_t i = kept; i < size_; ++i) {
+            AllocTraits::destroy(alloc_, arr_ + i);
+        }
+        size_ = kept;
+        return removed;
+    }
+
     void PushBack(const T& value) {
         this->EmplaceBack(value);
     }
@@ -297,9 +421,13 @@ public:
     template <class... Args>  // переменное количество шаблонных аргументов
     void EmplaceBack(Args&&... args) {
         if (cap_ == size_) {
-            Reserve(cap_ > 0 ? cap_ * 2 : DEFAULT_CAPACITY);
+            // args may refer to an element of this vector, build the value before relocating
+            T tmp(std::forward<Args>(args)...);
+            Reserve(NextCapacity(size_ + 1));
+            AllocTraits::construct(alloc_, arr_ + size_, std::move(tmp));
+        } else {
+            AllocTraits::construct(alloc_, arr_ + size_, std::forward<Args>(args)...);
         }
-        AllocTraits::construct(alloc_, arr_ + size_, std::forward<Args>(args)...);
         ++size_;
     }
 
@@ -309,52 +437,358 @@ public:
         }
     }
 
-    void Resize(size_t count, const T& value = T()) {
+    void Resize(size_t count) {
+        if (this->ShrinkOrReserve(count)) {
+            for (; size_ < count; ++size_) {
+                AllocTraits::construct(alloc_, arr_ + size_);
+            }
+        }
+    }
+
+    void Resize(size_t count, const T& value) {
         if (count > cap_) {
+            T copy(value);  // value may point into the buffer that Reserve releases
             this->Reserve(count);
+            this->Resize(count, copy);
+            return;
         }
-        for (size_t i = size_; i < count; ++i) {
-            AllocTraits::construct(alloc_, arr_ + i, value);
+        if (this->ShrinkOrReserve(count)) {
+            for (; size_ < count; ++size_) {
+                AllocTraits::construct(alloc_, arr_ + size_, value);
+            }
         }
-        size_ = count;
+    }
+
+    // Constructs the new elements on par's thread pool; if one throws, all of them are destroyed again
+    void Resize(const ParallelTag& par, size_t count, const T& value) {
+        if (count > cap_) {
+            T copy(value);  // value may point into the buffer that Reserve releases
+            this->Reserve(count);
+            this->Resize(par, count, copy);
+            return;
+        }
+        if (this->ShrinkOrReserve(count)) {
+            this->ParallelConstructTail(par, count, [this, &value](size_t i) {
+                AllocTraits::construct(alloc_, arr_ + i, value);
+            });
+        }
+    }
+
+    template <std::input_iterator It>
+    void Assign(It first, It last) {
+        this->Clear();
+        this->Append(first, last);
+    }
+
+    // [first, last) must not point into this vector
+    template <std::random_access_iterator It>
+    void Assign(const ParallelTag& par, It first, It last) {
+        this->Clear();
+        size_t count = static_cast<size_t>(last - first);
+        this->Reserve(count);
+        this->ParallelConstructTail(par, count, [this, first](size_t i) {
+            AllocTraits::construct(alloc_, arr_ + i, first[static_cast<std::iter_difference_t<It>>(i)]);
+        });
+    }
+
+    // Like Resize, but new elements are default-initialized: no zero fill for trivial types
+    void ResizeDefaultInit(size_t count) {
+        if (this->ShrinkOrReserve(count)) {
+            this->DefaultConstructTail(count);
+        }
+    }
+
+    // Grows without touching the new elements; only for types that need no construction
+    void ResizeUninitialized(size_t count) {
+        static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                      "ResizeUninitialized needs a trivial type, use ResizeDefaultInit");
+        if (this->ShrinkOrReserve(count)) {
+            size_ = count;
+        }
+    }
+
+    // Appends count uninitialized elements and returns a pointer to the first one,
+    // e.g. to read() straight into the vector
+    T* AppendUninitialized(size_t count) {
+        static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                      "AppendUninitialized needs a trivial type");
+        if (size_ + count > cap_) {
+            this->Reserve(NextCapacity(size_ + count));
+        }
+        T* tail = arr_ + size_;
+        size_ += count;
+        return tail;
     }
 
     ~Vector() {
         for (size_t i = 0; i < size_; ++i) {
             AllocTraits::destroy(alloc_, arr_ + i);
         }
-        AllocTraits::deallocate(alloc_, arr_, cap_);
+        DeallocateBuffer(alloc_, arr_, cap_);
     }
 
 private:
+    using AllocTraits = std::allocator_traits<Alloc>;
+
+    // With the default allocator relocatable elements live in malloc'ed memory,
+    // so growth can use realloc (mremap for page-sized buffers on Linux).
+    static constexpr bool kUseRealloc = kIsTriviallyRelocatable<T> && std::is_same_v<Alloc, std::allocator<T>> &&
+                                        alignof(T) <= alignof(std::max_align_t);
+
+    static T* AllocateBuffer(Alloc& alloc, size_t count) {
+        if constexpr (kUseRealloc) {
+            void* ptr = std::malloc(count * sizeof(T));
+            if (ptr == nullptr && count > 0) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(ptr);
+        } else {
+            return AllocTraits::allocate(alloc, count);
+        }
+    }
+
+    static void DeallocateBuffer(Alloc& alloc, T* ptr, size_t count) {
+        if constexpr (kUseRealloc) {
+            std::free(static_cast<void*>(ptr));
+        } else if (ptr != nullptr) {
+            AllocTraits::deallocate(alloc, ptr, count);
+        }
+    }
+
+    // Buffer size for a copy or move of other; nothing is allocated for an empty source
+    static size_t AssignCapacity(const Vector& other) noexcept {
+        return other.size_ > 0 ? std::max(other.cap_, DEFAULT_CAPACITY) : 0;
+    }
+
+    // Destroys the elements past count and returns false, or makes room for count and returns true
+    bool ShrinkOrReserve(size_t count) {
+        if (count <= size_) {
+            for (size_t i = count; i < size_; ++i) {
+                AllocTraits::destroy(alloc_, arr_ + i);
+            }
+            size_ = count;
+            return false;
+        }
+        this->Reserve(count);
+        return true;
+    }
+
+    void DefaultConstructTail(size_t count) {
+        for (; size_ < count; ++size_) {
+            ::new (static_cast<void*>(arr_ + size_)) T;
+        }
+    }
+
+    // Runs construct(i) for every i in [size_, count) in contiguous chunks, one per pool thread.
+    // A failed chunk cleans up after itself, the finished ones are destroyed here, so size_ stays put.
+    // The allocator is shared by all threads.
+    template <class Construct>
+    void ParallelConstructTail(const ParallelTag& par, size_t count, Construct construct) {
+        size_t base = size_;
+        size_t total = count - base;
+        ThreadPool& pool = par.GetPool();
+        size_t min_chunk = std::max<size_t>(1, par.min_chunk_bytes / sizeof(T));
+        size_t chunks = std::min(pool.Workers() + 1, (total + min_chunk - 1) / min_chunk);
+        if (chunks <= 1) {
+            for (; size_ < count; ++size_) {
+                construct(size_);
+            }
+            return;
+        }
+        auto bound = [&](size_t chunk) { return base + total * chunk / chunks; };
+        auto finished = std::make_unique<bool[]>(chunks);
+        try {
+            pool.ParallelFor(chunks, [&](size_t chunk) {
+                size_t i = bound(chunk);
+                try {
+                    for (; i < bound(chunk + 1); ++i) {
+                        construct(i);
+                    }
+                } catch (...) {
+                    for (size_t j = bound(chunk); j < i; ++j) {
+                        AllocTraits::destroy(alloc_, arr_ + j);
+                    }
+                    throw;
+                }
+                finished[chunk] = true;
+            });
+        } catch (...) {
+            for (size_t chunk = 0; chunk < chunks; ++chunk) {
+                for (size_t j = bound(chunk); finished[chunk] && j < bound(chunk + 1); ++j) {
+                    AllocTraits::destroy(alloc_, arr_ + j);
+                }
+            }
+            throw;
+        }
+        size_ = count;
+    }
+
+    size_t NextCapacity(size_t required) const noexcept {
+        return GrowthPolicy::NextCapacity(cap_, required, sizeof(T));
+    }
+
+    void OnNewBuffer() noexcept {
+        if constexpr (requires { GrowthPolicy::OnReserve(static_cast<void*>(arr_), cap_); }) {
+            GrowthPolicy::OnReserve(static_cast<void*>(arr_), cap_ * sizeof(T));
+        }
+    }
+
+    // Opens a gap of count slots at pos, reallocating at most once, and fills it
+    // with construct(dst) called for each slot in order
+    template <class Construct>
+    void InsertWith(size_t pos, size_t count, Construct construct) {
+        if (count == 0) {
+            return;
+        }
+        size_t i = 0;
+        if constexpr (kIsTriviallyRelocatable<T>) {
+            if (size_ + count > cap_ && pos < size_) {
+                // copy both halves straight to their final place instead of reallocating and shifting
+                size_t new_cap = NextCapacity(size_ + count);
+                T* new_arr = AllocateBuffer(alloc_, new_cap);
+                std::memcpy(static_cast<void*>(new_arr), static_cast<const void*>(arr_), pos * sizeof(T));
+                std::memcpy(static_cast<void*>(new_arr + pos + count), static_cast<const void*>(arr_ + pos),
+                            (size_ - pos) * sizeof(T));
+                DeallocateBuffer(alloc_, arr_, cap_);
+                arr_ = new_arr;
+                cap_ = new_cap;
+                this->OnNewBuffer();
+            } else {
+                if (size_ + count > cap_) {
+                    this->Reserve(NextCapacity(size_ + count));
+                }
+                std::memmove(static_cast<void*>(arr_ + pos + count), static_cast<const void*>(arr_ + pos),
+                             (size_ - pos) * sizeof(T));
+            }
+            try {
+                for (; i < count; ++i) {
+                    construct(arr_ + pos + i);
+                }
+            } catch (...) {
+                for (size_t j = 0; j < i; ++j) {
+                    AllocTraits::destroy(alloc_, arr_ + pos + j);
+                }
+                std::memmove(static_cast<void*>(arr_ + pos), static_cast<const void*>(arr_ + pos + count),
+                             (size_ - pos) * sizeof(T));
+                throw;
+            }
+            size_ += count;
+        } else if (size_ + count <= cap_) {
+            try {
+                for (; i < count; ++i) {
+                    construct(arr_ + size_ + i);
+                }
+            } catch (...) {
+                for (size_t j = 0; j < i; ++j) {
+                    AllocTraits::destroy(alloc_, arr_ + size_ + j);
+                }
+                throw;
+            }
+            std::rotate(arr_ + pos, arr_ + size_, arr_ + size_ + count);
+            size_ += count;
+        } else {
+            size_t new_cap = NextCapacity(size_ + count);
+            T* new_arr = AllocateBuffer(alloc_, new_cap);
+            size_t moved = 0;
+            try {
+                for (; i < count; ++i) {
+                    construct(new_arr + pos + i);
+                }
+                for (; moved < size_; ++moved) {
+                    size_t dst = moved < pos ? moved : moved + count;
+                    AllocTraits::construct(alloc_, new_arr + dst, std::move_if_noexcept(arr_[moved]));
+                }
+            } catch (...) {
+                for (size_t j = 0; j < i; ++j) {
+                    AllocTraits::destroy(alloc_, new_arr + pos + j);
+                }
+                for (size_t j = 0; j < moved; ++j) {
+                    AllocTraits::destroy(alloc_, new_arr + (j < pos ? j : j + count));
+                }
+                DeallocateBuffer(alloc_, new_arr, new_cap);
+                throw;
+            }
+            for (size_t j = 0; j < size_; ++j) {
+                AllocTraits::destroy(alloc_, arr_ + j);
+            }
+            DeallocateBuffer(alloc_, arr_, cap_);
+            arr_ = new_arr;
+            cap_ = new_cap;
+            size_ += count;
+            this->OnNewBuffer();
+        }
+    }
+
     T* arr_ = nullptr;
     size_t size_ = 0;
     size_t cap_ = 0;
     Alloc alloc_;
-
-    using AllocTraits = std::allocator_traits<Alloc>;
 };
 
-template <>
-class Vector<void*, std::allocator<void*>> {
+// Packs 64 flags per word, defined in bit_vector.hpp
+template <typename Alloc, typename GrowthPolicy>
+class Vector<bool, Alloc, GrowthPolicy>;
+
+// Vector of raw pointers that owns what they point to, as decided by Ownership
+// (see pointer_ownership.hpp). Plain Vector<void*> frees every element with free().
+template <PointerOwnership Ownership, typename GrowthPolicy>
+class Vector<void*, Ownership, GrowthPolicy> {
+    using Policy = std::conditional_t<std::is_same_v<Ownership, std::allocator<void*>>, FreeOwnership, Ownership>;
+
 public:
     Vector(){};
-    Vector& operator=(const Vector& other) {
-        this->Reserve(other.size_ > DEFAULT_CAPACITY ? other.size_ : DEFAULT_CAPACITY);
-        for (size_t i = 0; i < other.size_; ++i) {
-            arr_[i] = other.arr_[i];
+
+    explicit Vector(Policy owner) : owner_(std::move(owner)) {
+    }
+
+    // Copies would release the same pointers twice, so only non-owning vectors have them
+    Vector(const Vector& other)
+        requires std::is_same_v<Policy, NonOwning>
+        : Vector() {
+        this->Reserve(other.size_);
+        if (other.size_ > 0) {
+            std::memcpy(arr_, other.arr_, other.size_ * sizeof(void*));
+        }
+        size_ = other.size_;
+    }
+
+    Vector& operator=(const Vector& other)
+        requires std::is_same_v<Policy, NonOwning>
+    {
+        if (this != &other) {
+            Vector tmp(other);
+            this->Swap(tmp);
         }
         return *this;
     }
 
-    Vector& operator=(Vector&& other) {
-        cap_ = other.cap_;
-        size_ = other.size_;
-        other.size_ = 0;
-        arr_ = other.arr_;
+    Vector(Vector&& other) noexcept
+        : arr_(std::exchange(other.arr_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          cap_(std::exchange(other.cap_, 0)),
+          owner_(std::move(other.owner_)) {
+    }
+
+    // Releases what this vector owned before taking over other's pointers
+    Vector& operator=(Vector&& other) noexcept {
+        if (this != &other) {
+            Vector tmp(std::move(other));
+            this->Swap(tmp);
+        }
         return *this;
     }
 
+    void Swap(Vector& other) noexcept {
+        std::swap(arr_, other.arr_);
+        std::swap(size_, other.size_);
+        std::swap(cap_, other.cap_);
+        std::swap(owner_, other.owner_);
+    }
+
+    void* operator[](size_t pos) const {
+        return arr_[pos];
+    }
+
     void* Front() const {
         return arr_[0];
     }
@@ -363,50 +797,70 @@ public:
         return arr_[size_ - 1];
     }
 
+    void* const* Data() const noexcept {
+        return arr_;
+    }
+
     size_t Size() const {
         return size_;
     }
 
+    size_t Capacity() const {
+        return cap_;
+    }
+
     bool IsEmpty() const {
         return (size_ == 0);
     }
 
+    Policy& GetOwnership() noexcept {
+        return owner_;
+    }
+
     void Reserve(size_t new_cap) {
         if (new_cap <= cap_) {
             return;
         }
-        void** new_arr = reinterpret_cast<void**>(malloc(new_cap * sizeof(void*)));
-        for (size_t i = 0; i < size_; ++i) {
-            new (new_arr + i) void*(arr_[i]);
+        void** new_arr = static_cast<void**>(std::realloc(static_cast<void*>(arr_), new_cap * sizeof(void*)));
+        if (new_arr == nullptr) {
+            throw std::bad_alloc();
         }
-        free(arr_);
-        cap_ = new_cap;
         arr_ = new_arr;
+        cap_ = new_cap;
     }
 
+    // Hands every pointer to the ownership policy in one call
     void Clear() noexcept {
         if (size_ == 0) {
             return;
         }
-        for (size_t i = 0; i < size_; ++i) {
-            if (arr_[i]) {
-                free(arr_[i]);
-            }
-        }
+        owner_.Release(arr_, size_);
         size_ = 0;
     }
 
     void PushBack(void* ptr) {
         if (size_ == cap_) {
-            this->Reserve(cap_ > 0 ? cap_ * 2 : DEFAULT_CAPACITY);
+            this->Reserve(GrowthPolicy::NextCapacity(cap_, size_ + 1, sizeof(void*)));
         }
         arr_[size_] = ptr;
         ++size_;
     }
 
+    // Allocates bytes from the policy (e.g. the arena) and stores the pointer
+    void* AllocateBack(size_t bytes, size_t align = alignof(std::max_align_t))
+        requires requires(Policy& owner, size_t n) { owner.Allocate(n, n); }
+    {
+        if (size_ == cap_) {
+            this->Reserve(GrowthPolicy::NextCapacity(cap_, size_ + 1, sizeof(void*)));
+        }
+        void* ptr = owner_.Allocate(bytes, align);
+        arr_[size_++] = ptr;
+        return ptr;
+    }
+
     ~Vector() noexcept {
         Clear();
-        free(arr_);
+        std::free(static_cast<void*>(arr_));
         arr_ = nullptr;
     }
 
@@ -414,4 +868,5 @@ private:
     void** arr_ = nullptr;
     size_t size_ = 0;
     size_t cap_ = 0;
+    Policy owner_;
 };